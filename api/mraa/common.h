@@ -79,6 +79,39 @@ extern "C" {
  */
 typedef unsigned int mraa_boolean_t;
 
+/** Number of mraa_bus_priority_t classes */
+#define MRAA_BUS_PRIORITY_COUNT 3
+
+/**
+ * Wait statistics of a shared i2c or spi bus, indexed by mraa_bus_priority_t
+ */
+typedef struct {
+    uint64_t transfers[MRAA_BUS_PRIORITY_COUNT]; /**< number of times the bus was granted */
+    uint64_t contended[MRAA_BUS_PRIORITY_COUNT]; /**< grants which had to wait */
+    uint64_t wait_ns[MRAA_BUS_PRIORITY_COUNT];   /**< total time spent waiting */
+    uint64_t max_wait_ns[MRAA_BUS_PRIORITY_COUNT]; /**< longest single wait */
+} mraa_bus_stats_t;
+
+/**
+ * Counts of the ioctls a bus context made on its device and of those it
+ * could skip because the device was already set up as requested
+ */
+typedef struct {
+    uint64_t issued;  /**< ioctls made */
+    uint64_t avoided; /**< ioctls found redundant and skipped */
+} mraa_bus_ioctl_stats_t;
+
+/**
+ * Handle of an asynchronous i2c or spi request
+ */
+typedef struct _bus_async* mraa_bus_async_t;
+
+/**
+ * Completion callback of an asynchronous request, called from the worker
+ * thread of the bus with the result of the transfer
+ */
+typedef void (*mraa_bus_async_cb_t)(mraa_result_t status, void* args);
+
 /**
  * Initialise MRAA
  *
@@ -86,23 +119,25 @@ typedef unsigned int mraa_boolean_t;
  * module/library init/load but is handy to rerun to check board initialised
  * correctly. MRAA_SUCCESS inidicates correct initialisation.
  *
+ * The init on library load is skipped when the MRAA_NO_AUTO_INIT environment
+ * variable is set to anything but 0, for short lived processes which may not
+ * touch any IO. The platform is then detected by the first call to this
+ * function, to an io *_init() function, a *_lookup() function or to any
+ * function describing the platform (name, type, pin and bus counts, pin
+ * names and modes, ...). IIO devices are always scanned on first use.
+ *
  * @return Result of operation
  */
-#if (defined SWIGPYTHON) || (defined SWIG)
 mraa_result_t mraa_init();
-#else
-// this sets a compiler attribute (supported by GCC & clang) to have mraa_init()
-// be called as a constructor make sure your libc supports this!  uclibc needs
-// to be compiled with UCLIBC_CTOR_DTOR
-mraa_result_t mraa_init() __attribute__((constructor));
-#endif
 
 /**
  * De-Initilise MRAA
  *
  * This is not a strict requirement but useful to test memory leaks and for
  * people who like super clean code. If dynamically loading & unloading
- * libmraa you need to call this before unloading the library.
+ * libmraa you need to call this before unloading the library. The worker
+ * threads of asynchronous i2c/spi requests are joined once their queued
+ * requests ran.
  */
 void mraa_deinit() __attribute__((destructor));
 
@@ -295,7 +330,9 @@ unsigned int mraa_get_platform_pin_count(uint8_t platform_offset);
 char* mraa_get_pin_name(int pin);
 
 /**
-* Get GPIO index by pin name, board must be initialised.
+* Get GPIO index by pin name, board must be initialised. Names of the main
+* platform take precedence, a name only found on the sub platform is returned
+* as a sub platform id. The same applies to the other *_lookup() functions.
 *
 * @param pin_name: GPIO pin name. Eg: IO0
 * @return int of MRAA index for GPIO or -1 if not found.
@@ -418,6 +455,30 @@ void* mraa_init_io(const char* desc);
  */
 mraa_result_t mraa_init_json_platform(const char* path);
 
+/**
+ * Check whether an asynchronous i2c or spi request has completed, without
+ * blocking
+ *
+ * @param handle Handle returned when the request was submitted
+ * @return 1 once the request completed, 0 otherwise
+ */
+mraa_boolean_t mraa_bus_async_done(mraa_bus_async_t handle);
+
+/**
+ * Wait for an asynchronous i2c or spi request to complete and release its
+ * handle, which must not be used afterwards. The completion callback, if
+ * any, has returned when this returns. A request left to run can't get the
+ * bus while the calling thread holds it through mraa_i2c_bus_acquire() or
+ * mraa_spi_bus_acquire(), so the wait is then refused and the handle stays
+ * valid. The same applies to the futures of the C++ API, whose get() would
+ * block forever.
+ *
+ * @param handle Handle returned when the request was submitted
+ * @return Result of the transfer, MRAA_ERROR_INVALID_RESOURCE if the
+ * calling thread holds the bus and the request hasn't completed
+ */
+mraa_result_t mraa_bus_async_wait(mraa_bus_async_t handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -118,6 +118,16 @@ typedef struct {
 
 typedef mraa_gpio_event* mraa_gpio_events_t;
 
+/**
+ * Gpio edge event, as stored in the event queue of a context
+ */
+typedef struct {
+    int pin; /**< pin number, as given to the init function */
+    mraa_gpio_edge_t edge; /**< MRAA_GPIO_EDGE_RISING or MRAA_GPIO_EDGE_FALLING */
+    mraa_timestamp_t timestamp; /**< CLOCK_MONOTONIC timestamp in nanoseconds */
+    unsigned int seqno; /**< sequence number, gaps indicate dropped events */
+} mraa_gpio_edge_event;
+
 /**
  * Initialise gpio_context, based on board number
  *
@@ -183,6 +193,101 @@ mraa_result_t mraa_gpio_isr(mraa_gpio_context dev, mraa_gpio_edge_t edge, void (
  */
 mraa_gpio_events_t mraa_gpio_get_events(mraa_gpio_context dev);
 
+/**
+ * Serve the interrupts of all contexts from a pool of shared threads instead
+ * of starting one thread per mraa_gpio_isr() call. Each context is assigned
+ * to the least loaded thread, which waits on the fds of all its contexts with
+ * epoll. Only affects isrs set after the call, mraa_gpio_isr_exit() keeps its
+ * semantics: once it returns the callback is not running anymore. The shared
+ * threads report edges through the event queue only: contexts without one get
+ * a queue of 64 events, read with mraa_gpio_event_queue_pop(), and
+ * mraa_gpio_get_events() reports no event for them.
+ *
+ * @param num_threads Number of shared threads, 0 restores one thread per isr
+ * @return Result of operation, MRAA_ERROR_NO_RESOURCES if isrs are still
+ * registered on the current threads
+ */
+mraa_result_t mraa_gpio_use_isr_dispatcher(unsigned int num_threads);
+
+/**
+ * Queue edge events instead of only reporting the last one. Must be called
+ * before mraa_gpio_isr(). With the chardev interface the events are
+ * timestamped by the kernel and buffered there until the interrupt thread
+ * drains them, so bursts shorter than the callback latency are not lost.
+ *
+ * @param dev The Gpio context
+ * @param size Number of events the queue can hold
+ * @return Result of operation
+ */
+mraa_result_t mraa_gpio_event_queue_init(mraa_gpio_context dev, unsigned int size);
+
+/**
+ * Pop the oldest events from the event queue of a context.
+ *
+ * @param dev The Gpio context
+ * @param events Array receiving the events, oldest first
+ * @param max Length of the events array
+ * @return Number of events copied, or -1 if the context has no event queue
+ */
+int mraa_gpio_event_queue_pop(mraa_gpio_context dev, mraa_gpio_edge_event* events, unsigned int max);
+
+/**
+ * Get the number of events lost since the event queue was created, either
+ * because the queue was full or because the kernel buffer overflowed.
+ *
+ * @param dev The Gpio context
+ * @return Number of dropped events
+ */
+unsigned long mraa_gpio_event_queue_dropped(mraa_gpio_context dev);
+
+/**
+ * Get the file descriptors signalling edges on the Gpio(s) of a context, to
+ * wait on them from an external event loop instead of using mraa_gpio_isr().
+ * The edge mode must be set first with mraa_gpio_edge_mode(). The fds are
+ * non-blocking, stay owned by the context and are closed by mraa_gpio_close(),
+ * or by mraa_gpio_isr_exit() if an isr was set on the context afterwards.
+ * Pending events are then fetched with mraa_gpio_read_events().
+ *
+ * @param dev The Gpio context
+ * @param fds Array receiving the fds, in the same order as the init function
+ * @param max Length of the fds array, at least the number of pins
+ * @param poll_events If not NULL, receives the poll() events to wait for:
+ * POLLIN with the chardev interface, POLLPRI with sysfs
+ * @return Number of fds, or -1 on error or if an isr is set on the context
+ */
+int mraa_gpio_get_event_fds(mraa_gpio_context dev, int fds[], unsigned int max, short* poll_events);
+
+/**
+ * Decode the pending edge events of a context without blocking. With the
+ * chardev interface every event buffered by the kernel is returned with its
+ * kernel timestamp. sysfs only reports that an edge happened since the last
+ * call, its timestamp is taken at read time and its edge derived from the
+ * current value.
+ *
+ * @param dev The Gpio context
+ * @param events Array receiving the events
+ * @param max Length of the events array
+ * @return Number of events decoded, 0 if none is pending, -1 on error or if
+ * an isr is set on the context
+ */
+int mraa_gpio_read_events(mraa_gpio_context dev, mraa_gpio_edge_event* events, unsigned int max);
+
+/**
+ * Drop the cached list of gpiochips and line names used by the chardev
+ * interface, e.g. by mraa_gpio_init_by_name(). The cache is built on first
+ * use; invalidate it when gpiochips are added or removed at runtime.
+ */
+void mraa_gpio_invalidate_chip_cache();
+
+/**
+ * Rescan the gpiochips and the names of all their lines now, so that later
+ * lookups are served from memory.
+ *
+ * @return Result of operation, MRAA_ERROR_NO_DATA_AVAILABLE if no gpiochip
+ * was found
+ */
+mraa_result_t mraa_gpio_refresh_chip_cache();
+
 /**
  * Stop the current interrupt watcher on this Gpio, and set the Gpio edge mode
  * to MRAA_GPIO_EDGE_NONE(only for sysfs interface).
@@ -268,6 +373,22 @@ mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value);
  */
 mraa_result_t mraa_gpio_write_multi(mraa_gpio_context dev, int input_values[]);
 
+/**
+ * Write to a subset of the Gpio(s) of a context. Only the pins whose entry in
+ * write_mask is non-zero are updated, the others keep their current level. With
+ * the chardev interface on a kernel providing the GPIO v2 ABI this costs a single
+ * ioctl per gpio chip, without a read-modify-write cycle. The v1 ABI can only
+ * set all the lines of a chip at once, so unless every pin of the chip is
+ * selected their levels are read back and written again unchanged: an extra
+ * ioctl, and a level changed by another process in between is overwritten.
+ *
+ * @param dev The Gpio context
+ * @param input_values Values to write, in the same order as the init function
+ * @param write_mask Array of the same length, non-zero entries select the pins to write
+ * @return Result of operation
+ */
+mraa_result_t mraa_gpio_write_multi_masked(mraa_gpio_context dev, int input_values[], int write_mask[]);
+
 /**
  * Change ownership of the context.
  *
@@ -279,7 +400,9 @@ mraa_result_t mraa_gpio_owner(mraa_gpio_context dev, mraa_boolean_t owner);
 
 /**
  * Enable using memory mapped io instead of sysfs, chardev based I/O can be
- * considered memorymapped
+ * considered memorymapped. Available on boards with a dedicated implementation
+ * and on boards describing their GPIO controller registers, including json
+ * platforms.
  *
  * @deprecated
  * @param dev The Gpio context
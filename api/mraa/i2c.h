@@ -123,9 +123,49 @@ int mraa_i2c_read_word_data(mraa_i2c_context dev, const uint8_t command);
  * @param data pointer to the byte array to read data in to
  * @param length max number of bytes to read
  * @return The length in bytes passed to the function or -1
+ *
+ * On SMBus-only adapters the bytes are read 32 at a time with
+ * I2C_SMBUS_I2C_BLOCK_DATA, which relies on the device auto-incrementing
+ * its register pointer.
  */
 int mraa_i2c_read_bytes_data(mraa_i2c_context dev, uint8_t command, uint8_t* data, int length);
 
+/**
+ * SMBus block read: the device sends the byte count, then up to 32 bytes.
+ * Uses I2C_SMBUS_BLOCK_DATA, PEC is checked when enabled.
+ *
+ * @param dev The i2c context
+ * @param command The register
+ * @param data Buffer of at least 32 bytes to read data in to
+ * @return The number of bytes read or -1, also when the adapter can't do
+ * SMBus block reads
+ */
+int mraa_i2c_read_block_data(mraa_i2c_context dev, uint8_t command, uint8_t* data);
+
+/**
+ * SMBus block write: the register, the byte count and the bytes. Uses
+ * I2C_SMBUS_BLOCK_DATA, with a PEC byte appended when enabled.
+ *
+ * @param dev The i2c context
+ * @param command The register
+ * @param data The bytes to write
+ * @param length Number of bytes to write, at most 32
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_write_block_data(mraa_i2c_context dev, uint8_t command, const uint8_t* data, int length);
+
+/**
+ * Enable or disable SMBus Packet Error Checking on the SMBus transfers of
+ * this context. A bad checksum makes the transfer fail. Plain i2c
+ * transfers (mraa_i2c_read(), I2C_RDWR based calls) are never checked.
+ *
+ * @param dev The i2c context
+ * @param enable 1 to append and check a PEC byte, 0 not to
+ * @return Result of operation, MRAA_ERROR_FEATURE_NOT_SUPPORTED if the
+ * adapter can't do PEC
+ */
+mraa_result_t mraa_i2c_set_pec(mraa_i2c_context dev, mraa_boolean_t enable);
+
 /**
  * Write length bytes to the bus, the first byte in the array is the
  * command/register to write
@@ -176,7 +216,429 @@ mraa_result_t mraa_i2c_write_word_data(mraa_i2c_context dev, const uint16_t data
 mraa_result_t mraa_i2c_address(mraa_i2c_context dev, uint8_t address);
 
 /**
- * De-inits an mraa_i2c_context device
+ * Read length bytes from the slave at address. The address travels with the
+ * message (I2C_RDWR), the address set with mraa_i2c_address() is neither
+ * used nor changed, so one context can serve several slaves from several
+ * threads without extra syscalls. Platforms without I2C_RDWR switch the
+ * context address for the duration of the call and restore it.
+ *
+ * @param dev The i2c context
+ * @param address Slave address (7-bit address)
+ * @param data Buffer to read into
+ * @param length Number of bytes to read, at most 8192
+ * @return length if the read was successful or -1 if it failed
+ */
+int mraa_i2c_read_from(mraa_i2c_context dev, uint8_t address, uint8_t* data, int length);
+
+/**
+ * Read a register from the slave at address without changing the context
+ * address, see mraa_i2c_read_from()
+ *
+ * @param dev The i2c context
+ * @param address Slave address (7-bit address)
+ * @param command The register
+ * @return The register value or -1 if it failed
+ */
+int mraa_i2c_read_byte_data_from(mraa_i2c_context dev, uint8_t address, uint8_t command);
+
+/**
+ * Read length bytes starting at a register from the slave at address
+ * without changing the context address, see mraa_i2c_read_from()
+ *
+ * @param dev The i2c context
+ * @param address Slave address (7-bit address)
+ * @param command The register
+ * @param data Buffer to read into
+ * @param length Number of bytes to read, at most 8192
+ * @return length if the read was successful or -1 if it failed
+ */
+int mraa_i2c_read_bytes_data_from(mraa_i2c_context dev, uint8_t address, uint8_t command, uint8_t* data, int length);
+
+/**
+ * Write length bytes to the slave at address without changing the context
+ * address, see mraa_i2c_read_from()
+ *
+ * @param dev The i2c context
+ * @param address Slave address (7-bit address)
+ * @param data The bytes to write
+ * @param length Number of bytes to write, at most 8192
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_write_to(mraa_i2c_context dev, uint8_t address, const uint8_t* data, int length);
+
+/**
+ * Write a byte to a register of the slave at address without changing the
+ * context address, see mraa_i2c_read_from()
+ *
+ * @param dev The i2c context
+ * @param address Slave address (7-bit address)
+ * @param data The byte to write
+ * @param command The register
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_write_byte_data_to(mraa_i2c_context dev, uint8_t address, const uint8_t data, const uint8_t command);
+
+/**
+ * Set the priority class of the transfers made on this context. All the
+ * contexts of a bus in the process share one arbiter: each transfer waits
+ * for the bus, waiting transfers of a higher class go first and the others
+ * go in arrival order. Contexts start as MRAA_BUS_PRIORITY_NORMAL.
+ *
+ * @param dev The i2c context
+ * @param priority The priority class
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_set_priority(mraa_i2c_context dev, mraa_bus_priority_t priority);
+
+/**
+ * Hold the bus for the calling thread, so a sequence of transfers (e.g.
+ * mraa_i2c_address() then mraa_i2c_read()) isn't interleaved with other
+ * contexts of the bus. Transfers of the holding thread don't wait. Calls
+ * nest and must be matched by mraa_i2c_bus_release().
+ *
+ * @param dev The i2c context
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_bus_acquire(mraa_i2c_context dev);
+
+/**
+ * Give back the bus held with mraa_i2c_bus_acquire()
+ *
+ * @param dev The i2c context
+ * @return Result of operation, MRAA_ERROR_INVALID_RESOURCE if the calling
+ * thread doesn't hold the bus
+ */
+mraa_result_t mraa_i2c_bus_release(mraa_i2c_context dev);
+
+/**
+ * Get the wait statistics of the bus of this context, shared by all the
+ * contexts of the bus in the process
+ *
+ * @param dev The i2c context
+ * @param stats Filled with the statistics since the bus was first used
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_bus_stats(mraa_i2c_context dev, mraa_bus_stats_t* stats);
+
+/**
+ * Set how long the adapter waits for a transfer before giving up. The
+ * kernel keeps this per adapter, so it applies to every user of the bus,
+ * and rounds it up to 10 ms steps.
+ *
+ * @param dev The i2c context
+ * @param timeout_ms Timeout in milliseconds
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_set_timeout(mraa_i2c_context dev, unsigned int timeout_ms);
+
+/**
+ * Set how many times the adapter retries a transfer the slave didn't
+ * acknowledge. Per adapter, as mraa_i2c_set_timeout().
+ *
+ * @param dev The i2c context
+ * @param retries Number of retries
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_set_retries(mraa_i2c_context dev, unsigned int retries);
+
+/**
+ * Configure the circuit breaker of this context. After max_failures
+ * transfers failed in a row, transfers fail at once with errno EAGAIN,
+ * without touching the bus, for cooldown_ms. A single transfer is then let
+ * through: the breaker closes if it succeeds and opens again otherwise.
+ * Only the first failure of a streak is logged. Platforms which replace
+ * the i2c functions aren't covered.
+ *
+ * @param dev The i2c context
+ * @param max_failures Failures in a row opening the breaker, 0 disables it
+ * @param cooldown_ms How long transfers fail fast once it opened
+ * @param recover 1 to run mraa_i2c_recover() every time it opens
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_set_breaker(mraa_i2c_context dev, unsigned int max_failures, unsigned int cooldown_ms, mraa_boolean_t recover);
+
+/**
+ * Free a bus whose sda line is held low by a slave stuck in the middle of
+ * a byte: the scl pin is taken over as a gpio and clocked up to 9 times
+ * until sda is released, then a stop condition is sent and the pins are
+ * muxed back to i2c. Needs the bus pins of the board mapping to be usable
+ * as gpios, on other boards rely on the recovery of the kernel driver.
+ *
+ * @param dev The i2c context
+ * @return Result of operation, MRAA_ERROR_UNSPECIFIED if sda is still low
+ * afterwards and MRAA_ERROR_FEATURE_NOT_SUPPORTED if the pins can't be
+ * driven
+ */
+mraa_result_t mraa_i2c_recover(mraa_i2c_context dev);
+
+/**
+ * Get the ioctl counters of this context. Setting the address the device
+ * file already targets, or the PEC state it already has, costs no ioctl.
+ *
+ * @param dev The i2c context
+ * @param stats Filled with the counts since the context was created
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_ioctl_stats(mraa_i2c_context dev, mraa_bus_ioctl_stats_t* stats);
+
+/** First address probed by a scan, lower ones are reserved */
+#define MRAA_I2C_SCAN_FIRST 0x03
+/** Last address probed by a scan, higher ones are reserved */
+#define MRAA_I2C_SCAN_LAST 0x77
+
+/**
+ * State of an address after a scan
+ */
+typedef enum {
+    MRAA_I2C_SCAN_ABSENT = 0,  /**< nothing answered */
+    MRAA_I2C_SCAN_PRESENT = 1, /**< a device answered */
+    MRAA_I2C_SCAN_BUSY = 2,    /**< claimed by a kernel driver, not probed */
+    MRAA_I2C_SCAN_SKIPPED = 3  /**< not probed: reserved address or the scan timed out */
+} mraa_i2c_scan_state_t;
+
+/**
+ * Result of scanning one bus
+ */
+typedef struct {
+    int bus;                /**< bus as passed to mraa_i2c_init() */
+    mraa_result_t status;   /**< MRAA_SUCCESS when every address was probed */
+    int num_found;          /**< number of MRAA_I2C_SCAN_PRESENT addresses */
+    uint8_t state[128];     /**< mraa_i2c_scan_state_t of each 7-bit address */
+} mraa_i2c_scan_result_t;
+
+/**
+ * Probe the addresses MRAA_I2C_SCAN_FIRST to MRAA_I2C_SCAN_LAST of a bus.
+ * Like i2cdetect, 0x30-0x37 and 0x50-0x5F are probed with a read byte and
+ * the other addresses with a quick write, when the adapter supports it.
+ * Addresses claimed by a kernel driver are reported busy.
+ *
+ * Each probe holds the bus like mraa_i2c_bus_acquire(). A probe given up on
+ * keeps running on its own thread: until it returns, the bus stays held and
+ * the transfers of the other contexts of the process on that bus wait.
+ *
+ * @param bus The bus, as passed to mraa_i2c_init()
+ * @param timeout_ms Give up on the bus when a single probe takes longer,
+ * 0 to wait forever
+ * @param result Filled with the state of every address
+ * @return Result of operation, MRAA_ERROR_UNSPECIFIED if the scan timed out
+ * (the addresses probed so far are still reported)
+ */
+mraa_result_t mraa_i2c_scan(int bus, unsigned int timeout_ms, mraa_i2c_scan_result_t* result);
+
+/**
+ * Scan all the i2c buses of the platform and its sub platform at the same
+ * time, one thread per bus. See mraa_i2c_scan().
+ *
+ * @param timeout_ms Give up on a bus when a single probe takes longer, 0 to
+ * wait forever
+ * @param results Filled with one result per bus
+ * @param max_results Number of entries in results
+ * @return Number of results filled or -1 if it failed
+ */
+int mraa_i2c_scan_all(unsigned int timeout_ms, mraa_i2c_scan_result_t* results, int max_results);
+
+/**
+ * Attach a cache of the byte registers 0 to num_regs - 1 of the slave the
+ * context is addressing. Cached registers are read from the device once,
+ * writes only update the cache until mraa_i2c_regcache_sync(). Volatile
+ * registers (status, data, ...) always go to the device. An existing cache
+ * is replaced, the cache is freed by mraa_i2c_stop().
+ *
+ * @param dev The i2c context
+ * @param num_regs Number of registers covered, at most 256
+ * @param volatile_regs Registers which must not be cached, may be NULL
+ * @param num_volatile Number of entries in volatile_regs
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_regcache_init(mraa_i2c_context dev, unsigned int num_regs, const uint8_t* volatile_regs, int num_volatile);
+
+/**
+ * Read a register through the cache, registers outside of the cache are
+ * read from the device
+ *
+ * @param dev The i2c context
+ * @param reg The register
+ * @return The register value or -1 if it failed
+ */
+int mraa_i2c_regcache_read(mraa_i2c_context dev, uint8_t reg);
+
+/**
+ * Write a register through the cache. Cached registers are marked dirty and
+ * written by mraa_i2c_regcache_sync(), writing the value they already hold
+ * is a no-op. Volatile registers are written immediately.
+ *
+ * @param dev The i2c context
+ * @param reg The register
+ * @param value The value to write
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_regcache_write(mraa_i2c_context dev, uint8_t reg, uint8_t value);
+
+/**
+ * Replace the bits of mask in a register by the ones of value, through the
+ * cache
+ *
+ * @param dev The i2c context
+ * @param reg The register
+ * @param mask The bits to change
+ * @param value The new value of these bits
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_regcache_update_bits(mraa_i2c_context dev, uint8_t reg, uint8_t mask, uint8_t value);
+
+/**
+ * Write the dirty registers back to the device. Each run of contiguous
+ * dirty registers is sent as one mraa_i2c_write() of the first register
+ * followed by the values (up to 32 values per write), which relies on the
+ * device auto-incrementing its register pointer.
+ *
+ * @param dev The i2c context
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_regcache_sync(mraa_i2c_context dev);
+
+/**
+ * Forget the cached values and the pending writes, e.g. after resetting
+ * the device
+ *
+ * @param dev The i2c context
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_regcache_invalidate(mraa_i2c_context dev);
+
+/**
+ * Detach and free the register cache, pending writes are dropped
+ *
+ * @param dev The i2c context
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_regcache_close(mraa_i2c_context dev);
+
+/**
+ * Opaque pointer definition to the internal struct _i2c_txn
+ */
+typedef struct _i2c_txn* mraa_i2c_txn;
+
+/**
+ * Create an empty transaction on an i2c context. Messages queued on it are
+ * submitted together by mraa_i2c_txn_submit(), in a single I2C_RDWR ioctl
+ * where messages are separated by repeated starts and only the last one
+ * ends with a stop. The transaction can be submitted any number of times
+ * and must be freed with mraa_i2c_txn_close() before the context is stopped.
+ *
+ * @param dev The i2c context
+ * @return transaction or NULL
+ */
+mraa_i2c_txn mraa_i2c_txn_init(mraa_i2c_context dev);
+
+/**
+ * Queue a write of raw bytes, the bytes are copied
+ *
+ * @param txn The transaction
+ * @param address Slave address of this message (7-bit address)
+ * @param data The bytes to write
+ * @param length Number of bytes to write, at most 8192
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_write(mraa_i2c_txn txn, uint8_t address, const uint8_t* data, int length);
+
+/**
+ * Queue a write of a single byte to a register
+ *
+ * @param txn The transaction
+ * @param address Slave address of this message (7-bit address)
+ * @param data The byte to write
+ * @param command The register
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_write_byte_data(mraa_i2c_txn txn, uint8_t address, const uint8_t data, const uint8_t command);
+
+/**
+ * Queue a read. data must stay valid until the transaction is submitted
+ * and is filled by mraa_i2c_txn_submit().
+ *
+ * @param txn The transaction
+ * @param address Slave address of this message (7-bit address)
+ * @param data Buffer to read into
+ * @param length Number of bytes to read, at most 8192
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_read(mraa_i2c_txn txn, uint8_t address, uint8_t* data, int length);
+
+/**
+ * Queue a read of length bytes starting at a register: a write of the
+ * register followed by a read after a repeated start.
+ *
+ * @param txn The transaction
+ * @param address Slave address of this message (7-bit address)
+ * @param command The register
+ * @param data Buffer to read into, filled by mraa_i2c_txn_submit()
+ * @param length Number of bytes to read, at most 8192
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_read_bytes_data(mraa_i2c_txn txn, uint8_t address, uint8_t command, uint8_t* data, int length);
+
+/**
+ * Submit the queued messages. More than 42 messages (the kernel limit of a
+ * single I2C_RDWR) are sent as several ioctls, with a stop in between.
+ * Platforms which replace the i2c read/write functions run the messages
+ * one by one through them, each ending with a stop; the context address is
+ * restored afterwards.
+ *
+ * @param txn The transaction
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_submit(mraa_i2c_txn txn);
+
+/**
+ * Submit the queued messages on the worker thread of the bus and return
+ * without waiting. Requests of a bus run one after the other in submission
+ * order, each under the priority class of its context. The transaction and
+ * the read buffers must stay untouched until the request completed.
+ * mraa_i2c_stop() completes the requests of the context still queued with
+ * MRAA_ERROR_INVALID_RESOURCE and waits for the one running, so a context
+ * may be stopped with requests pending but its transactions must not be
+ * closed before that. The worker needs the bus: don't wait for a request
+ * while holding the bus with mraa_i2c_bus_acquire(), see
+ * mraa_bus_async_wait().
+ *
+ * @param txn The transaction
+ * @param cb Function called from the worker thread with the result, may be NULL
+ * @param args Argument passed to cb
+ * @param handle Set to a handle for mraa_bus_async_wait(), which must then be
+ * called. If NULL the request is released once it completed.
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_submit_async(mraa_i2c_txn txn, mraa_bus_async_cb_t cb, void* args, mraa_bus_async_t* handle);
+
+#if defined(SWIGPYTHON)
+/**
+ * mraa_i2c_txn_submit_async() for the Python module: cb is a callable and
+ * args its argument, both referenced by the caller and released once cb ran
+ */
+mraa_result_t mraa_i2c_txn_submit_async_python(mraa_i2c_txn txn, void* cb, void* args);
+#endif
+
+/**
+ * Drop all the queued messages so the transaction can be reused
+ *
+ * @param txn The transaction
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_reset(mraa_i2c_txn txn);
+
+/**
+ * Free a transaction
+ *
+ * @param txn The transaction
+ * @return Result of operation
+ */
+mraa_result_t mraa_i2c_txn_close(mraa_i2c_txn txn);
+
+/**
+ * De-inits an mraa_i2c_context device. Asynchronous requests of the context
+ * still queued complete with MRAA_ERROR_INVALID_RESOURCE, a running one is
+ * waited for.
  *
  * @param dev The i2c context
  * @return Result of operation
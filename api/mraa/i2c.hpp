@@ -29,6 +29,9 @@
 #include "i2c.h"
 #include "types.hpp"
 #include <stdexcept>
+#ifndef SWIG
+#include <future>
+#endif
 
 namespace mraa
 {
@@ -206,6 +209,19 @@ class I2c
         return mraa_i2c_read_bytes_data(m_i2c, reg, data, length);
     }
 
+    /**
+     * SMBus block read, the device sends the byte count
+     *
+     * @param reg Register to read from
+     * @param data pointer to a byte array of at least 32 bytes
+     * @return number of bytes read or -1
+     */
+    int
+    readBlockReg(uint8_t reg, uint8_t* data)
+    {
+        return mraa_i2c_read_block_data(m_i2c, reg, data);
+    }
+
     /**
      * Write a byte on the bus
      *
@@ -258,6 +274,485 @@ class I2c
         return (Result) mraa_i2c_write_word_data(m_i2c, data, reg);
     }
 
+    /**
+     * SMBus block write, the byte count is sent before the bytes
+     *
+     * @param reg Register to write to
+     * @param data Bytes to write
+     * @param length Number of bytes, at most 32
+     * @return Result of operation
+     */
+    Result
+    writeBlockReg(uint8_t reg, const uint8_t* data, int length)
+    {
+        return (Result) mraa_i2c_write_block_data(m_i2c, reg, data, length);
+    }
+
+    /**
+     * Enable or disable SMBus Packet Error Checking
+     *
+     * @param enable true to append and check a PEC byte
+     * @return Result of operation
+     */
+    Result
+    setPec(bool enable)
+    {
+        return (Result) mraa_i2c_set_pec(m_i2c, enable ? 1 : 0);
+    }
+
+    /**
+     * Read length bytes from the slave at address, the address set with
+     * address() is neither used nor changed
+     *
+     * @param address Slave address
+     * @param data Data to read into
+     * @param length Size of read in bytes to make
+     * @return length of read or -1
+     */
+    int
+    readFrom(uint8_t address, uint8_t* data, int length)
+    {
+        return mraa_i2c_read_from(m_i2c, address, data, length);
+    }
+
+    /**
+     * Read byte from a register of the slave at address
+     *
+     * @param address Slave address
+     * @param reg Register to read from
+     *
+     * @throws std::invalid_argument in case of error
+     * @return char read from register
+     */
+    uint8_t
+    readRegFrom(uint8_t address, uint8_t reg)
+    {
+        int x = mraa_i2c_read_byte_data_from(m_i2c, address, reg);
+        if (x == -1) {
+            throw std::invalid_argument("Unknown error in I2c::readRegFrom()");
+        }
+        return (uint8_t) x;
+    }
+
+    /**
+     * Read length bytes starting from a register of the slave at address
+     *
+     * @param address Slave address
+     * @param reg Register to read from
+     * @param data pointer to the byte array to read data in to
+     * @param length number of bytes to read
+     * @return length passed to the function or -1
+     */
+    int
+    readBytesRegFrom(uint8_t address, uint8_t reg, uint8_t* data, int length)
+    {
+        return mraa_i2c_read_bytes_data_from(m_i2c, address, reg, data, length);
+    }
+
+    /**
+     * Write length bytes to the slave at address
+     *
+     * @param address Slave address
+     * @param data Buffer to send
+     * @param length Size of buffer to send
+     * @return Result of operation
+     */
+    Result
+    writeTo(uint8_t address, const uint8_t* data, int length)
+    {
+        return (Result) mraa_i2c_write_to(m_i2c, address, data, length);
+    }
+
+    /**
+     * Write a byte to a register of the slave at address
+     *
+     * @param address Slave address
+     * @param reg Register to write to
+     * @param data Value to write to register
+     * @return Result of operation
+     */
+    Result
+    writeRegTo(uint8_t address, uint8_t reg, uint8_t data)
+    {
+        return (Result) mraa_i2c_write_byte_data_to(m_i2c, address, data, reg);
+    }
+
+    /**
+     * Set the priority class of the transfers made through this object
+     *
+     * @param priority The priority class
+     * @return Result of operation
+     */
+    Result
+    setPriority(BusPriority priority)
+    {
+        return (Result) mraa_i2c_set_priority(m_i2c, (mraa_bus_priority_t) priority);
+    }
+
+    /**
+     * Hold the bus for the calling thread until busRelease()
+     *
+     * @return Result of operation
+     */
+    Result
+    busAcquire()
+    {
+        return (Result) mraa_i2c_bus_acquire(m_i2c);
+    }
+
+    /**
+     * Give back the bus held with busAcquire()
+     *
+     * @return Result of operation
+     */
+    Result
+    busRelease()
+    {
+        return (Result) mraa_i2c_bus_release(m_i2c);
+    }
+
+    /**
+     * Get the wait statistics of the bus
+     *
+     * @param stats Filled with the statistics
+     * @return Result of operation
+     */
+    Result
+    busStats(mraa_bus_stats_t& stats)
+    {
+        return (Result) mraa_i2c_bus_stats(m_i2c, &stats);
+    }
+
+    /**
+     * Set the adapter timeout, see mraa_i2c_set_timeout()
+     *
+     * @param timeoutMs Timeout in milliseconds
+     * @return Result of operation
+     */
+    Result
+    setTimeout(unsigned int timeoutMs)
+    {
+        return (Result) mraa_i2c_set_timeout(m_i2c, timeoutMs);
+    }
+
+    /**
+     * Set the adapter retry count, see mraa_i2c_set_retries()
+     *
+     * @param retries Number of retries
+     * @return Result of operation
+     */
+    Result
+    setRetries(unsigned int retries)
+    {
+        return (Result) mraa_i2c_set_retries(m_i2c, retries);
+    }
+
+    /**
+     * Configure the circuit breaker, see mraa_i2c_set_breaker()
+     *
+     * @param maxFailures Failures in a row opening the breaker, 0 disables it
+     * @param cooldownMs How long transfers fail fast once it opened
+     * @param recover Whether to recover the bus when it opens
+     * @return Result of operation
+     */
+    Result
+    setBreaker(unsigned int maxFailures, unsigned int cooldownMs, bool recover = false)
+    {
+        return (Result) mraa_i2c_set_breaker(m_i2c, maxFailures, cooldownMs, recover ? 1 : 0);
+    }
+
+    /**
+     * Clock a stuck slave out of the bus, see mraa_i2c_recover()
+     *
+     * @return Result of operation
+     */
+    Result
+    recover()
+    {
+        return (Result) mraa_i2c_recover(m_i2c);
+    }
+
+    /**
+     * Get the counts of ioctls made and skipped by this context
+     *
+     * @param stats Filled with the counts
+     * @return Result of operation
+     */
+    Result
+    ioctlStats(mraa_bus_ioctl_stats_t& stats)
+    {
+        return (Result) mraa_i2c_ioctl_stats(m_i2c, &stats);
+    }
+
+    /**
+     * Attach a register cache, see mraa_i2c_regcache_init()
+     *
+     * @param numRegs Number of registers covered, at most 256
+     * @param volatileRegs Registers which must not be cached
+     * @param numVolatile Number of entries in volatileRegs
+     * @return Result of operation
+     */
+    Result
+    initRegCache(unsigned int numRegs, const uint8_t* volatileRegs = NULL, int numVolatile = 0)
+    {
+        return (Result) mraa_i2c_regcache_init(m_i2c, numRegs, volatileRegs, numVolatile);
+    }
+
+    /**
+     * Read a register through the register cache
+     *
+     * @param reg Register to read from
+     *
+     * @throws std::invalid_argument in case of error
+     * @return value of the register
+     */
+    uint8_t
+    readRegCached(uint8_t reg)
+    {
+        int x = mraa_i2c_regcache_read(m_i2c, reg);
+        if (x == -1) {
+            throw std::invalid_argument("Unknown error in I2c::readRegCached()");
+        }
+        return (uint8_t) x;
+    }
+
+    /**
+     * Write a register through the register cache
+     *
+     * @param reg Register to write to
+     * @param data Value to write to register
+     * @return Result of operation
+     */
+    Result
+    writeRegCached(uint8_t reg, uint8_t data)
+    {
+        return (Result) mraa_i2c_regcache_write(m_i2c, reg, data);
+    }
+
+    /**
+     * Change the bits of mask in a register through the register cache
+     *
+     * @param reg Register to update
+     * @param mask Bits to change
+     * @param data New value of these bits
+     * @return Result of operation
+     */
+    Result
+    updateRegBits(uint8_t reg, uint8_t mask, uint8_t data)
+    {
+        return (Result) mraa_i2c_regcache_update_bits(m_i2c, reg, mask, data);
+    }
+
+    /**
+     * Write the dirty cached registers back to the device
+     *
+     * @return Result of operation
+     */
+    Result
+    syncRegCache()
+    {
+        return (Result) mraa_i2c_regcache_sync(m_i2c);
+    }
+
+    /**
+     * Forget the cached register values and pending writes
+     *
+     * @return Result of operation
+     */
+    Result
+    invalidateRegCache()
+    {
+        return (Result) mraa_i2c_regcache_invalidate(m_i2c);
+    }
+
+    /**
+     * @brief Batch of i2c messages submitted together
+     *
+     * Messages are queued with their own slave address and sent in a single
+     * I2C_RDWR ioctl by submit(), so the bus address of the I2c object is
+     * left untouched. Read buffers must stay valid until submit() returns.
+     */
+    class Transaction
+    {
+      public:
+        /**
+         * Create an empty transaction on an i2c bus
+         *
+         * @param i2c The bus to submit the transaction on
+         */
+        Transaction(I2c& i2c)
+        {
+            m_txn = mraa_i2c_txn_init(i2c.m_i2c);
+            if (m_txn == NULL) {
+                throw std::invalid_argument("Invalid i2c transaction");
+            }
+        }
+
+        /**
+         * Frees the transaction, it must not outlive the I2c object
+         */
+        ~Transaction()
+        {
+            mraa_i2c_txn_close(m_txn);
+        }
+
+        /**
+         * Queue a write of raw bytes
+         *
+         * @param address Slave address of this message
+         * @param data Bytes to write, copied
+         * @param length Number of bytes to write
+         * @return Result of operation
+         */
+        Result
+        write(uint8_t address, const uint8_t* data, int length)
+        {
+            return (Result) mraa_i2c_txn_write(m_txn, address, data, length);
+        }
+
+        /**
+         * Queue a write of a byte to a register
+         *
+         * @param address Slave address of this message
+         * @param reg Register to write to
+         * @param data Value to write to register
+         * @return Result of operation
+         */
+        Result
+        writeReg(uint8_t address, uint8_t reg, uint8_t data)
+        {
+            return (Result) mraa_i2c_txn_write_byte_data(m_txn, address, data, reg);
+        }
+
+        /**
+         * Queue a read
+         *
+         * @param address Slave address of this message
+         * @param data Buffer filled by submit()
+         * @param length Number of bytes to read
+         * @return Result of operation
+         */
+        Result
+        read(uint8_t address, uint8_t* data, int length)
+        {
+            return (Result) mraa_i2c_txn_read(m_txn, address, data, length);
+        }
+
+        /**
+         * Queue a read of length bytes starting at a register
+         *
+         * @param address Slave address of this message
+         * @param reg Register to read from
+         * @param data Buffer filled by submit()
+         * @param length Number of bytes to read
+         * @return Result of operation
+         */
+        Result
+        readBytesReg(uint8_t address, uint8_t reg, uint8_t* data, int length)
+        {
+            return (Result) mraa_i2c_txn_read_bytes_data(m_txn, address, reg, data, length);
+        }
+
+        /**
+         * Submit the queued messages
+         *
+         * @return Result of operation
+         */
+        Result
+        submit()
+        {
+            return (Result) mraa_i2c_txn_submit(m_txn);
+        }
+
+#if defined(SWIGPYTHON)
+        /**
+         * Submit the queued messages on the worker thread of the bus and
+         * return without waiting
+         *
+         * @param pyfunc Called as pyfunc(status, args) once submitted
+         * @param args Passed to pyfunc
+         * @return Result of operation
+         */
+        Result
+        submitAsync(PyObject* pyfunc, PyObject* args)
+        {
+            Py_INCREF(pyfunc);
+            Py_INCREF(args);
+            Result ret = (Result) mraa_i2c_txn_submit_async_python(m_txn, (void*) pyfunc, (void*) args);
+            if (ret != SUCCESS) {
+                Py_DECREF(pyfunc);
+                Py_DECREF(args);
+            }
+            return ret;
+        }
+#else
+        /**
+         * Submit the queued messages on the worker thread of the bus and
+         * return without waiting. The transaction and its read buffers must
+         * be left alone until fptr was called.
+         *
+         * @param fptr Called from the worker thread with the result
+         * @param args Passed to fptr
+         * @return Result of operation
+         */
+        Result
+        submitAsync(void (*fptr)(mraa_result_t, void*), void* args)
+        {
+            return (Result) mraa_i2c_txn_submit_async(m_txn, fptr, args, NULL);
+        }
+#endif
+
+#ifndef SWIG
+        /**
+         * Submit the queued messages on the worker thread of the bus and
+         * return without waiting. The transaction and its read buffers must
+         * be left alone until the future is ready. Waiting on the future
+         * while holding the bus with busAcquire() never ends.
+         *
+         * @return Future result of the transfer
+         */
+        std::future<Result>
+        submitAsync()
+        {
+            std::promise<Result>* done = new std::promise<Result>();
+            std::future<Result> result = done->get_future();
+            mraa_result_t ret = mraa_i2c_txn_submit_async(m_txn, &Transaction::complete, done, NULL);
+            if (ret != MRAA_SUCCESS) {
+                done->set_value((Result) ret);
+                delete done;
+            }
+            return result;
+        }
+#endif
+
+        /**
+         * Drop the queued messages
+         *
+         * @return Result of operation
+         */
+        Result
+        reset()
+        {
+            return (Result) mraa_i2c_txn_reset(m_txn);
+        }
+
+      private:
+#ifndef SWIG
+        static void
+        complete(mraa_result_t status, void* args)
+        {
+            std::promise<Result>* done = (std::promise<Result>*) args;
+            done->set_value((Result) status);
+            delete done;
+        }
+#endif
+
+        Transaction(const Transaction&);
+        Transaction& operator=(const Transaction&);
+
+        mraa_i2c_txn m_txn;
+    };
+
   private:
     mraa_i2c_context m_i2c;
 };
@@ -68,6 +68,55 @@ typedef enum {
  */
 typedef struct _spi* mraa_spi_context;
 
+/** Most segments mraa_spi_transfer_segments() takes at once */
+#define MRAA_SPI_MAX_SEGMENTS 64
+
+/**
+ * One segment of a multi-segment transfer, see mraa_spi_transfer_segments()
+ */
+typedef struct {
+    const uint8_t* tx;          /**< bytes to send, NULL to send zeros (receive only) */
+    uint8_t* rx;                /**< buffer for the received bytes, NULL to drop them (send only) */
+    unsigned int length;        /**< length of the segment in bytes */
+    unsigned int speed_hz;      /**< clock of this segment, 0 for the context frequency */
+    uint8_t bits_per_word;      /**< word size of this segment, 0 for the context setting */
+    uint8_t cs_change;          /**< 1 to deselect the chip after this segment (before the next one) */
+    uint16_t delay_usecs;       /**< delay after this segment, before chip select changes */
+} mraa_spi_segment_t;
+
+/** Chunk size of streamed transfers when spidev doesn't report its bufsiz */
+#define MRAA_SPI_STREAM_DEFAULT_CHUNK 4096
+
+/**
+ * Fills the next chunk of a streamed write, see mraa_spi_write_stream()
+ *
+ * @param args The argument passed to mraa_spi_write_stream()
+ * @param chunk Buffer to write the bytes into
+ * @param offset Position of the chunk in the stream
+ * @param length Number of bytes to write into chunk
+ * @return MRAA_SUCCESS, anything else ends the stream with that result
+ */
+typedef mraa_result_t (*mraa_spi_stream_fill_t)(void* args, uint8_t* chunk, size_t offset, size_t length);
+
+/** Most blocks a ring started with mraa_spi_ring_start() holds */
+#define MRAA_SPI_RING_MAX_BLOCKS 65536
+
+/**
+ * Opaque pointer definition to the internal struct _spi_ring
+ */
+typedef struct _spi_ring* mraa_spi_ring_context;
+
+/**
+ * Where a block read with mraa_spi_ring_read() came from
+ */
+typedef struct {
+    uint64_t timestamp_ns;   /**< CLOCK_MONOTONIC time the transfer of the block completed */
+    uint64_t sequence;       /**< number of the period since the ring started, dropped and
+                                  missed ones included */
+    unsigned int overruns;   /**< blocks dropped right before this one, because the ring was full or
+                                  a late transfer made the thread miss their periods */
+} mraa_spi_block_info_t;
+
 /**
  * Initialise SPI_context, uses board mapping. Sets the muxes
  *
@@ -132,6 +181,20 @@ int mraa_spi_write_word(mraa_spi_context dev, uint16_t data);
  */
 uint8_t* mraa_spi_write_buf(mraa_spi_context dev, uint8_t* data, int length);
 
+/**
+ * Write Buffer of bytes to the SPI device, receiving into a buffer owned by
+ * the context. The buffer grows to the longest transfer and is then reused,
+ * so repeated writes don't allocate. It is overwritten by the next call on
+ * the context and freed by mraa_spi_stop(). To receive straight into your
+ * own memory use mraa_spi_transfer_buf().
+ *
+ * @param dev The Spi context
+ * @param data to send
+ * @param length elements within buffer, Max 4096
+ * @return Data received on the miso line, same length as passed in, or NULL
+ */
+uint8_t* mraa_spi_write_buf_pooled(mraa_spi_context dev, uint8_t* data, int length);
+
 /**
  * Write Buffer of uint16 to the SPI device. The pointer return has to be
  * free'd by the caller. It will return a NULL pointer in cases of error.
@@ -143,6 +206,18 @@ uint8_t* mraa_spi_write_buf(mraa_spi_context dev, uint8_t* data, int length);
  */
 uint16_t* mraa_spi_write_buf_word(mraa_spi_context dev, uint16_t* data, int length);
 
+/**
+ * Write Buffer of uint16 to the SPI device, receiving into the buffer owned
+ * by the context that mraa_spi_write_buf_pooled() uses. The same rules
+ * apply, the buffer is overwritten by the next pooled call on the context.
+ *
+ * @param dev The Spi context
+ * @param data to send
+ * @param length elements (in bytes) within buffer, even, Max 4096
+ * @return Data received on the miso line, same length as passed in, or NULL
+ */
+uint16_t* mraa_spi_write_buf_word_pooled(mraa_spi_context dev, uint16_t* data, int length);
+
 /**
  * Transfer Buffer of bytes to the SPI device. Both send and recv buffers
  * are passed in
@@ -155,6 +230,34 @@ uint16_t* mraa_spi_write_buf_word(mraa_spi_context dev, uint16_t* data, int leng
  */
 mraa_result_t mraa_spi_transfer_buf(mraa_spi_context dev, uint8_t* data, uint8_t* rxbuf, int length);
 
+/**
+ * Queue a transfer of a buffer of bytes on the worker thread of the bus and
+ * return without waiting. Requests of a bus run one after the other in
+ * submission order, each under the priority class of its context. Both
+ * buffers must stay valid until the request completed. mraa_spi_stop()
+ * completes the requests of the context still queued with
+ * MRAA_ERROR_INVALID_RESOURCE and waits for the one running. The worker
+ * needs the bus: don't wait for a request while holding the bus with
+ * mraa_spi_bus_acquire(), see mraa_bus_async_wait().
+ *
+ * @param dev The Spi context
+ * @param data to send
+ * @param rxbuf buffer to recv data back, may be NULL
+ * @param length elements within buffer, Max 4096
+ * @param cb Function called from the worker thread with the result, may be NULL
+ * @param args Argument passed to cb
+ * @param handle Set to a handle for mraa_bus_async_wait(), which must then be
+ * called. If NULL the request is released once it completed.
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_transfer_buf_async(mraa_spi_context dev,
+                                          uint8_t* data,
+                                          uint8_t* rxbuf,
+                                          int length,
+                                          mraa_bus_async_cb_t cb,
+                                          void* args,
+                                          mraa_bus_async_t* handle);
+
 /**
  * Transfer Buffer of uint16 to the SPI device. Both send and recv buffers
  * are passed in
@@ -167,6 +270,119 @@ mraa_result_t mraa_spi_transfer_buf(mraa_spi_context dev, uint8_t* data, uint8_t
  */
 mraa_result_t mraa_spi_transfer_buf_word(mraa_spi_context dev, uint16_t* data, uint16_t* rxbuf, int length);
 
+/**
+ * Transfer a list of segments as a single message: the chip stays selected
+ * from the first to the last segment unless a segment asks for cs_change,
+ * so e.g. a command and its payload, or the readouts of several ADC
+ * channels, take one SPI_IOC_MESSAGE ioctl. Platforms which replace the
+ * spi transfer functions run the segments one by one, without the per
+ * segment speed, word size and chip select settings.
+ *
+ * @param dev The Spi context
+ * @param segments The segments, in transfer order
+ * @param count Number of segments, at most MRAA_SPI_MAX_SEGMENTS
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_transfer_segments(mraa_spi_context dev, const mraa_spi_segment_t* segments, unsigned int count);
+
+/**
+ * Transfer a buffer of any length. spidev refuses messages longer than its
+ * bufsiz module parameter (4096 bytes by default), so the buffer goes out as
+ * one message per bufsiz chunk with the bus held for the whole stream. With
+ * keep_cs the chip stays selected between the chunks, so the device sees one
+ * frame; platforms which replace the spi transfer functions can't keep it.
+ *
+ * @param dev The Spi context
+ * @param data to send
+ * @param rxbuf buffer of length bytes to recv data back, may be NULL
+ * @param length Length of the stream in bytes
+ * @param keep_cs Keep the chip selected from the first to the last chunk
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_transfer_stream(mraa_spi_context dev,
+                                       const uint8_t* data,
+                                       uint8_t* rxbuf,
+                                       size_t length,
+                                       mraa_boolean_t keep_cs);
+
+/**
+ * Write a stream produced chunk by chunk, e.g. a frame rendered while it is
+ * sent. Chunks are bufsiz long as for mraa_spi_transfer_stream() and are
+ * double buffered: fill is called on a helper thread for the next chunk
+ * while the calling thread, holding the bus, sends the previous one. The
+ * transfers stay on the calling thread, so the stream may run inside a
+ * section held with mraa_spi_bus_acquire(), e.g. after a mode change made
+ * for it. Nothing is received. If fill or a transfer fails the stream stops
+ * there; with keep_cs the chip may then stay selected until the next
+ * transfer.
+ *
+ * @param dev The Spi context
+ * @param length Length of the stream in bytes
+ * @param fill Called in stream order for every chunk, from the helper thread
+ * @param args Argument passed to fill
+ * @param keep_cs Keep the chip selected from the first to the last chunk
+ * @return Result of operation, or the first failing result of fill
+ */
+mraa_result_t mraa_spi_write_stream(mraa_spi_context dev,
+                                    size_t length,
+                                    mraa_spi_stream_fill_t fill,
+                                    void* args,
+                                    mraa_boolean_t keep_cs);
+
+/**
+ * Start sampling into a ring: a dedicated thread makes back-to-back
+ * transfers of block_size bytes, or one every period_us, each received
+ * straight into the next free block of the ring. Blocks are then read with
+ * mraa_spi_ring_read(). While the ring is full the thread keeps sampling at
+ * the same rate but drops the blocks, which the next block read reports in
+ * its overruns. A transfer running past its period doesn't make the thread
+ * catch up in a burst, the periods it missed are skipped and reported as
+ * overruns as well. The context must not be stopped before the ring.
+ *
+ * @param dev The Spi context
+ * @param tx block_size bytes sent by every transfer (e.g. the conversion
+ * commands of an ADC), NULL to send zeros
+ * @param block_size Length of a transfer, Max 4096
+ * @param blocks Number of blocks in the ring, 2 to MRAA_SPI_RING_MAX_BLOCKS
+ * @param period_us Time between the starts of two transfers, 0 for back to back
+ * @param priority Realtime priority of the sampling thread, see
+ * mraa_set_priority(), 0 to keep the normal scheduling
+ * @return Ring context or NULL
+ */
+mraa_spi_ring_context mraa_spi_ring_start(mraa_spi_context dev,
+                                          const uint8_t* tx,
+                                          unsigned int block_size,
+                                          unsigned int blocks,
+                                          unsigned int period_us,
+                                          int priority);
+
+/**
+ * Take the oldest block out of the ring. A single thread may read a ring.
+ *
+ * @param ring The ring context
+ * @param data Buffer of block_size bytes receiving the block
+ * @param info Filled with the timestamp, sequence number and overruns of the
+ * block, may be NULL
+ * @param timeout_ms Time to wait for a block, 0 to return at once, -1 to wait
+ * until one comes
+ * @return MRAA_SUCCESS, MRAA_ERROR_NO_DATA_AVAILABLE when no block came in
+ * time, or the result of the transfer which stopped the sampling once the
+ * ring is empty
+ */
+mraa_result_t mraa_spi_ring_read(mraa_spi_ring_context ring,
+                                 uint8_t* data,
+                                 mraa_spi_block_info_t* info,
+                                 int timeout_ms);
+
+/**
+ * Stop the sampling thread and free the ring
+ *
+ * @param ring The ring context
+ * @return Result of operation, or the result of the transfer which stopped
+ * the sampling
+ */
+mraa_result_t mraa_spi_ring_stop(mraa_spi_ring_context ring);
+
 /**
  * Change the SPI lsb mode
  *
@@ -186,7 +402,62 @@ mraa_result_t mraa_spi_lsbmode(mraa_spi_context dev, mraa_boolean_t lsb);
 mraa_result_t mraa_spi_bit_per_word(mraa_spi_context dev, unsigned int bits);
 
 /**
- * De-inits an mraa_spi_context device
+ * Set the priority class of the transfers made on this context. All the
+ * contexts of a bus in the process, whatever their chip select, share one
+ * arbiter: waiting transfers of a higher class go first and the others go
+ * in arrival order. Contexts start as MRAA_BUS_PRIORITY_NORMAL.
+ *
+ * @param dev The Spi context
+ * @param priority The priority class
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_set_priority(mraa_spi_context dev, mraa_bus_priority_t priority);
+
+/**
+ * Hold the bus for the calling thread, so a sequence of calls (e.g. a mode
+ * change and the transfers using it) isn't interleaved with other contexts
+ * of the bus. Calls nest and must be matched by mraa_spi_bus_release().
+ *
+ * @param dev The Spi context
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_bus_acquire(mraa_spi_context dev);
+
+/**
+ * Give back the bus held with mraa_spi_bus_acquire()
+ *
+ * @param dev The Spi context
+ * @return Result of operation, MRAA_ERROR_INVALID_RESOURCE if the calling
+ * thread doesn't hold the bus
+ */
+mraa_result_t mraa_spi_bus_release(mraa_spi_context dev);
+
+/**
+ * Get the wait statistics of the bus of this context
+ *
+ * @param dev The Spi context
+ * @param stats Filled with the statistics since the bus was first used
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_bus_stats(mraa_spi_context dev, mraa_bus_stats_t* stats);
+
+/**
+ * Get the ioctl counters of this context. The clock and word size go in
+ * every transfer, so setting them again, or to a value the device node
+ * already took, costs no ioctl; mode and bit order are only written when
+ * they differ from what the device node has. Contexts sharing a chip select
+ * then only pay for the mode changes between them.
+ *
+ * @param dev The Spi context
+ * @param stats Filled with the counts since the context was created
+ * @return Result of operation
+ */
+mraa_result_t mraa_spi_ioctl_stats(mraa_spi_context dev, mraa_bus_ioctl_stats_t* stats);
+
+/**
+ * De-inits an mraa_spi_context device. Asynchronous requests of the context
+ * still queued complete with MRAA_ERROR_INVALID_RESOURCE, a running one is
+ * waited for.
  *
  * @param dev The Spi context
  * @return Result of operation
@@ -29,6 +29,10 @@
 #include "spi.h"
 #include "types.hpp"
 #include <stdexcept>
+#ifndef SWIG
+#include <future>
+#include <vector>
+#endif
 
 namespace mraa
 {
@@ -184,7 +188,43 @@ class Spi
         return mraa_spi_write_buf(m_spi, txBuf, length);
     }
 
+    /**
+     * Transfer a buffer, receiving straight into a caller provided buffer.
+     * The bindings map both buffers without copying them: any object
+     * supporting the buffer protocol in Python, direct ByteBuffers in Java
+     * and Buffers in Node.
+     *
+     * @param txData buffer to send
+     * @param txLength size of buffer to send
+     * @param rxData buffer receiving the data, at least txLength long
+     * @param rxLength size of the receive buffer
+     * @return Result of operation
+     */
+    Result
+    transferInto(const uint8_t* txData, int txLength, uint8_t* rxData, int rxLength)
+    {
+        if (rxLength < txLength) {
+            return ERROR_INVALID_PARAMETER;
+        }
+        return (Result) mraa_spi_transfer_buf(m_spi, (uint8_t*) txData, rxData, txLength);
+    }
+
 #ifndef SWIG
+    /**
+     * Write buffer of bytes to SPI device, receiving into a buffer owned
+     * by the object and reused by the next call, see
+     * mraa_spi_write_buf_pooled()
+     *
+     * @param txBuf buffer to send
+     * @param length size of buffer to send
+     * @return data received on the miso line or NULL
+     */
+    const uint8_t*
+    writePooled(uint8_t* txBuf, int length)
+    {
+        return mraa_spi_write_buf_pooled(m_spi, txBuf, length);
+    }
+
     /**
      * Write buffer of bytes to SPI device The pointer return has to be
      * free'd by the caller. It will return a NULL pointer in cases of
@@ -199,6 +239,21 @@ class Spi
     {
         return mraa_spi_write_buf_word(m_spi, txBuf, length);
     }
+
+    /**
+     * Write buffer of uint16 to SPI device, receiving into the buffer
+     * owned by the object and reused by the next pooled call, see
+     * mraa_spi_write_buf_word_pooled()
+     *
+     * @param txBuf buffer to send
+     * @param length size of buffer (in bytes) to send
+     * @return data received on the miso line or NULL
+     */
+    const uint16_t*
+    writeWordPooled(uint16_t* txBuf, int length)
+    {
+        return mraa_spi_write_buf_word_pooled(m_spi, txBuf, length);
+    }
 #endif
 
 #ifndef SWIG
@@ -217,6 +272,47 @@ class Spi
         return (Result) mraa_spi_transfer_buf(m_spi, txBuf, rxBuf, length);
     }
 
+    /**
+     * Queue a transfer on the worker thread of the bus and return without
+     * waiting. Both buffers must stay valid until fptr was called.
+     *
+     * @param txBuf buffer to send
+     * @param rxBuf buffer to optionally receive data from spi device
+     * @param length size of buffer to send
+     * @param fptr Called from the worker thread with the result
+     * @param args Passed to fptr
+     * @return Result of operation
+     */
+    Result
+    transferAsync(uint8_t* txBuf, uint8_t* rxBuf, int length, void (*fptr)(mraa_result_t, void*), void* args)
+    {
+        return (Result) mraa_spi_transfer_buf_async(m_spi, txBuf, rxBuf, length, fptr, args, NULL);
+    }
+
+    /**
+     * Queue a transfer on the worker thread of the bus and return without
+     * waiting. Both buffers must stay valid until the future is ready.
+     * Waiting on the future while holding the bus with busAcquire() never
+     * ends.
+     *
+     * @param txBuf buffer to send
+     * @param rxBuf buffer to optionally receive data from spi device
+     * @param length size of buffer to send
+     * @return Future result of the transfer
+     */
+    std::future<Result>
+    transferAsync(uint8_t* txBuf, uint8_t* rxBuf, int length)
+    {
+        std::promise<Result>* done = new std::promise<Result>();
+        std::future<Result> result = done->get_future();
+        mraa_result_t ret = mraa_spi_transfer_buf_async(m_spi, txBuf, rxBuf, length, &Spi::complete, done, NULL);
+        if (ret != MRAA_SUCCESS) {
+            done->set_value((Result) ret);
+            delete done;
+        }
+        return result;
+    }
+
     /**
      * Transfer data to and from SPI device Receive pointer may be null if
      * return data is not needed.
@@ -231,6 +327,65 @@ class Spi
     {
         return (Result) mraa_spi_transfer_buf_word(m_spi, txBuf, rxBuf, length);
     }
+
+    /**
+     * Transfer a list of segments as a single message, see
+     * mraa_spi_transfer_segments()
+     *
+     * @param segments The segments, in transfer order
+     * @param count Number of segments, at most MRAA_SPI_MAX_SEGMENTS
+     * @return Result of operation
+     */
+    Result
+    transferSegments(const mraa_spi_segment_t* segments, unsigned int count)
+    {
+        return (Result) mraa_spi_transfer_segments(m_spi, segments, count);
+    }
+
+    /**
+     * Transfer a list of segments as a single message, see
+     * mraa_spi_transfer_segments()
+     *
+     * @param segments The segments, in transfer order
+     * @return Result of operation
+     */
+    Result
+    transferSegments(const std::vector<mraa_spi_segment_t>& segments)
+    {
+        return (Result) mraa_spi_transfer_segments(m_spi, segments.data(), (unsigned int) segments.size());
+    }
+
+    /**
+     * Transfer a buffer of any length in spidev bufsiz chunks, see
+     * mraa_spi_transfer_stream()
+     *
+     * @param txBuf buffer to send
+     * @param rxBuf buffer to optionally receive data from spi device
+     * @param length size of buffer to send
+     * @param keepCs Keep the chip selected from the first to the last chunk
+     * @return Result of operation
+     */
+    Result
+    transferStream(const uint8_t* txBuf, uint8_t* rxBuf, size_t length, bool keepCs = true)
+    {
+        return (Result) mraa_spi_transfer_stream(m_spi, txBuf, rxBuf, length, keepCs ? 1 : 0);
+    }
+
+    /**
+     * Write a stream filled chunk by chunk while the previous chunk is
+     * sent, see mraa_spi_write_stream()
+     *
+     * @param length Length of the stream in bytes
+     * @param fill Called in stream order for every chunk
+     * @param args Passed to fill
+     * @param keepCs Keep the chip selected from the first to the last chunk
+     * @return Result of operation
+     */
+    Result
+    writeStream(size_t length, mraa_spi_stream_fill_t fill, void* args, bool keepCs = true)
+    {
+        return (Result) mraa_spi_write_stream(m_spi, length, fill, args, keepCs ? 1 : 0);
+    }
 #endif
 
     /**
@@ -257,7 +412,135 @@ class Spi
         return (Result) mraa_spi_bit_per_word(m_spi, bits);
     }
 
+    /**
+     * Set the priority class of the transfers made through this object
+     *
+     * @param priority The priority class
+     * @return Result of operation
+     */
+    Result
+    setPriority(BusPriority priority)
+    {
+        return (Result) mraa_spi_set_priority(m_spi, (mraa_bus_priority_t) priority);
+    }
+
+    /**
+     * Hold the bus for the calling thread until busRelease()
+     *
+     * @return Result of operation
+     */
+    Result
+    busAcquire()
+    {
+        return (Result) mraa_spi_bus_acquire(m_spi);
+    }
+
+    /**
+     * Give back the bus held with busAcquire()
+     *
+     * @return Result of operation
+     */
+    Result
+    busRelease()
+    {
+        return (Result) mraa_spi_bus_release(m_spi);
+    }
+
+    /**
+     * Get the wait statistics of the bus
+     *
+     * @param stats Filled with the statistics
+     * @return Result of operation
+     */
+    Result
+    busStats(mraa_bus_stats_t& stats)
+    {
+        return (Result) mraa_spi_bus_stats(m_spi, &stats);
+    }
+
+    /**
+     * Get the counts of ioctls made and skipped by this object
+     *
+     * @param stats Filled with the counts
+     * @return Result of operation
+     */
+    Result
+    ioctlStats(mraa_bus_ioctl_stats_t& stats)
+    {
+        return (Result) mraa_spi_ioctl_stats(m_spi, &stats);
+    }
+
   private:
+#ifndef SWIG
+    static void
+    complete(mraa_result_t status, void* args)
+    {
+        std::promise<Result>* done = (std::promise<Result>*) args;
+        done->set_value((Result) status);
+        delete done;
+    }
+
+    friend class SpiRing;
+#endif
+
     mraa_spi_context m_spi;
 };
+
+#ifndef SWIG
+/**
+ * @brief Blocks sampled continuously from a SPI device
+ *
+ * A thread of its own makes the transfers into a ring the blocks are read
+ * from, see mraa_spi_ring_start()
+ */
+class SpiRing
+{
+  public:
+    /**
+     * Start sampling, the Spi object must outlive the ring
+     *
+     * @param spi The device to sample
+     * @param tx blockSize bytes sent by every transfer, NULL to send zeros
+     * @param blockSize Length of a transfer
+     * @param blocks Number of blocks in the ring
+     * @param periodUs Time between the starts of two transfers, 0 for back to back
+     * @param priority Realtime priority of the sampling thread, 0 to keep the
+     * normal scheduling
+     */
+    SpiRing(Spi& spi, const uint8_t* tx, unsigned int blockSize, unsigned int blocks, unsigned int periodUs = 0, int priority = 0)
+    {
+        m_ring = mraa_spi_ring_start(spi.m_spi, tx, blockSize, blocks, periodUs, priority);
+
+        if (m_ring == NULL) {
+            throw std::invalid_argument("Error starting SPI ring");
+        }
+    }
+
+    /**
+     * Stops the sampling thread and frees the ring
+     */
+    ~SpiRing()
+    {
+        mraa_spi_ring_stop(m_ring);
+    }
+
+    /**
+     * Take the oldest block out of the ring, see mraa_spi_ring_read()
+     *
+     * @param data Buffer of blockSize bytes receiving the block
+     * @param info Filled with the timestamp, sequence number and overruns of the block
+     * @param timeoutMs Time to wait for a block, 0 to return at once, -1 to wait
+     * until one comes
+     * @return Result of operation
+     */
+    Result
+    read(uint8_t* data, mraa_spi_block_info_t& info, int timeoutMs = -1)
+    {
+        return (Result) mraa_spi_ring_read(m_ring, data, &info, timeoutMs);
+    }
+
+  private:
+    mraa_spi_ring_context m_ring;
+};
+#endif
 }
@@ -590,6 +590,17 @@ typedef enum {
     MRAA_I2C_HIGH = 2  /**< up to 3.4Mhz */
 } mraa_i2c_mode_t;
 
+/**
+ * Enum representing the priority classes of the bus arbiter. A waiting
+ * transfer of a higher class goes before any waiting transfer of a lower
+ * class, transfers of the same class go in arrival order.
+ */
+typedef enum {
+    MRAA_BUS_PRIORITY_HIGH = 0,   /**< latency critical, e.g. control loops */
+    MRAA_BUS_PRIORITY_NORMAL = 1, /**< default */
+    MRAA_BUS_PRIORITY_BULK = 2    /**< background transfers, e.g. EEPROM dumps */
+} mraa_bus_priority_t;
+
 /**
  * Enum representing different uart parity states
  */
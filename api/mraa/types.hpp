@@ -581,6 +581,15 @@ typedef enum {
     I2C_HIGH = 2  /**< up to 3.4Mhz */
 } I2cMode;
 
+/**
+ * Enum representing the priority classes of the bus arbiter
+ */
+typedef enum {
+    BUS_PRIORITY_HIGH = 0,   /**< latency critical, e.g. control loops */
+    BUS_PRIORITY_NORMAL = 1, /**< default */
+    BUS_PRIORITY_BULK = 2    /**< background transfers, e.g. EEPROM dumps */
+} BusPriority;
+
 /**
  * Enum representing different uart parity states
  */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mraa_internal.h"
+#include <pthread.h>
+
+/* Kinds of bus with their own arbiters, bus numbers are per kind. */
+typedef enum {
+    MRAA_BUS_ARBITER_I2C = 0,
+    MRAA_BUS_ARBITER_SPI = 1
+} mraa_bus_arbiter_type_t;
+
+/*
+ * Arbiter shared by every context of the process on the same bus. Arbiters
+ * are created on first use and live until the process exits.
+ */
+struct _bus_arbiter* mraa_bus_arbiter_get(mraa_bus_arbiter_type_t type, int busnum);
+
+/*
+ * Wait for the bus. Recursive for the thread already holding it, so a
+ * transfer made inside an explicit acquire/release section doesn't block.
+ */
+void mraa_bus_arbiter_acquire(struct _bus_arbiter* arb, mraa_bus_priority_t priority);
+mraa_result_t mraa_bus_arbiter_release(struct _bus_arbiter* arb);
+
+void mraa_bus_arbiter_stats(struct _bus_arbiter* arb, mraa_bus_stats_t* stats);
+
+/* Number of threads waiting for the bus, lets the tests order their threads. */
+unsigned int mraa_bus_arbiter_waiters(struct _bus_arbiter* arb);
+
+/* A request run by the worker thread of a bus, see mraa_bus_async_t. */
+struct _bus_async {
+    mraa_result_t (*run)(struct _bus_async* req);
+    struct _bus_arbiter* arb;
+    void* owner; /* context the request uses, see mraa_bus_arbiter_cancel() */
+    void* dev;
+    uint8_t* tx;
+    uint8_t* rx;
+    int length;
+    mraa_bus_async_cb_t cb;
+    void* args;
+    mraa_boolean_t python; /* cb and args are Python objects, see lang_func */
+    mraa_result_t status;
+    mraa_boolean_t done;
+    mraa_boolean_t detached; /* nobody waits, the worker frees it */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct _bus_async* next;
+};
+
+/*
+ * Queue req on the worker of the bus, started on first use. The worker runs
+ * the requests in submission order. With handle NULL the request is freed
+ * once its callback returned, otherwise by mraa_bus_async_wait().
+ */
+mraa_result_t mraa_bus_arbiter_submit(struct _bus_arbiter* arb, struct _bus_async* req, mraa_bus_async_t* handle);
+
+/*
+ * Complete the queued requests of owner with MRAA_ERROR_INVALID_RESOURCE and
+ * wait for the one the worker may be running, so owner can be freed. Called
+ * by the stop functions of the contexts.
+ */
+void mraa_bus_arbiter_cancel(struct _bus_arbiter* arb, void* owner);
+
+/*
+ * Stop and join the workers once they ran their queues, from mraa_deinit().
+ * A later submission starts the worker of its bus again.
+ */
+void mraa_bus_arbiter_shutdown();
+
+#ifdef __cplusplus
+}
+#endif
@@ -85,6 +85,8 @@ typedef struct s_firmata {
     uint8_t dev_count;
     struct _firmata** devs;
     pthread_spinlock_t lock;
+    pthread_mutex_t i2c_lock; /* protects i2cmsg */
+    pthread_cond_t i2c_cond;  /* signalled on every i2c reply */
 } t_firmata;
 
 t_firmata* firmata_new(const char* name);
@@ -21,6 +21,16 @@ typedef struct {
 
 typedef struct gpioline_info mraa_gpiod_line_info;
 
+/* Maximum number of kernel events decoded by a single read. */
+#define MRAA_GPIOD_EVENTS_PER_READ 16
+
+/* Line event, common to the v1 and v2 ABIs. */
+typedef struct {
+    uint64_t timestamp; /* kernel timestamp in ns */
+    unsigned int id; /* GPIOEVENT_EVENT_RISING_EDGE or GPIOEVENT_EVENT_FALLING_EDGE */
+    unsigned int line_seqno; /* per line sequence number, 0 with the v1 ABI */
+} mraa_gpiod_line_event;
+
 void _mraa_free_gpio_groups(mraa_gpio_context dev);
 void _mraa_close_gpio_event_handles(mraa_gpio_context dev);
 void _mraa_close_gpio_desc(mraa_gpio_context dev);
@@ -41,6 +51,14 @@ int mraa_get_lines_handle(int chip_fd, unsigned line_offsets[], unsigned num_lin
 int mraa_set_line_values(int line_handle, unsigned int num_lines, unsigned char input_values[]);
 int mraa_get_line_values(int line_handle, unsigned int num_lines, unsigned char output_values[]);
 
+mraa_boolean_t mraa_gpiod_has_uapi_v2(int chip_fd);
+uint64_t mraa_gpiod_flags_to_v2(unsigned flags);
+int mraa_get_lines_handle_v2(int chip_fd, unsigned line_offsets[], unsigned num_lines, uint64_t flags, uint64_t default_bits);
+int mraa_set_line_values_v2(int line_handle, uint64_t mask, uint64_t bits);
+int mraa_get_line_values_v2(int line_handle, uint64_t mask, uint64_t* bits);
+int mraa_get_line_event_handle_v2(int chip_fd, unsigned line_offset, uint64_t flags, unsigned buffer_size);
+int mraa_read_line_events(int fd, mraa_boolean_t uapi_v2, mraa_gpiod_line_event events[], int max);
+
 mraa_boolean_t mraa_is_gpio_line_kernel_owned(mraa_gpiod_line_info *linfo);
 mraa_boolean_t mraa_is_gpio_line_dir_out(mraa_gpiod_line_info *linfo);
 mraa_boolean_t mraa_is_gpio_line_active_low(mraa_gpiod_line_info *linfo);
@@ -55,6 +73,10 @@ int mraa_find_gpio_line_by_name(const char *name, unsigned *chip_number, unsigne
 /* Multiple gpio support. */
 typedef struct _gpio_group* mraa_gpiod_group_t;
 
+int _mraa_gpiod_group_request(mraa_gpiod_group_t group, unsigned flags);
+int _mraa_gpiod_group_set_values(mraa_gpiod_group_t group, uint64_t mask);
+int _mraa_gpiod_group_get_values(mraa_gpiod_group_t group);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mraa_internal.h"
+
+/* Upper bound for mraa_gpio_use_isr_dispatcher(). */
+#define MRAA_GPIO_DISPATCH_MAX_THREADS 16
+
+/* Shared isr threads, see mraa_gpio_use_isr_dispatcher(). */
+mraa_boolean_t mraa_gpio_dispatch_enabled();
+mraa_result_t mraa_gpio_dispatch_register(mraa_gpio_context dev);
+void mraa_gpio_dispatch_unregister(mraa_gpio_context dev);
+
+/* Events a context gets when the dispatcher serves it without a queue of its own. */
+#define MRAA_GPIO_DISPATCH_QUEUE_SIZE 64
+
+/*
+ * Event decoding, shared with the per context isr thread in gpio.c. Events go
+ * to the queue of the context when it has one; events, if not NULL, gets the
+ * last one of each pin as reported by mraa_gpio_get_events().
+ */
+void mraa_gpio_sysfs_read_event(mraa_gpio_context dev, mraa_gpio_events_t events, int fd, int idx, int pin);
+void mraa_gpio_chardev_read_events(mraa_gpio_context dev, mraa_gpio_events_t events, int fd, int idx, int pin, unsigned int* line_seqno, mraa_boolean_t uapi_v2);
+
+#ifdef __cplusplus
+}
+#endif
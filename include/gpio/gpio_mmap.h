@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mraa_internal.h"
+
+/* Generic mmap backend, driven by the board's gpio_mmap description. */
+mraa_result_t mraa_gpio_mmap_generic_setup(mraa_gpio_context dev, mraa_boolean_t en);
+
+#ifdef __cplusplus
+}
+#endif
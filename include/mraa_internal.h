@@ -13,6 +13,7 @@ extern "C" {
 
 #include <syslog.h>
 #include <fnmatch.h>
+#include <sys/types.h>
 
 #include "common.h"
 #include "mraa_internal_types.h"
@@ -26,6 +27,9 @@ extern mraa_iio_info_t* plat_iio;
 #endif
 extern mraa_lang_func_t* lang_func;
 
+/* Room for any int formatted by mraa_format_sysfs_int(), "-2147483648". */
+#define MRAA_SYSFS_INT_MAX_LEN 12
+
 /**
  * Takes in pin information and sets up the multiplexors.
  *
@@ -141,6 +145,44 @@ int mraa_find_i2c_bus(const char* devname, int startfrom);
  */
 mraa_result_t mraa_atoi(char* intStr, int* value);
 
+/**
+ * helper function to parse the decimal value of a sysfs attribute without
+ * strtol. The number may be followed by a newline or a NUL, nothing else.
+ *
+ * @param buffer as read from the attribute, not necessarily NUL terminated
+ * @param len number of valid bytes in buffer
+ * @param converted value
+ * @return Result of the operation
+ */
+mraa_result_t mraa_parse_sysfs_int(const char* buf, ssize_t len, int* value);
+
+/**
+ * helper function to format an int for a sysfs attribute without snprintf
+ *
+ * @param buffer of at least MRAA_SYSFS_INT_MAX_LEN bytes, not NUL terminated
+ * @param value to format
+ * @return number of bytes written
+ */
+int mraa_format_sysfs_int(char* buf, int value);
+
+/**
+ * Build the name hash tables used by the mraa_*_lookup() functions. Call
+ * again whenever the board's pin or bus names change, the new index is
+ * swapped in atomically and the old one stays valid until the board is freed.
+ *
+ * @param board to index
+ * @return Result of the operation
+ */
+mraa_result_t mraa_build_lookup_index(mraa_board_t* board);
+
+/**
+ * Free the name hash tables of a board, including retired ones, lookups fall
+ * back to a linear scan. Only call when no lookup can run concurrently.
+ *
+ * @param board to clean up, may be NULL
+ */
+void mraa_free_lookup_index(mraa_board_t* board);
+
 /**
  * helper function to find an i2c bus based on pci data
  *
@@ -67,6 +67,16 @@
 #define IO_KEY "layout"
 #define PLATFORM_KEY "platform"
 #define BUS_KEY "bus"
+#define GPIO_MMAP_KEY "gpio_mmap"
+#define MEM_DEV_KEY "path"
+#define MEM_BASE_KEY "base"
+#define MEM_SIZE_KEY "size"
+#define GPIO_BASE_KEY "gpio_base"
+#define SET_REG_KEY "set"
+#define CLEAR_REG_KEY "clear"
+#define DATA_REG_KEY "data"
+#define BANK_STRIDE_KEY "bank_stride"
+#define BANK_WIDTH_KEY "bank_width"
 
 // IO keys
 #define AIO_KEY "a"
@@ -79,6 +89,7 @@
 #define UART_OW_KEY "ow"
 
 #define MRAA_JSONPLAT_ENV_VAR "MRAA_JSON_PLATFORM"
+#define MRAA_NO_AUTO_INIT_ENV_VAR "MRAA_NO_AUTO_INIT"
 
 #ifdef FIRMATA
 struct _firmata {
@@ -106,11 +117,26 @@ struct _gpio_group {
     unsigned int *gpio_group_to_pins_table;
 
     unsigned int flags;
+    /* Lines are requested through the GPIO v2 character device ABI. */
+    mraa_boolean_t uapi_v2;
 
     /* Event specific fields. */
     int *event_handles;
 };
 
+/**
+ * Ring buffer of edge events, filled by the isr thread.
+ */
+struct _gpio_event_queue {
+    mraa_gpio_edge_event *events; /**< ring storage */
+    unsigned int size; /**< capacity of the ring */
+    unsigned int head; /**< index of the oldest event */
+    unsigned int count; /**< number of queued events */
+    unsigned int seqno; /**< sequence number of the last event */
+    unsigned long dropped; /**< events lost because the ring or the kernel buffer was full */
+    pthread_mutex_t lock;
+};
+
 /**
  * A structure representing a gpio pin.
  */
@@ -118,6 +144,7 @@ struct _gpio {
     /*@{*/
     int pin; /**< the pin number, as known to the os. */
     int phy_pin; /**< pin passed to clean init. -1 none and raw*/
+    int event_pin; /**< pin reported in edge events, as given to the init function */
     int value_fp; /**< the file pointer to the value of the gpio */
     void (* isr)(void *); /**< the interrupt service request */
     void *isr_args; /**< args return when interrupt service request triggered */
@@ -130,6 +157,10 @@ struct _gpio {
     mraa_boolean_t owner; /**< If this context originally exported the pin */
     mraa_result_t (*mmap_write) (mraa_gpio_context dev, int value);
     int (*mmap_read) (mraa_gpio_context dev);
+    volatile uint32_t *mmap_set; /**< generic mmap backend: output set register */
+    volatile uint32_t *mmap_clear; /**< generic mmap backend: output clear register */
+    volatile uint32_t *mmap_data; /**< generic mmap backend: input level register */
+    uint32_t mmap_mask; /**< generic mmap backend: bit of the gpio in its bank */
     mraa_adv_func_t* advance_func; /**< override function table */
 #if defined(MOCKPLAT)
     mraa_gpio_dir_t mock_dir; /**< mock direction of the pin */
@@ -145,6 +176,9 @@ struct _gpio {
     int *pin_to_gpio_table;
     unsigned int num_pins;
     mraa_gpio_events_t events;
+    struct _gpio_event_queue *event_queue; /**< optional queue of edge events */
+    struct _gpio_dispatcher *isr_dispatcher; /**< shared isr thread serving this context, if any */
+    unsigned int event_seqno; /**< sequence number of the last event from mraa_gpio_read_events */
     int *provided_pins;
 
     struct _gpio *next;
@@ -162,6 +196,25 @@ struct _gpio {
         idx < num_chips && (cinfo = cinfos[idx]); \
         (idx++))
 
+struct _bus_arbiter;
+
+/** Register cache flags, see struct _i2c_regcache */
+#define MRAA_I2C_REG_VALID 0x01
+#define MRAA_I2C_REG_DIRTY 0x02
+#define MRAA_I2C_REG_VOLATILE 0x04
+
+/**
+ * Cached copy of the byte registers of an i2c device
+ */
+struct _i2c_regcache {
+    /*@{*/
+    unsigned int num_regs; /**< registers 0 to num_regs - 1 are covered */
+    uint8_t* values; /**< last value read or written */
+    uint8_t* flags; /**< MRAA_I2C_REG_* per register */
+    unsigned int num_dirty; /**< registers waiting for a sync */
+    /*@}*/
+};
+
 /**
  * A structure representing a I2C bus
  */
@@ -173,6 +226,22 @@ struct _i2c {
     unsigned long funcs; /**< /dev/i2c-* device capabilities as per https://www.kernel.org/doc/Documentation/i2c/functionality */
     void *handle; /**< generic handle for non-standard drivers that don't use file descriptors  */
     mraa_adv_func_t* advance_func; /**< override function table */
+    struct _bus_arbiter* arbiter; /**< serializes the contexts of this bus */
+    mraa_bus_priority_t priority; /**< arbiter priority class of this context */
+    struct _i2c_regcache* regcache; /**< optional register cache */
+    int kernel_addr; /**< slave address the fd currently targets */
+    mraa_boolean_t kernel_addr_set; /**< whether kernel_addr is known */
+    mraa_boolean_t pec; /**< whether SMBus PEC is enabled on the fd */
+    mraa_bus_ioctl_stats_t ioctl_stats; /**< ioctls made and skipped */
+    struct _board_t* board; /**< board the bus was looked up on, NULL for raw buses */
+    int sda_pos; /**< board pin of sda, -1 if unknown */
+    int scl_pos; /**< board pin of scl, -1 if unknown */
+    unsigned int failures; /**< transfers failed in a row */
+    mraa_boolean_t error_logged; /**< whether the current failure streak was logged */
+    unsigned int breaker_threshold; /**< failures opening the breaker, 0 if disabled */
+    unsigned int breaker_cooldown_ms; /**< time transfers fail fast once it opened */
+    mraa_boolean_t breaker_recover; /**< whether to recover the bus when it opens */
+    uint64_t breaker_until_ns; /**< CLOCK_MONOTONIC time it stays open until */
 #if defined(MOCKPLAT)
     uint8_t mock_dev_addr; /**< address of the mock I2C device */
     uint8_t mock_dev_data_len; /**< mock device data register block length in bytes */
@@ -185,6 +254,35 @@ struct _i2c {
 #endif
 };
 
+/**
+ * A message queued on an i2c transaction. Written bytes are copied to the
+ * transaction pool, read messages point to the caller's buffer.
+ */
+struct _i2c_txn_msg {
+    /*@{*/
+    uint16_t addr; /**< slave address */
+    uint16_t flags; /**< I2C_M_* flags */
+    int len; /**< number of bytes to transfer */
+    uint8_t* rbuf; /**< destination of a read */
+    size_t offset; /**< position of the written bytes in the pool */
+    /*@}*/
+};
+
+/**
+ * A batch of i2c messages submitted with one I2C_RDWR ioctl
+ */
+struct _i2c_txn {
+    /*@{*/
+    struct _i2c* dev; /**< context the transaction is submitted on */
+    struct _i2c_txn_msg* msgs; /**< queued messages */
+    unsigned int num_msgs; /**< number of queued messages */
+    unsigned int max_msgs; /**< allocated length of msgs */
+    uint8_t* pool; /**< copies of the bytes to write */
+    size_t pool_len; /**< bytes used in pool */
+    size_t pool_size; /**< bytes allocated for pool */
+    /*@}*/
+};
+
 /**
  * A structure representing the SPI device
  */
@@ -196,6 +294,13 @@ struct _spi {
     mraa_boolean_t lsb; /**< least significant bit mode */
     unsigned int bpw;   /**< Bits per word */
     mraa_adv_func_t* advance_func; /**< override function table */
+    int busnum;         /**< the bus number of the /dev/spidev* device */
+    struct _bus_arbiter* arbiter; /**< serializes the contexts of this bus */
+    mraa_bus_priority_t priority; /**< arbiter priority class of this context */
+    uint8_t* rx_pool; /**< receive buffer reused by mraa_spi_write_buf_pooled() */
+    int rx_pool_size; /**< allocated length of rx_pool */
+    struct _spi_kernel* kernel; /**< settings of the device node, shared by its contexts */
+    mraa_bus_ioctl_stats_t ioctl_stats; /**< ioctls made and skipped by this context */
     /*@}*/
 #ifdef PERIPHERALMAN
     ASpiDevice *bspi;
@@ -464,6 +569,60 @@ typedef struct {
     /*@}*/
 } mraa_led_dev_t;
 
+/**
+ * A memory mapped GPIO controller, described by its register layout so the
+ * generic mmap backend can drive it. Banks of bank_width gpios are bank_stride
+ * bytes apart.
+ */
+typedef struct {
+    /*@{*/
+    char mem_dev[32]; /**< Memory device to map, /dev/gpiomem etc */
+    uint64_t base; /**< Offset of the controller in mem_dev */
+    size_t size; /**< Size of memory to map */
+    int gpio_base; /**< sysfs number of the first gpio of the controller */
+    unsigned int set_reg; /**< Offset of the output set register of bank 0 */
+    unsigned int clear_reg; /**< Offset of the output clear register of bank 0 */
+    unsigned int data_reg; /**< Offset of the input level register of bank 0 */
+    unsigned int bank_stride; /**< Distance in bytes between two banks */
+    unsigned int bank_width; /**< Number of gpios per bank */
+    /*@}*/
+} mraa_gpio_mmap_desc_t;
+
+/**
+ * Kinds of names resolved by the mraa_*_lookup() functions.
+ */
+typedef enum {
+    MRAA_LOOKUP_GPIO = 0, /**< Pin names of gpio capable pins */
+    MRAA_LOOKUP_I2C = 1, /**< I2C bus names */
+    MRAA_LOOKUP_SPI = 2, /**< SPI bus names */
+    MRAA_LOOKUP_PWM = 3, /**< PWM device names */
+    MRAA_LOOKUP_UART = 4, /**< UART device names */
+    MRAA_LOOKUP_TYPES = 5 /**< Number of kinds */
+} mraa_lookup_type_t;
+
+/**
+ * Open addressed name hash, built once per board and read-only afterwards.
+ */
+typedef struct {
+    /*@{*/
+    const char** names; /**< Slot names, NULL if the slot is empty */
+    int* values; /**< Value returned by the lookup for each slot */
+    unsigned int mask; /**< Number of slots - 1, a power of two */
+    /*@}*/
+} mraa_lookup_table_t;
+
+/**
+ * The name hash tables of a board. A rebuild publishes a new index and keeps
+ * the one it replaced on the retired chain, since lookups read it unlocked,
+ * so old indexes are only freed with the board.
+ */
+typedef struct _lookup_index {
+    /*@{*/
+    mraa_lookup_table_t tables[MRAA_LOOKUP_TYPES]; /**< One table per mraa_lookup_type_t */
+    struct _lookup_index* retired; /**< Index replaced by this one, NULL if none */
+    /*@}*/
+} mraa_lookup_index_t;
+
 /**
  * A Structure representing a platform/board.
  */
@@ -502,6 +661,8 @@ typedef struct _board_t {
     mraa_boolean_t chardev_capable;  /**< Decide what interface is being used: old sysfs or new char device*/
     mraa_led_dev_t led_dev[MAX_LED_COUNT]; /**< Array of LED devices */
     unsigned int led_dev_count; /**< Total onboard LED device count */
+    mraa_gpio_mmap_desc_t* gpio_mmap; /**< Memory mapped GPIO controller, NULL if none */
+    mraa_lookup_index_t* lookup_index; /**< Name tables, NULL until built, read with __atomic_load_n */
     /*@}*/
 } mraa_board_t;
 
@@ -14,5 +14,6 @@ typedef struct {
 	void (*java_detach_thread)();
 	void* (*java_create_global_ref)(void* args);
 	void (*java_delete_global_ref)(void* ref);
+	void (*python_bus_callback)(void (*cb)(mraa_result_t, void*), mraa_result_t status, void* args);
 
 } mraa_lang_func_t;
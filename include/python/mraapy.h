@@ -7,4 +7,7 @@
 
 #pragma once
 
+#include "mraa/types.h"
+
 void mraa_python_isr(void (*isr)(void*), void* isr_args);
+void mraa_python_bus_callback(void (*cb)(mraa_result_t, void*), mraa_result_t status, void* args);
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "aio.h"
 #include "mraa_internal.h"
@@ -76,6 +77,8 @@ mraa_aio_init_internal(mraa_adv_func_t* func_table, int aio, unsigned int channe
 mraa_aio_context
 mraa_aio_init(unsigned int aio)
 {
+    mraa_init();
+
     mraa_board_t* board = plat;
     int pin;
     if (board == NULL) {
@@ -166,7 +169,7 @@ mraa_aio_read(mraa_aio_context dev)
         return dev->advance_func->aio_read_replace(dev);
     }
 
-    char buffer[17];
+    char buffer[16];
     if (dev->adc_in_fp == -1) {
         if (aio_get_valid_fp(dev) != MRAA_SUCCESS) {
             syslog(LOG_ERR, "aio: Failed to get to the device");
@@ -174,24 +177,19 @@ mraa_aio_read(mraa_aio_context dev)
         }
     }
 
-    lseek(dev->adc_in_fp, 0, SEEK_SET);
-    if (read(dev->adc_in_fp, buffer, sizeof(buffer)) < 1) {
+    /* Positional read keeps the fd at offset 0, no lseek around it. */
+    ssize_t rb = pread(dev->adc_in_fp, buffer, sizeof(buffer), 0);
+    if (rb < 1) {
         syslog(LOG_ERR, "aio: Failed to read a sensible value");
+        return -1;
     }
-    // force NULL termination of string
-    buffer[16] = '\0';
-    lseek(dev->adc_in_fp, 0, SEEK_SET);
-
-    errno = 0;
-    char* end;
-    unsigned int analog_value = (unsigned int) strtoul(buffer, &end, 10);
-    if (end == &buffer[0]) {
+
+    int raw_value;
+    if (mraa_parse_sysfs_int(buffer, rb, &raw_value) != MRAA_SUCCESS || raw_value < 0) {
         syslog(LOG_ERR, "aio: Value is not a decimal number");
         return -1;
-    } else if (errno != 0) {
-        syslog(LOG_ERR, "aio: Errno was set");
-        return -1;
     }
+    unsigned int analog_value = (unsigned int) raw_value;
 
     /* Adjust the raw analog input reading to supported resolution value*/
     if (raw_bits < dev->value_bit) {
@@ -46,7 +46,7 @@
 #define PLATFORM_RASPBERRY_PI4_B 13
 #define PLATFORM_RASPBERRY_PI_400 14
 #define PLATFORM_RASPBERRY_PI5_B 15
-#define MMAP_PATH "/dev/mem"
+#define GPIOMEM_PATH "/dev/gpiomem"
 #define BCM2835_PERI_BASE 0x20000000
 #define BCM2836_PERI_BASE 0x3f000000
 #define BCM2835_BLOCK_SIZE (4 * 1024)
@@ -56,6 +56,7 @@
 #define BCM283X_GPSET0 0x001c
 #define BCM283X_GPCLR0 0x0028
 #define BCM2835_GPLEV0 0x0034
+#define BCM283X_GPIO_BANK_STRIDE 4
 #define MAX_SIZE 64
 
 #define GPIO_OFFSET (0x200000)
@@ -82,12 +83,6 @@ static volatile unsigned* clk_reg = NULL;
 static volatile unsigned* gpio_reg = NULL;
 static volatile unsigned* pwm_reg = NULL;
 
-
-// GPIO MMAP
-static uint8_t* mmap_reg = NULL;
-static int mmap_fd = 0;
-static int mmap_size;
-static unsigned int mmap_count = 0;
 static int platform_detected = 0;
 static uint32_t peripheral_base = BCM2835_PERI_BASE;
 static uint32_t block_size = BCM2835_BLOCK_SIZE;
@@ -339,96 +334,6 @@ mraa_raspberry_pi_i2c_init_pre(unsigned int bus)
     return MRAA_SUCCESS;
 }
 
-mraa_result_t
-mraa_raspberry_pi_mmap_write(mraa_gpio_context dev, int value)
-{
-    if (value) {
-        *(volatile uint32_t*) (mmap_reg + BCM283X_GPSET0 + (dev->pin / 32) * 4) =
-        (uint32_t)(1 << (dev->pin % 32));
-    } else {
-        *(volatile uint32_t*) (mmap_reg + BCM283X_GPCLR0 + (dev->pin / 32) * 4) =
-        (uint32_t)(1 << (dev->pin % 32));
-    }
-    return MRAA_SUCCESS;
-}
-
-static mraa_result_t
-mraa_raspberry_pi_mmap_unsetup()
-{
-    if (mmap_reg == NULL) {
-        syslog(LOG_ERR, "raspberry mmap: null register cant unsetup");
-        return MRAA_ERROR_INVALID_RESOURCE;
-    }
-    munmap(mmap_reg, mmap_size);
-    mmap_reg = NULL;
-    if (close(mmap_fd) != 0) {
-        return MRAA_ERROR_INVALID_RESOURCE;
-    }
-    return MRAA_SUCCESS;
-}
-
-int
-mraa_raspberry_pi_mmap_read(mraa_gpio_context dev)
-{
-    uint32_t value = *(volatile uint32_t*) (mmap_reg + BCM2835_GPLEV0 + (dev->pin / 32) * 4);
-    if (value & (uint32_t)(1 << (dev->pin % 32))) {
-        return 1;
-    }
-    return 0;
-}
-
-mraa_result_t
-mraa_raspberry_pi_mmap_setup(mraa_gpio_context dev, mraa_boolean_t en)
-{
-    if (dev == NULL) {
-        syslog(LOG_ERR, "raspberry mmap: context not valid");
-        return MRAA_ERROR_INVALID_HANDLE;
-    }
-
-    if (en == 0) {
-        if (dev->mmap_write == NULL && dev->mmap_read == NULL) {
-            syslog(LOG_ERR, "raspberry mmap: can't disable disabled mmap gpio");
-            return MRAA_ERROR_INVALID_PARAMETER;
-        }
-        dev->mmap_write = NULL;
-        dev->mmap_read = NULL;
-        mmap_count--;
-        if (mmap_count == 0) {
-            return mraa_raspberry_pi_mmap_unsetup();
-        }
-        return MRAA_SUCCESS;
-    }
-
-    if (dev->mmap_write != NULL && dev->mmap_read != NULL) {
-        syslog(LOG_ERR, "raspberry mmap: can't enable enabled mmap gpio");
-        return MRAA_ERROR_INVALID_PARAMETER;
-    }
-
-    // Might need to make some elements of this thread safe.
-    // For example only allow one thread to enter the following block
-    // to prevent mmap'ing twice.
-    if (mmap_reg == NULL) {
-        if ((mmap_fd = open(MMAP_PATH, O_RDWR)) < 0) {
-            syslog(LOG_ERR, "raspberry map: unable to open resource0 file");
-            return MRAA_ERROR_INVALID_HANDLE;
-        }
-
-        mmap_reg = (uint8_t*) mmap(NULL, block_size, PROT_READ | PROT_WRITE, MAP_FILE | MAP_SHARED,
-                                   mmap_fd, peripheral_base + GPIO_OFFSET);
-        if (mmap_reg == MAP_FAILED) {
-            syslog(LOG_ERR, "raspberry mmap: failed to mmap");
-            mmap_reg = NULL;
-            close(mmap_fd);
-            return MRAA_ERROR_NO_RESOURCES;
-        }
-    }
-    dev->mmap_write = &mraa_raspberry_pi_mmap_write;
-    dev->mmap_read = &mraa_raspberry_pi_mmap_read;
-    mmap_count++;
-
-    return MRAA_SUCCESS;
-}
-
 mraa_board_t*
 mraa_raspberry_pi()
 {
@@ -668,9 +573,28 @@ mraa_raspberry_pi()
         }
     }
 
+    // The RP1 of the Pi 5 has a different register layout
+    if (platform_detected != PLATFORM_RASPBERRY_PI5_B) {
+        b->gpio_mmap = (mraa_gpio_mmap_desc_t*) calloc(1, sizeof(mraa_gpio_mmap_desc_t));
+        if (b->gpio_mmap == NULL) {
+            free(b->adv_func);
+            free(b);
+            return NULL;
+        }
+        // /dev/gpiomem exposes the GPIO block at offset 0 without root access
+        strncpy(b->gpio_mmap->mem_dev, GPIOMEM_PATH, sizeof(b->gpio_mmap->mem_dev) - 1);
+        b->gpio_mmap->base = 0;
+        b->gpio_mmap->size = block_size;
+        b->gpio_mmap->gpio_base = pin_base;
+        b->gpio_mmap->set_reg = BCM283X_GPSET0;
+        b->gpio_mmap->clear_reg = BCM283X_GPCLR0;
+        b->gpio_mmap->data_reg = BCM2835_GPLEV0;
+        b->gpio_mmap->bank_stride = BCM283X_GPIO_BANK_STRIDE;
+        b->gpio_mmap->bank_width = 32;
+    }
+
     b->adv_func->spi_init_pre = &mraa_raspberry_pi_spi_init_pre;
     b->adv_func->i2c_init_pre = &mraa_raspberry_pi_i2c_init_pre;
-    b->adv_func->gpio_mmap_setup = &mraa_raspberry_pi_mmap_setup;
     b->adv_func->pwm_init_raw_replace = &mraa_raspberry_pi_pwm_initraw_replace;
     b->adv_func->pwm_write_replace = &mraa_raspberry_pi_pwm_write_duty_replace;
     b->adv_func->pwm_period_replace = &mraa_raspberry_pi_pwm_period_us_replace;
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bus/bus_arbiter.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct _bus_arbiter {
+    mraa_bus_arbiter_type_t type;
+    int busnum;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t owner;
+    /* Nesting depth of the owner, 0 when the bus is free. */
+    unsigned int depth;
+    /* Per class tickets, a waiter is served when its ticket comes up. */
+    uint64_t next_ticket[MRAA_BUS_PRIORITY_COUNT];
+    uint64_t serving[MRAA_BUS_PRIORITY_COUNT];
+    mraa_bus_stats_t stats;
+    /* Asynchronous requests, run by a worker thread started on first use. */
+    struct _bus_async* queue_head;
+    struct _bus_async* queue_tail;
+    pthread_cond_t queue_cond;
+    mraa_boolean_t worker_running;
+    mraa_boolean_t worker_stop;
+    pthread_t worker;
+    /* Request the worker is running, idle_cond is signalled once it completed. */
+    struct _bus_async* running;
+    pthread_cond_t idle_cond;
+    struct _bus_arbiter* next;
+};
+
+static struct _bus_arbiter* arbiters = NULL;
+static pthread_mutex_t arbiters_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t
+mraa_bus_arbiter_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct _bus_arbiter*
+mraa_bus_arbiter_get(mraa_bus_arbiter_type_t type, int busnum)
+{
+    struct _bus_arbiter* arb;
+
+    pthread_mutex_lock(&arbiters_lock);
+    for (arb = arbiters; arb != NULL; arb = arb->next) {
+        if (arb->type == type && arb->busnum == busnum) {
+            break;
+        }
+    }
+    if (arb == NULL) {
+        arb = (struct _bus_arbiter*) calloc(1, sizeof(struct _bus_arbiter));
+        if (arb == NULL) {
+            syslog(LOG_CRIT, "bus arbiter: Failed to allocate memory for bus %d", busnum);
+        } else {
+            arb->type = type;
+            arb->busnum = busnum;
+            pthread_mutex_init(&arb->lock, NULL);
+            pthread_cond_init(&arb->cond, NULL);
+            pthread_cond_init(&arb->queue_cond, NULL);
+            pthread_cond_init(&arb->idle_cond, NULL);
+            arb->next = arbiters;
+            arbiters = arb;
+        }
+    }
+    pthread_mutex_unlock(&arbiters_lock);
+
+    return arb;
+}
+
+/* Whether a ticket of a class above priority is waiting. */
+static mraa_boolean_t
+mraa_bus_arbiter_preempted(struct _bus_arbiter* arb, mraa_bus_priority_t priority)
+{
+    for (int p = 0; p < (int) priority; p++) {
+        if (arb->next_ticket[p] != arb->serving[p]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void
+mraa_bus_arbiter_acquire(struct _bus_arbiter* arb, mraa_bus_priority_t priority)
+{
+    if (arb == NULL) {
+        return;
+    }
+    if ((unsigned int) priority >= MRAA_BUS_PRIORITY_COUNT) {
+        priority = MRAA_BUS_PRIORITY_NORMAL;
+    }
+
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&arb->lock);
+
+    if (arb->depth > 0 && pthread_equal(arb->owner, self)) {
+        arb->depth++;
+        pthread_mutex_unlock(&arb->lock);
+        return;
+    }
+
+    uint64_t ticket = arb->next_ticket[priority]++;
+    uint64_t waited = 0;
+    if (arb->depth > 0 || arb->serving[priority] != ticket || mraa_bus_arbiter_preempted(arb, priority)) {
+        uint64_t start = mraa_bus_arbiter_now_ns();
+        do {
+            pthread_cond_wait(&arb->cond, &arb->lock);
+        } while (arb->depth > 0 || arb->serving[priority] != ticket || mraa_bus_arbiter_preempted(arb, priority));
+        waited = mraa_bus_arbiter_now_ns() - start;
+        arb->stats.contended[priority]++;
+        arb->stats.wait_ns[priority] += waited;
+        if (waited > arb->stats.max_wait_ns[priority]) {
+            arb->stats.max_wait_ns[priority] = waited;
+        }
+    }
+
+    arb->serving[priority]++;
+    arb->owner = self;
+    arb->depth = 1;
+    arb->stats.transfers[priority]++;
+
+    pthread_mutex_unlock(&arb->lock);
+}
+
+mraa_result_t
+mraa_bus_arbiter_release(struct _bus_arbiter* arb)
+{
+    if (arb == NULL) {
+        return MRAA_SUCCESS;
+    }
+
+    pthread_mutex_lock(&arb->lock);
+    if (arb->depth == 0 || !pthread_equal(arb->owner, pthread_self())) {
+        pthread_mutex_unlock(&arb->lock);
+        syslog(LOG_ERR, "bus arbiter: bus %d released by a thread not holding it", arb->busnum);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    if (--arb->depth == 0) {
+        // every waiter re-checks its turn, there are few of them
+        pthread_cond_broadcast(&arb->cond);
+    }
+    pthread_mutex_unlock(&arb->lock);
+
+    return MRAA_SUCCESS;
+}
+
+void
+mraa_bus_arbiter_stats(struct _bus_arbiter* arb, mraa_bus_stats_t* stats)
+{
+    if (arb == NULL) {
+        memset(stats, 0, sizeof(mraa_bus_stats_t));
+        return;
+    }
+
+    pthread_mutex_lock(&arb->lock);
+    memcpy(stats, &arb->stats, sizeof(mraa_bus_stats_t));
+    pthread_mutex_unlock(&arb->lock);
+}
+
+unsigned int
+mraa_bus_arbiter_waiters(struct _bus_arbiter* arb)
+{
+    unsigned int waiters = 0;
+
+    if (arb == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&arb->lock);
+    for (int p = 0; p < MRAA_BUS_PRIORITY_COUNT; p++) {
+        waiters += (unsigned int) (arb->next_ticket[p] - arb->serving[p]);
+    }
+    pthread_mutex_unlock(&arb->lock);
+
+    return waiters;
+}
+
+static void
+mraa_bus_async_free(struct _bus_async* req)
+{
+    pthread_mutex_destroy(&req->lock);
+    pthread_cond_destroy(&req->cond);
+    free(req);
+}
+
+/* Hand the result of req to its callback and to whoever waits for it. */
+static void
+mraa_bus_async_complete(struct _bus_async* req, mraa_result_t status)
+{
+    if (req->cb != NULL) {
+        if (req->python && lang_func != NULL && lang_func->python_bus_callback != NULL) {
+            lang_func->python_bus_callback(req->cb, status, req->args);
+        } else {
+            req->cb(status, req->args);
+        }
+    }
+
+    if (req->detached) {
+        mraa_bus_async_free(req);
+    } else {
+        pthread_mutex_lock(&req->lock);
+        req->status = status;
+        req->done = 1;
+        pthread_cond_broadcast(&req->cond);
+        pthread_mutex_unlock(&req->lock);
+    }
+}
+
+static void*
+mraa_bus_arbiter_worker(void* arg)
+{
+    struct _bus_arbiter* arb = (struct _bus_arbiter*) arg;
+    mraa_boolean_t java_attached = 0;
+
+    // callbacks into a JVM need the thread attached for its whole life
+    if (lang_func != NULL && lang_func->java_attach_thread != NULL) {
+        java_attached = (lang_func->java_attach_thread() == MRAA_SUCCESS);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&arb->lock);
+        while (arb->queue_head == NULL && !arb->worker_stop) {
+            pthread_cond_wait(&arb->queue_cond, &arb->lock);
+        }
+        // the queue is drained before a stop is honoured
+        struct _bus_async* req = arb->queue_head;
+        if (req == NULL) {
+            arb->worker_running = 0;
+            pthread_mutex_unlock(&arb->lock);
+            break;
+        }
+        arb->queue_head = req->next;
+        if (arb->queue_head == NULL) {
+            arb->queue_tail = NULL;
+        }
+        arb->running = req;
+        pthread_mutex_unlock(&arb->lock);
+
+        mraa_bus_async_complete(req, req->run(req));
+
+        pthread_mutex_lock(&arb->lock);
+        arb->running = NULL;
+        pthread_cond_broadcast(&arb->idle_cond);
+        pthread_mutex_unlock(&arb->lock);
+    }
+
+    if (java_attached && lang_func->java_detach_thread != NULL) {
+        lang_func->java_detach_thread();
+    }
+    return NULL;
+}
+
+mraa_result_t
+mraa_bus_arbiter_submit(struct _bus_arbiter* arb, struct _bus_async* req, mraa_bus_async_t* handle)
+{
+    if (arb == NULL) {
+        free(req);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    pthread_mutex_init(&req->lock, NULL);
+    pthread_cond_init(&req->cond, NULL);
+    req->arb = arb;
+    req->detached = (handle == NULL);
+    req->next = NULL;
+
+    pthread_mutex_lock(&arb->lock);
+    if (!arb->worker_running) {
+        arb->worker_stop = 0;
+        if (pthread_create(&arb->worker, NULL, mraa_bus_arbiter_worker, arb) != 0) {
+            pthread_mutex_unlock(&arb->lock);
+            syslog(LOG_ERR, "bus arbiter: Failed to create worker for bus %d", arb->busnum);
+            mraa_bus_async_free(req);
+            return MRAA_ERROR_NO_RESOURCES;
+        }
+        arb->worker_running = 1;
+    }
+    if (arb->queue_tail != NULL) {
+        arb->queue_tail->next = req;
+    } else {
+        arb->queue_head = req;
+    }
+    arb->queue_tail = req;
+    pthread_cond_signal(&arb->queue_cond);
+    pthread_mutex_unlock(&arb->lock);
+
+    if (handle != NULL) {
+        *handle = req;
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_boolean_t
+mraa_bus_async_done(mraa_bus_async_t handle)
+{
+    if (handle == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&handle->lock);
+    mraa_boolean_t done = handle->done;
+    pthread_mutex_unlock(&handle->lock);
+
+    return done;
+}
+
+mraa_result_t
+mraa_bus_async_wait(mraa_bus_async_t handle)
+{
+    if (handle == NULL) {
+        syslog(LOG_ERR, "bus async: wait: handle is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    // a request left to run can't get the bus while the caller holds it
+    struct _bus_arbiter* arb = handle->arb;
+    pthread_mutex_lock(&arb->lock);
+    mraa_boolean_t owned = arb->depth > 0 && pthread_equal(arb->owner, pthread_self());
+    pthread_mutex_unlock(&arb->lock);
+
+    pthread_mutex_lock(&handle->lock);
+    if (owned && !handle->done) {
+        pthread_mutex_unlock(&handle->lock);
+        syslog(LOG_ERR, "bus async: wait: bus %d is held by the waiting thread", arb->busnum);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    while (!handle->done) {
+        pthread_cond_wait(&handle->cond, &handle->lock);
+    }
+    mraa_result_t status = handle->status;
+    pthread_mutex_unlock(&handle->lock);
+
+    mraa_bus_async_free(handle);
+    return status;
+}
+
+void
+mraa_bus_arbiter_cancel(struct _bus_arbiter* arb, void* owner)
+{
+    if (arb == NULL) {
+        return;
+    }
+
+    struct _bus_async* cancelled = NULL;
+    struct _bus_async** tail = &cancelled;
+
+    pthread_mutex_lock(&arb->lock);
+    struct _bus_async** link = &arb->queue_head;
+    arb->queue_tail = NULL;
+    while (*link != NULL) {
+        struct _bus_async* req = *link;
+        if (req->owner == owner) {
+            *link = req->next;
+            req->next = NULL;
+            *tail = req;
+            tail = &req->next;
+        } else {
+            arb->queue_tail = req;
+            link = &req->next;
+        }
+    }
+    // a callback stopping its own context runs on the worker, don't wait on it
+    if (!arb->worker_running || !pthread_equal(arb->worker, pthread_self())) {
+        while (arb->running != NULL && arb->running->owner == owner) {
+            pthread_cond_wait(&arb->idle_cond, &arb->lock);
+        }
+    }
+    pthread_mutex_unlock(&arb->lock);
+
+    while (cancelled != NULL) {
+        struct _bus_async* req = cancelled;
+        cancelled = req->next;
+        mraa_bus_async_complete(req, MRAA_ERROR_INVALID_RESOURCE);
+    }
+}
+
+void
+mraa_bus_arbiter_shutdown()
+{
+    // arbiters are only ever prepended, the list can be walked unlocked
+    pthread_mutex_lock(&arbiters_lock);
+    struct _bus_arbiter* arb = arbiters;
+    pthread_mutex_unlock(&arbiters_lock);
+
+    for (; arb != NULL; arb = arb->next) {
+        pthread_mutex_lock(&arb->lock);
+        if (!arb->worker_running) {
+            pthread_mutex_unlock(&arb->lock);
+            continue;
+        }
+        arb->worker_stop = 1;
+        pthread_cond_signal(&arb->queue_cond);
+        pthread_t worker = arb->worker;
+        mraa_boolean_t owned = arb->depth > 0 && pthread_equal(arb->owner, pthread_self());
+        pthread_mutex_unlock(&arb->lock);
+
+        // from a completion callback, or with the bus held, the worker can't be
+        // waited for; it exits by itself once its queue ran
+        if (owned || pthread_equal(worker, pthread_self())) {
+            pthread_detach(worker);
+        } else {
+            pthread_join(worker, NULL);
+        }
+    }
+}
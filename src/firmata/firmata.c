@@ -11,6 +11,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 
 t_firmata*
 firmata_new(const char* name)
@@ -29,9 +30,19 @@ firmata_new(const char* name)
         return NULL;
     }
 
+    // i2c waiters have deadlines on the monotonic clock
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&res->i2c_cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&res->i2c_lock, NULL);
+
     res->uart = mraa_uart_init_raw(name);
     if (res->uart == NULL) {
         syslog(LOG_ERR, "firmata: UART failed to setup");
+        pthread_cond_destroy(&res->i2c_cond);
+        pthread_mutex_destroy(&res->i2c_lock);
         free(res);
         return  NULL;
     }
@@ -52,6 +63,8 @@ void
 firmata_close(t_firmata* firmata)
 {
     mraa_uart_stop(firmata->uart);
+    pthread_cond_destroy(&firmata->i2c_cond);
+    pthread_mutex_destroy(&firmata->i2c_lock);
     free(firmata);
 }
 
@@ -234,12 +247,14 @@ firmata_endParse(t_firmata* firmata)
             int reg = (firmata->parse_buff[4] & 0x7f) | ((firmata->parse_buff[5] & 0x7f) << 7);
             int i = 6;
             int ii = 0;
-            if (pthread_spin_lock(&firmata->lock) != 0) syslog(LOG_ERR, "firmata: Fatal spinlock deadlock, skipping i2c msg");
-            for (; ii < (firmata->parse_count - 7) / 2; ii++) {
+            pthread_mutex_lock(&firmata->i2c_lock);
+            for (; addr <= 0xFF && ii < (firmata->parse_count - 7) / 2 && reg + ii <= 0xFF; ii++) {
                 firmata->i2cmsg[addr][reg+ii] = (firmata->parse_buff[i] & 0x7f) | ((firmata->parse_buff[i+1] & 0x7f) << 7);
                 i = i+2;
             }
-            if (pthread_spin_unlock(&firmata->lock) != 0) syslog(LOG_ERR, "firmata: Fatal spinlock deadlock");
+            // waiters check their own slot, there may be several requests in flight
+            pthread_cond_broadcast(&firmata->i2c_cond);
+            pthread_mutex_unlock(&firmata->i2c_lock);
         } else {
             if (firmata->devs != NULL) {
                 struct _firmata* devs = firmata->devs[0];
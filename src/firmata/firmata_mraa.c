@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
+#include <errno.h>
+#include <time.h>
 
 #include "firmata.h"
 #include "mraa_internal.h"
@@ -101,13 +103,29 @@ mraa_firmata_i2c_frequency(mraa_i2c_context dev, mraa_i2c_mode_t mode)
     return MRAA_ERROR_FEATURE_NOT_IMPLEMENTED;
 }
 
+/* Longest reply the firmware sends to a single i2c read request. */
+#define FIRMATA_I2C_MAX_READ 32
+/* How long a reply may take over the serial link. */
+#define FIRMATA_I2C_TIMEOUT_MS 100
+
+/*
+ * Mark the reply slots of a request as pending. Done before the request
+ * goes out, so a quick reply can't be overwritten.
+ */
+static void
+mraa_firmata_i2c_expect(int addr, int reg, int length)
+{
+    pthread_mutex_lock(&firmata_dev->i2c_lock);
+    for (int i = 0; i < length && reg + i <= 0xFF; i++) {
+        firmata_dev->i2cmsg[addr][reg + i] = -1;
+    }
+    pthread_mutex_unlock(&firmata_dev->i2c_lock);
+}
+
 static mraa_result_t
 mraa_firmata_send_i2c_read_req(mraa_i2c_context dev, int length)
 {
-    char* buffer = calloc(7, 0);
-    if (buffer == NULL) {
-        return MRAA_ERROR_NO_RESOURCES;
-    }
+    char buffer[7];
     buffer[0] = FIRMATA_START_SYSEX;
     buffer[1] = FIRMATA_I2C_REQUEST;
     buffer[2] = dev->addr;
@@ -118,25 +136,18 @@ mraa_firmata_send_i2c_read_req(mraa_i2c_context dev, int length)
     buffer[5] = (length >> 7) & 0x7f;
     buffer[6] = FIRMATA_END_SYSEX;
 
+    mraa_firmata_i2c_expect(dev->addr, 0, length);
     if (mraa_uart_write(firmata_dev->uart, buffer, 7) != 7) {
-        free(buffer);
         return MRAA_ERROR_UNSPECIFIED;
     }
 
-    // this needs a lock :)
-    memset(&firmata_dev->i2cmsg[dev->addr][0], -1, sizeof(int)*length);
-
-    free(buffer);
     return MRAA_SUCCESS;
 }
 
 static mraa_result_t
 mraa_firmata_send_i2c_read_reg_req(mraa_i2c_context dev, uint8_t command, int length)
 {
-    char* buffer = calloc(9, 0);
-    if (buffer == NULL) {
-        return MRAA_ERROR_NO_RESOURCES;
-    }
+    char buffer[9];
     buffer[0] = FIRMATA_START_SYSEX;
     buffer[1] = FIRMATA_I2C_REQUEST;
     buffer[2] = dev->addr;
@@ -150,35 +161,39 @@ mraa_firmata_send_i2c_read_reg_req(mraa_i2c_context dev, uint8_t command, int le
     buffer[7] = (length >> 7) & 0x7f;
     buffer[8] = FIRMATA_END_SYSEX;
 
+    mraa_firmata_i2c_expect(dev->addr, command, length);
     if (mraa_uart_write(firmata_dev->uart, buffer, 9) != 9) {
-        free(buffer);
         return MRAA_ERROR_UNSPECIFIED;
     }
 
-    // this needs a lock :)
-    memset(&firmata_dev->i2cmsg[dev->addr][command], -1, sizeof(int)*length);
-
-    free(buffer);
     return MRAA_SUCCESS;
 }
 
+/* Sleep until the pull thread stored the reply to (addr, reg). */
 static mraa_result_t
 mraa_firmata_i2c_wait(int addr, int reg)
 {
-    int i = 0;
-    if (pthread_spin_lock(&firmata_dev->lock) != 0) return MRAA_ERROR_UNSPECIFIED;
-    int res = firmata_dev->i2cmsg[addr][reg];
-    if (pthread_spin_unlock(&firmata_dev->lock) != 0) return MRAA_ERROR_UNSPECIFIED;
-    for (; res == -1; i++) {
-        if (i > 1000) {
-            return MRAA_ERROR_UNSPECIFIED;
+    mraa_result_t ret = MRAA_SUCCESS;
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += FIRMATA_I2C_TIMEOUT_MS / 1000;
+    deadline.tv_nsec += (FIRMATA_I2C_TIMEOUT_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&firmata_dev->i2c_lock);
+    while (firmata_dev->i2cmsg[addr][reg] == -1) {
+        if (pthread_cond_timedwait(&firmata_dev->i2c_cond, &firmata_dev->i2c_lock, &deadline) == ETIMEDOUT) {
+            ret = MRAA_ERROR_UNSPECIFIED;
+            break;
         }
-        usleep(50);
-        if (pthread_spin_lock(&firmata_dev->lock) != 0) return MRAA_ERROR_UNSPECIFIED;
-        res = firmata_dev->i2cmsg[addr][reg];
-        if (pthread_spin_unlock(&firmata_dev->lock) != 0) return MRAA_ERROR_UNSPECIFIED;
     }
-    return MRAA_SUCCESS;
+    pthread_mutex_unlock(&firmata_dev->i2c_lock);
+
+    return ret;
 }
 
 static int
@@ -214,20 +229,33 @@ mraa_firmata_i2c_read_word_data(mraa_i2c_context dev, uint8_t command)
 static int
 mraa_firmata_i2c_read_bytes_data(mraa_i2c_context dev, uint8_t command, uint8_t* data, int length)
 {
-    uint32_t *local_storage = (uint32_t*) calloc(length, sizeof(int));
-    if (mraa_firmata_send_i2c_read_reg_req(dev, command, length) == MRAA_SUCCESS) {
-        if (mraa_firmata_i2c_wait(dev->addr, command) == MRAA_SUCCESS) {
-            memcpy(local_storage, &firmata_dev->i2cmsg[dev->addr][command], sizeof(int)*length);
-            int x = 0;
-            for(; x<length; x++){
-                data[x] = (uint8_t) local_storage[x];
-            }
-            free(local_storage);
+    int off;
 
-            return length;
+    if (length <= 0 || command + length > 0x100) {
+        return 0;
+    }
+
+    // every chunk is requested before waiting, the replies stream back
+    // over the serial link instead of one round trip per chunk
+    for (off = 0; off < length; off += FIRMATA_I2C_MAX_READ) {
+        int chunk = length - off > FIRMATA_I2C_MAX_READ ? FIRMATA_I2C_MAX_READ : length - off;
+        if (mraa_firmata_send_i2c_read_reg_req(dev, command + off, chunk) != MRAA_SUCCESS) {
+            return 0;
         }
     }
-    return 0;
+    for (off = 0; off < length; off += FIRMATA_I2C_MAX_READ) {
+        if (mraa_firmata_i2c_wait(dev->addr, command + off) != MRAA_SUCCESS) {
+            return 0;
+        }
+    }
+
+    pthread_mutex_lock(&firmata_dev->i2c_lock);
+    for (off = 0; off < length; off++) {
+        data[off] = (uint8_t) firmata_dev->i2cmsg[dev->addr][command + off];
+    }
+    pthread_mutex_unlock(&firmata_dev->i2c_lock);
+
+    return length;
 }
 
 static int
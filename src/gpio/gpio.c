@@ -7,6 +7,8 @@
  */
 #include "gpio.h"
 #include "gpio/gpio_chardev.h"
+#include "gpio/gpio_dispatch.h"
+#include "gpio/gpio_mmap.h"
 #include "linux/gpio.h"
 #include "mraa_internal.h"
 
@@ -42,6 +44,43 @@ _mraa_gpio_get_valfp(mraa_gpio_context dev)
     return MRAA_SUCCESS;
 }
 
+/* Levels as written to a sysfs 'value' file. */
+static const char gpio_sysfs_levels[2] = { '0', '1' };
+
+static int
+_mraa_gpio_sysfs_read_value(mraa_gpio_context dev)
+{
+    char bu[2];
+
+    if (dev->value_fp == -1 && _mraa_gpio_get_valfp(dev) != MRAA_SUCCESS) {
+        return -1;
+    }
+
+    /* Positional read, no lseek needed. The value is a single digit. */
+    if (pread(dev->value_fp, bu, sizeof(bu), 0) < 1 || (bu[0] != '0' && bu[0] != '1')) {
+        syslog(LOG_ERR, "gpio%i: read: Failed to read a sensible value from sysfs: %s", dev->pin,
+               strerror(errno));
+        return -1;
+    }
+
+    return bu[0] - '0';
+}
+
+static mraa_result_t
+_mraa_gpio_sysfs_write_value(mraa_gpio_context dev, int value)
+{
+    if (dev->value_fp == -1 && _mraa_gpio_get_valfp(dev) != MRAA_SUCCESS) {
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    if (pwrite(dev->value_fp, &gpio_sysfs_levels[value ? 1 : 0], 1, 0) != 1) {
+        syslog(LOG_ERR, "gpio%i: write: Failed to write to 'value': %s", dev->pin, strerror(errno));
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+
+    return MRAA_SUCCESS;
+}
+
 void
 mraa_gpio_close_event_handles_sysfs(int fds[], int num_fds)
 {
@@ -60,6 +99,19 @@ mraa_gpio_close_event_handles_sysfs(int fds[], int num_fds)
     free(fds);
 }
 
+static void
+mraa_gpio_event_queue_free(mraa_gpio_context dev)
+{
+    if (dev->event_queue == NULL) {
+        return;
+    }
+
+    pthread_mutex_destroy(&dev->event_queue->lock);
+    free(dev->event_queue->events);
+    free(dev->event_queue);
+    dev->event_queue = NULL;
+}
+
 static mraa_gpio_context
 mraa_gpio_init_internal(mraa_adv_func_t* func_table, int pin)
 {
@@ -77,6 +129,7 @@ mraa_gpio_init_internal(mraa_adv_func_t* func_table, int pin)
 
     dev->advance_func = func_table;
     dev->pin = pin;
+    dev->event_pin = pin;
 
     if (IS_FUNC_DEFINED(dev, gpio_init_internal_replace)) {
         status = dev->advance_func->gpio_init_internal_replace(dev, pin);
@@ -149,13 +202,14 @@ init_internal_cleanup:
 mraa_gpio_context
 mraa_gpio_init_by_name(char* name)
 {
+    mraa_init();
+
     mraa_board_t* board = plat;
     mraa_gpio_context dev;
     mraa_gpiod_group_t gpio_group;
-    mraa_gpiod_line_info* linfo = NULL;
     mraa_gpiod_chip_info* cinfo;
-    mraa_gpiod_chip_info** cinfos;
-    int i, line_found, line_offset;
+    unsigned int chip_number, line_number;
+    int i, line_offset;
 
     if (name == NULL) {
         syslog(LOG_ERR, "[GPIOD_INTERFACE]: Gpio name not valid");
@@ -167,6 +221,13 @@ mraa_gpio_init_by_name(char* name)
         return NULL;
     }
 
+    /* Served from the chip/line cache, only the first lookup scans the chips. */
+    if (mraa_find_gpio_line_by_name(name, &chip_number, &line_number) != 0) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: Gpio not found!");
+        return NULL;
+    }
+    syslog(LOG_DEBUG, "[GPIOD_INTERFACE]: Chip: %u Line: %u", chip_number, line_number);
+
     dev = (mraa_gpio_context) calloc(1, sizeof(struct _gpio));
     if (dev == NULL) {
         syslog(LOG_CRIT, "[GPIOD_INTERFACE]: Failed to allocate memory for context");
@@ -180,10 +241,10 @@ mraa_gpio_init_by_name(char* name)
         return NULL;
     }
 
-    dev->num_chips = mraa_get_chip_infos(&cinfos);
-    if (dev->num_chips <= 0) {
-        mraa_gpio_close(dev);
-        return NULL;
+    /* Groups are indexed by chip number, which may be past the chip count. */
+    dev->num_chips = mraa_get_number_of_gpio_chips();
+    if (dev->num_chips <= (int) chip_number) {
+        dev->num_chips = chip_number + 1;
     }
 
     /* We are dealing with a single GPIO */
@@ -202,38 +263,30 @@ mraa_gpio_init_by_name(char* name)
         gpio_group[i].gpio_lines = NULL;
     }
 
-    /* Iterate over all gpiochips in the platform to find the requested line */
-    for_each_gpio_chip(cinfo, cinfos, dev->num_chips)
-    {
-        for (i = 0; i < cinfo->chip_info.lines; i++) {
-            linfo = mraa_get_line_info_by_chip_name(cinfo->chip_info.name, i);
-            if (!strncmp(linfo->name, name, 32)) {
-                /* idx is coming from `for_each_gpio_chip` definition */
-                syslog(LOG_DEBUG, "[GPIOD_INTERFACE]: Chip: %d Line: %d", idx, i);
-                if (!gpio_group[idx].is_required) {
-                    gpio_group[idx].dev_fd = cinfo->chip_fd;
-                    gpio_group[idx].is_required = 1;
-                    gpio_group[idx].gpiod_handle = -1;
-                }
-
-                /* Map pin to _gpio_group structure. */
-                dev->pin_to_gpio_table[0] = idx;
-                gpio_group[idx].gpio_lines = realloc(gpio_group[idx].gpio_lines, sizeof(unsigned int));
-                gpio_group[idx].gpio_lines[0] = i;
-                gpio_group[idx].num_gpio_lines++;
-
-                line_found = 1;
-                line_offset = i;
-
-                break;
-            }
-        }
+    cinfo = mraa_get_chip_info_by_number(chip_number);
+    if (!cinfo) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting gpio_chip_info for chip %u", chip_number);
+        mraa_gpio_close(dev);
+        return NULL;
     }
 
-    if (!line_found) {
-        syslog(LOG_ERR, "[GPIOD_INTERFACE]: Gpio not found!");
+    gpio_group[chip_number].dev_fd = cinfo->chip_fd;
+    gpio_group[chip_number].is_required = 1;
+    gpio_group[chip_number].gpiod_handle = -1;
+    gpio_group[chip_number].uapi_v2 = mraa_gpiod_has_uapi_v2(cinfo->chip_fd);
+    free(cinfo);
+
+    /* Map pin to _gpio_group structure. */
+    dev->pin_to_gpio_table[0] = chip_number;
+    gpio_group[chip_number].gpio_lines = malloc(sizeof(unsigned int));
+    if (gpio_group[chip_number].gpio_lines == NULL) {
+        syslog(LOG_CRIT, "[GPIOD_INTERFACE]: Failed to allocate memory for internal member");
+        mraa_gpio_close(dev);
         return NULL;
     }
+    gpio_group[chip_number].gpio_lines[0] = line_number;
+    gpio_group[chip_number].num_gpio_lines = 1;
+    line_offset = line_number;
 
     /* Initialize rw_values for read / write multiple functions */
     for (i = 0; i < dev->num_chips; ++i) {
@@ -244,6 +297,14 @@ mraa_gpio_init_by_name(char* name)
             return NULL;
         }
 
+        /* Single line, the reverse mapping always points to pin index 0. */
+        gpio_group[i].gpio_group_to_pins_table = calloc(gpio_group[i].num_gpio_lines, sizeof(int));
+        if (gpio_group[i].gpio_group_to_pins_table == NULL) {
+            syslog(LOG_CRIT, "[GPIOD_INTERFACE]: Failed to allocate memory for internal member");
+            mraa_gpio_close(dev);
+            return NULL;
+        }
+
         gpio_group[i].event_handles = NULL;
     }
 
@@ -265,7 +326,10 @@ mraa_gpio_init_by_name(char* name)
 mraa_gpio_context
 mraa_gpio_init(int pin)
 {
+    mraa_init();
+
     mraa_board_t* board = plat;
+    int init_pin = pin;
 
     if (board == NULL) {
         syslog(LOG_ERR, "gpio%i: init: platform not initialised", pin);
@@ -323,6 +387,7 @@ mraa_gpio_init(int pin)
 
     if (r->phy_pin == -1)
         r->phy_pin = pin;
+    r->event_pin = init_pin;
 
     if (IS_FUNC_DEFINED(r, gpio_init_post)) {
         mraa_result_t ret = r->advance_func->gpio_init_post(r);
@@ -423,6 +488,12 @@ mraa_gpio_chardev_init(int pins[], int num_pins)
         chip_id = board->pins[pins[i]].gpio.gpio_chip;
         line_offset = board->pins[pins[i]].gpio.gpio_line;
 
+        if (chip_id < 0 || chip_id >= dev->num_chips) {
+            syslog(LOG_ERR, "[GPIOD_INTERFACE]: init: gpiochip%d of pin %d not found", chip_id, pins[i]);
+            mraa_gpio_close(dev);
+            return NULL;
+        }
+
         /* Map pin to _gpio_group structure. */
         dev->pin_to_gpio_table[i] = chip_id;
 
@@ -437,6 +508,7 @@ mraa_gpio_chardev_init(int pins[], int num_pins)
             gpio_group[chip_id].dev_fd = cinfo->chip_fd;
             gpio_group[chip_id].is_required = 1;
             gpio_group[chip_id].gpiod_handle = -1;
+            gpio_group[chip_id].uapi_v2 = mraa_gpiod_has_uapi_v2(cinfo->chip_fd);
 
             free(cinfo);
         }
@@ -511,6 +583,8 @@ mraa_gpio_chardev_init(int pins[], int num_pins)
 mraa_gpio_context
 mraa_gpio_init_multi(int pins[], int num_pins)
 {
+    mraa_init();
+
     mraa_board_t* board = plat;
 
     if (board == NULL) {
@@ -552,6 +626,8 @@ mraa_gpio_init_multi(int pins[], int num_pins)
 mraa_gpio_context
 mraa_gpio_init_raw(int pin)
 {
+    mraa_init();
+
     return mraa_gpio_init_internal(plat == NULL ? NULL : plat->adv_func, pin);
 }
 
@@ -595,8 +671,7 @@ mraa_gpio_wait_interrupt(int fds[],
         pfd[i].events = POLLPRI;
 
         // do an initial read to clear interrupt
-        lseek(fds[i], 0, SEEK_SET);
-        read(fds[i], &c, 1);
+        pread(fds[i], &c, 1, 0);
     }
 
 #ifdef HAVE_PTHREAD_CANCEL
@@ -624,11 +699,126 @@ mraa_gpio_wait_interrupt(int fds[],
     return MRAA_SUCCESS;
 }
 
+static void
+mraa_gpio_event_queue_push(struct _gpio_event_queue* queue, int pin, mraa_gpio_edge_t edge, mraa_timestamp_t timestamp, unsigned int lost)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    /* Events lost by the kernel still consume sequence numbers. */
+    queue->seqno += lost;
+    queue->dropped += lost;
+    queue->seqno++;
+
+    if (queue->count == queue->size) {
+        queue->dropped++;
+    } else {
+        mraa_gpio_edge_event* event = &queue->events[(queue->head + queue->count) % queue->size];
+        event->pin = pin;
+        event->edge = edge;
+        event->timestamp = timestamp;
+        event->seqno = queue->seqno;
+        queue->count++;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static mraa_timestamp_t
+_mraa_gpio_get_timestamp_monotonic()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (mraa_timestamp_t) time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+static void
+mraa_gpio_sysfs_queue_events(mraa_gpio_context dev, int fds[], int pins[], int num_fds)
+{
+    /* sysfs has no event buffer, timestamp as close to the wakeup as possible. */
+    mraa_timestamp_t timestamp = _mraa_gpio_get_timestamp_monotonic();
+    char c;
+
+    for (int i = 0; i < num_fds; ++i) {
+        if (dev->events[i].id == -1) {
+            continue;
+        }
+
+        if (pread(fds[i], &c, 1, 0) != 1) {
+            continue;
+        }
+
+        mraa_gpio_event_queue_push(dev->event_queue, pins[i],
+                                   c == '1' ? MRAA_GPIO_EDGE_RISING : MRAA_GPIO_EDGE_FALLING,
+                                   timestamp, 0);
+    }
+}
+
+void
+mraa_gpio_sysfs_read_event(mraa_gpio_context dev, mraa_gpio_events_t events, int fd, int idx, int pin)
+{
+    char c;
+
+    /* Reading back the value also re-arms the sysfs notification. */
+    if (pread(fd, &c, 1, 0) != 1) {
+        return;
+    }
+
+    if (events != NULL) {
+        events[idx].id = idx;
+        events[idx].timestamp = _mraa_gpio_get_timestamp_sysfs();
+    }
+
+    if (dev->event_queue) {
+        mraa_gpio_event_queue_push(dev->event_queue, pin,
+                                   c == '1' ? MRAA_GPIO_EDGE_RISING : MRAA_GPIO_EDGE_FALLING,
+                                   _mraa_gpio_get_timestamp_monotonic(), 0);
+    }
+}
+
+void
+mraa_gpio_chardev_read_events(mraa_gpio_context dev, mraa_gpio_events_t events, int fd, int idx, int pin, unsigned int* line_seqno, mraa_boolean_t uapi_v2)
+{
+    mraa_gpiod_line_event event_data[MRAA_GPIOD_EVENTS_PER_READ];
+    int num;
+
+    if (dev->event_queue == NULL) {
+        num = mraa_read_line_events(fd, uapi_v2, event_data, 1);
+        if (events != NULL) {
+            events[idx].id = idx;
+            events[idx].timestamp = num > 0 ? event_data[0].timestamp : 0;
+        }
+        return;
+    }
+
+    /* The fds are non-blocking in queue mode, drain everything the kernel buffered. */
+    while ((num = mraa_read_line_events(fd, uapi_v2, event_data, MRAA_GPIOD_EVENTS_PER_READ)) > 0) {
+        for (int j = 0; j < num; ++j) {
+            unsigned int lost = 0;
+
+            if (uapi_v2 && *line_seqno != 0 && event_data[j].line_seqno > *line_seqno + 1) {
+                lost = event_data[j].line_seqno - *line_seqno - 1;
+            }
+            *line_seqno = event_data[j].line_seqno;
+
+            mraa_gpio_event_queue_push(dev->event_queue, pin,
+                                       event_data[j].id == GPIOEVENT_EVENT_RISING_EDGE ?
+                                       MRAA_GPIO_EDGE_RISING :
+                                       MRAA_GPIO_EDGE_FALLING,
+                                       event_data[j].timestamp, lost);
+        }
+
+        if (events != NULL) {
+            events[idx].id = idx;
+            events[idx].timestamp = event_data[num - 1].timestamp;
+        }
+    }
+}
+
 static mraa_result_t
-mraa_gpio_chardev_wait_interrupt(int fds[], int num_fds, mraa_gpio_events_t events)
+mraa_gpio_chardev_wait_interrupt(mraa_gpio_context dev, int fds[], int pins[], unsigned int line_seqnos[], int num_fds, mraa_boolean_t uapi_v2)
 {
     struct pollfd pfd[num_fds];
-    struct gpioevent_data event_data;
 
     if (!fds) {
         return MRAA_ERROR_INVALID_PARAMETER;
@@ -637,19 +827,15 @@ mraa_gpio_chardev_wait_interrupt(int fds[], int num_fds, mraa_gpio_events_t even
     for (int i = 0; i < num_fds; ++i) {
         pfd[i].fd = fds[i];
         pfd[i].events = POLLIN;
-
-        lseek(fds[i], 0, SEEK_SET);
     }
 
     poll(pfd, num_fds, -1);
 
     for (int i = 0; i < num_fds; ++i) {
         if (pfd[i].revents & POLLIN) {
-            read(fds[i], &event_data, sizeof(event_data));
-            events[i].id = i;
-            events[i].timestamp = event_data.timestamp;
+            mraa_gpio_chardev_read_events(dev, dev->events, fds[i], i, pins[i], &line_seqnos[i], uapi_v2);
         } else
-            events[i].id = -1;
+            dev->events[i].id = -1;
     }
 
     return MRAA_SUCCESS;
@@ -695,6 +881,264 @@ mraa_gpio_get_events(mraa_gpio_context dev)
     return dev->events;
 }
 
+/* sysfs value fds handed out for external polling, opened on first use. */
+static int
+mraa_gpio_sysfs_event_fd(mraa_gpio_context it)
+{
+    char bu[MAX_SIZE];
+    char c;
+
+    if (it->isr_value_fp != -1) {
+        return it->isr_value_fp;
+    }
+
+    snprintf(bu, MAX_SIZE, SYSFS_CLASS_GPIO "/gpio%d/value", it->pin);
+    it->isr_value_fp = open(bu, O_RDONLY | O_NONBLOCK);
+    if (it->isr_value_fp < 0) {
+        syslog(LOG_ERR, "gpio%i: get_event_fds: failed to open 'value' : %s", it->pin, strerror(errno));
+        it->isr_value_fp = -1;
+        return -1;
+    }
+
+    // do an initial read to clear interrupt
+    pread(it->isr_value_fp, &c, 1, 0);
+
+    return it->isr_value_fp;
+}
+
+/* The value fds handed out by mraa_gpio_get_event_fds() go with the edge mode. */
+static void
+mraa_gpio_close_sysfs_event_fds(mraa_gpio_context dev)
+{
+    for (mraa_gpio_context it = dev; it; it = it->next) {
+        if (it->isr_value_fp >= 0) {
+            close(it->isr_value_fp);
+        }
+        it->isr_value_fp = -1;
+    }
+}
+
+int
+mraa_gpio_get_event_fds(mraa_gpio_context dev, int fds[], unsigned int max, short* poll_events)
+{
+    unsigned int num = 0;
+
+    if (dev == NULL || fds == NULL) {
+        syslog(LOG_ERR, "gpio: get_event_fds: context is invalid");
+        return -1;
+    }
+
+    // the isr thread already consumes the events
+    if (dev->thread_id != 0 || dev->isr_dispatcher != NULL) {
+        syslog(LOG_ERR, "gpio: get_event_fds: an isr is already set on this context");
+        return -1;
+    }
+
+    if (max < dev->num_pins) {
+        syslog(LOG_ERR, "gpio: get_event_fds: room for %d fds is needed", dev->num_pins);
+        return -1;
+    }
+
+    if (plat->chardev_capable) {
+        mraa_gpiod_group_t gpio_group;
+
+        for_each_gpio_group(gpio_group, dev)
+        {
+            if (gpio_group->event_handles == NULL) {
+                syslog(LOG_ERR, "gpio: get_event_fds: edge mode is not set");
+                return -1;
+            }
+
+            for (int i = 0; i < gpio_group->num_gpio_lines; ++i) {
+                fcntl(gpio_group->event_handles[i], F_SETFL, O_NONBLOCK);
+                fds[num++] = gpio_group->event_handles[i];
+            }
+        }
+    } else {
+        for (mraa_gpio_context it = dev; it; it = it->next) {
+            fds[num] = mraa_gpio_sysfs_event_fd(it);
+            if (fds[num] < 0) {
+                return -1;
+            }
+            num++;
+        }
+    }
+
+    /* sysfs value fds are always readable, edges are signalled with POLLPRI. */
+    if (poll_events != NULL) {
+        *poll_events = plat->chardev_capable ? POLLIN : POLLPRI;
+    }
+
+    return num;
+}
+
+int
+mraa_gpio_read_events(mraa_gpio_context dev, mraa_gpio_edge_event* events, unsigned int max)
+{
+    mraa_gpiod_line_event event_data[MRAA_GPIOD_EVENTS_PER_READ];
+    unsigned int num = 0;
+    int ret;
+
+    if (dev == NULL || events == NULL) {
+        syslog(LOG_ERR, "gpio: read_events: context is invalid");
+        return -1;
+    }
+
+    if (dev->thread_id != 0 || dev->isr_dispatcher != NULL) {
+        syslog(LOG_ERR, "gpio: read_events: an isr is already set on this context");
+        return -1;
+    }
+
+    if (plat->chardev_capable) {
+        mraa_gpiod_group_t gpio_group;
+
+        for_each_gpio_group(gpio_group, dev)
+        {
+            if (gpio_group->event_handles == NULL) {
+                syslog(LOG_ERR, "gpio: read_events: edge mode is not set");
+                return -1;
+            }
+
+            for (int i = 0; i < gpio_group->num_gpio_lines && num < max; ++i) {
+                int pin = dev->provided_pins[gpio_group->gpio_group_to_pins_table[i]];
+
+                fcntl(gpio_group->event_handles[i], F_SETFL, O_NONBLOCK);
+                while (num < max) {
+                    ret = mraa_read_line_events(gpio_group->event_handles[i], gpio_group->uapi_v2,
+                                                event_data, max - num);
+                    if (ret < 0) {
+                        syslog(LOG_ERR, "gpio%i: read_events: read failed: %s", pin, strerror(errno));
+                        return -1;
+                    }
+                    if (ret == 0) {
+                        break;
+                    }
+
+                    for (int j = 0; j < ret; ++j, ++num) {
+                        events[num].pin = pin;
+                        events[num].edge = event_data[j].id == GPIOEVENT_EVENT_RISING_EDGE ?
+                                           MRAA_GPIO_EDGE_RISING :
+                                           MRAA_GPIO_EDGE_FALLING;
+                        events[num].timestamp = event_data[j].timestamp;
+                        events[num].seqno = ++dev->event_seqno;
+                    }
+                }
+            }
+        }
+    } else {
+        for (mraa_gpio_context it = dev; it && num < max; it = it->next) {
+            struct pollfd pfd;
+            char c;
+
+            pfd.fd = mraa_gpio_sysfs_event_fd(it);
+            if (pfd.fd < 0) {
+                return -1;
+            }
+            pfd.events = POLLPRI;
+
+            if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLPRI)) {
+                continue;
+            }
+
+            // reading back the value re-arms the notification
+            if (pread(pfd.fd, &c, 1, 0) != 1) {
+                continue;
+            }
+
+            events[num].pin = it->event_pin;
+            events[num].edge = c == '1' ? MRAA_GPIO_EDGE_RISING : MRAA_GPIO_EDGE_FALLING;
+            events[num].timestamp = _mraa_gpio_get_timestamp_monotonic();
+            events[num].seqno = ++dev->event_seqno;
+            num++;
+        }
+    }
+
+    return num;
+}
+
+mraa_result_t
+mraa_gpio_event_queue_init(mraa_gpio_context dev, unsigned int size)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "gpio: event_queue_init: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (size == 0) {
+        syslog(LOG_ERR, "gpio: event_queue_init: size must be non-zero");
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    // the isr thread owns the queue while it runs
+    if (dev->thread_id != 0 || dev->isr_dispatcher != NULL) {
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    struct _gpio_event_queue* queue = calloc(1, sizeof(struct _gpio_event_queue));
+    if (queue == NULL) {
+        syslog(LOG_ERR, "gpio: event_queue_init: malloc error");
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    queue->events = malloc(size * sizeof(mraa_gpio_edge_event));
+    if (queue->events == NULL) {
+        syslog(LOG_ERR, "gpio: event_queue_init: malloc error");
+        free(queue);
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    queue->size = size;
+    pthread_mutex_init(&queue->lock, NULL);
+
+    mraa_gpio_event_queue_free(dev);
+    dev->event_queue = queue;
+
+    return MRAA_SUCCESS;
+}
+
+int
+mraa_gpio_event_queue_pop(mraa_gpio_context dev, mraa_gpio_edge_event* events, unsigned int max)
+{
+    if (dev == NULL || dev->event_queue == NULL) {
+        syslog(LOG_ERR, "gpio: event_queue_pop: context has no event queue");
+        return -1;
+    }
+
+    if (events == NULL) {
+        return 0;
+    }
+
+    struct _gpio_event_queue* queue = dev->event_queue;
+    unsigned int num;
+
+    pthread_mutex_lock(&queue->lock);
+    num = queue->count < max ? queue->count : max;
+    for (unsigned int i = 0; i < num; ++i) {
+        events[i] = queue->events[queue->head];
+        queue->head = (queue->head + 1) % queue->size;
+    }
+    queue->count -= num;
+    pthread_mutex_unlock(&queue->lock);
+
+    return num;
+}
+
+unsigned long
+mraa_gpio_event_queue_dropped(mraa_gpio_context dev)
+{
+    unsigned long dropped;
+
+    if (dev == NULL || dev->event_queue == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&dev->event_queue->lock);
+    dropped = dev->event_queue->dropped;
+    pthread_mutex_unlock(&dev->event_queue->lock);
+
+    return dropped;
+}
+
 static void*
 mraa_gpio_interrupt_handler(void* arg)
 {
@@ -718,6 +1162,18 @@ mraa_gpio_interrupt_handler(void* arg)
         return NULL;
     }
 
+    /* Pin number and last kernel sequence number of each polled fd. */
+    int* pins = calloc(dev->num_pins, sizeof(int));
+    unsigned int* line_seqnos = calloc(dev->num_pins, sizeof(unsigned int));
+    if (!pins || !line_seqnos) {
+        syslog(LOG_ERR, "mraa_gpio_interrupt_handler_multiple() malloc error");
+        free(fps);
+        free(pins);
+        free(line_seqnos);
+        return NULL;
+    }
+    mraa_boolean_t uapi_v2 = 0;
+
     /* Is this pin on a subplatform? Do nothing... */
     if (mraa_is_sub_platform_id(dev->pin)) {
     }
@@ -727,7 +1183,12 @@ mraa_gpio_interrupt_handler(void* arg)
 
         for_each_gpio_group(gpio_group, dev)
         {
+            uapi_v2 = gpio_group->uapi_v2;
             for (int i = 0; i < gpio_group->num_gpio_lines; ++i) {
+                if (dev->event_queue) {
+                    fcntl(gpio_group->event_handles[i], F_SETFL, O_NONBLOCK);
+                }
+                pins[idx] = dev->provided_pins[gpio_group->gpio_group_to_pins_table[i]];
                 fps[idx++] = gpio_group->event_handles[i];
             }
         }
@@ -745,9 +1206,12 @@ mraa_gpio_interrupt_handler(void* arg)
                 syslog(LOG_ERR, "gpio%i: interrupt_handler: failed to open 'value' : %s", it->pin,
                        strerror(errno));
                 mraa_gpio_close_event_handles_sysfs(fps, idx);
+                free(pins);
+                free(line_seqnos);
                 return NULL;
             }
 
+            pins[idx] = it->event_pin;
             idx++;
             it = it->next;
         }
@@ -758,6 +1222,8 @@ mraa_gpio_interrupt_handler(void* arg)
         syslog(LOG_ERR, "gpio%i: interrupt_handler: failed to create isr control pipe: %s",
                dev->pin, strerror(errno));
         mraa_gpio_close_event_handles_sysfs(fps, dev->num_pins);
+        free(pins);
+        free(line_seqnos);
         return NULL;
     }
 #endif
@@ -766,6 +1232,8 @@ mraa_gpio_interrupt_handler(void* arg)
         if (dev->isr == lang_func->java_isr_callback) {
             if (lang_func->java_attach_thread() != MRAA_SUCCESS) {
                 mraa_gpio_close_event_handles_sysfs(fps, dev->num_pins);
+                free(pins);
+                free(line_seqnos);
                 return NULL;
             }
         }
@@ -776,7 +1244,7 @@ mraa_gpio_interrupt_handler(void* arg)
             ret = dev->advance_func->gpio_wait_interrupt_replace(dev);
         } else {
             if (plat->chardev_capable) {
-                ret = mraa_gpio_chardev_wait_interrupt(fps, idx, dev->events);
+                ret = mraa_gpio_chardev_wait_interrupt(dev, fps, pins, line_seqnos, idx, uapi_v2);
             } else {
                 ret = mraa_gpio_wait_interrupt(fps, idx
 #ifndef HAVE_PTHREAD_CANCEL
@@ -785,6 +1253,9 @@ mraa_gpio_interrupt_handler(void* arg)
 #endif
                                                ,
                                                dev->events);
+                if (ret == MRAA_SUCCESS && dev->event_queue) {
+                    mraa_gpio_sysfs_queue_events(dev, fps, pins, idx);
+                }
             }
         }
 
@@ -806,6 +1277,8 @@ mraa_gpio_interrupt_handler(void* arg)
             pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 #endif
             mraa_gpio_close_event_handles_sysfs(fps, dev->num_pins);
+            free(pins);
+            free(line_seqnos);
 
             if (lang_func->java_detach_thread != NULL && lang_func->java_delete_global_ref != NULL) {
                 if (dev->isr == lang_func->java_isr_callback) {
@@ -836,16 +1309,21 @@ mraa_gpio_chardev_edge_mode(mraa_gpio_context dev, mraa_gpio_edge_t mode)
     mraa_gpiod_group_t gpio_group;
 
     struct gpioevent_request req;
+    uint64_t flags_v2 = GPIO_V2_LINE_FLAG_INPUT;
+    unsigned buffer_size = dev->event_queue ? dev->event_queue->size : 0;
 
     switch (mode) {
         case MRAA_GPIO_EDGE_BOTH:
             req.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+            flags_v2 |= GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
             break;
         case MRAA_GPIO_EDGE_RISING:
             req.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+            flags_v2 |= GPIO_V2_LINE_FLAG_EDGE_RISING;
             break;
         case MRAA_GPIO_EDGE_FALLING:
             req.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE;
+            flags_v2 |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
             break;
         /* Chardev interface doesn't handle EDGE_NONE. */
         case MRAA_GPIO_EDGE_NONE:
@@ -867,6 +1345,19 @@ mraa_gpio_chardev_edge_mode(mraa_gpio_context dev, mraa_gpio_edge_t mode)
         }
 
         for (int i = 0; i < gpio_group->num_gpio_lines; ++i) {
+            /* The v2 ABI lets us size the kernel event buffer to the queue. */
+            if (gpio_group->uapi_v2) {
+                status = mraa_get_line_event_handle_v2(gpio_group->dev_fd, gpio_group->gpio_lines[i],
+                                                       flags_v2, buffer_size);
+                if (status < 0) {
+                    syslog(LOG_ERR, "error getting line event handle for line %i", gpio_group->gpio_lines[i]);
+                    return MRAA_ERROR_INVALID_RESOURCE;
+                }
+
+                gpio_group->event_handles[i] = status;
+                continue;
+            }
+
             req.lineoffset = gpio_group->gpio_lines[i];
             req.handleflags = GPIOHANDLE_REQUEST_INPUT;
 
@@ -975,7 +1466,7 @@ mraa_gpio_isr(mraa_gpio_context dev, mraa_gpio_edge_t mode, void (*fptr)(void*),
     }
 
     // we only allow one isr per mraa_gpio_context
-    if (dev->thread_id != 0) {
+    if (dev->thread_id != 0 || dev->isr_dispatcher != NULL) {
         return MRAA_ERROR_NO_RESOURCES;
     }
 
@@ -1000,6 +1491,13 @@ mraa_gpio_isr(mraa_gpio_context dev, mraa_gpio_edge_t mode, void (*fptr)(void*),
 
     dev->isr_args = args;
 
+    /* Platform specific interrupt handling and sub-platform pins keep their own thread. */
+    if (mraa_gpio_dispatch_enabled() && !mraa_is_sub_platform_id(dev->pin) &&
+        !IS_FUNC_DEFINED(dev, gpio_interrupt_handler_init_replace) &&
+        !IS_FUNC_DEFINED(dev, gpio_wait_interrupt_replace)) {
+        return mraa_gpio_dispatch_register(dev);
+    }
+
     pthread_create(&dev->thread_id, NULL, mraa_gpio_interrupt_handler, (void*) dev);
 
     return MRAA_SUCCESS;
@@ -1019,12 +1517,22 @@ mraa_gpio_isr_exit(mraa_gpio_context dev)
     }
 
     // wasting our time, there is no isr to exit from
-    if (dev->thread_id == 0) {
+    if (dev->thread_id == 0 && dev->isr_dispatcher == NULL) {
+        mraa_gpio_close_sysfs_event_fds(dev);
         return ret;
     }
     // mark the beginning of the thread termination process for interested parties
     dev->isr_thread_terminating = 1;
 
+    // the shared thread must stop polling the fds before they get closed
+    if (dev->isr_dispatcher != NULL) {
+        mraa_gpio_dispatch_unregister(dev);
+
+        if (lang_func->java_delete_global_ref != NULL && dev->isr == lang_func->java_isr_callback) {
+            lang_func->java_delete_global_ref(dev->isr_args);
+        }
+    }
+
     // stop isr being useful
     if (plat && (plat->chardev_capable))
         _mraa_close_gpio_event_handles(dev);
@@ -1048,7 +1556,8 @@ mraa_gpio_isr_exit(mraa_gpio_context dev)
 
     // assume our thread will exit either way we just lost it's handle
     dev->thread_id = 0;
-    dev->isr_value_fp = -1;
+
+    mraa_gpio_close_sysfs_event_fds(dev);
     dev->isr_thread_terminating = 0;
 
     if (dev->events) {
@@ -1087,7 +1596,7 @@ mraa_gpio_mode(mraa_gpio_context dev, mraa_gpio_mode_t mode)
         for_each_gpio_group(gpio_iter, dev)
         {
             mraa_gpiod_line_info* linfo =
-            mraa_get_line_info_by_chip_number(gpio_iter->gpio_chip, gpio_iter->gpio_lines[0]);
+            mraa_get_line_info_from_descriptor(gpio_iter->dev_fd, gpio_iter->gpio_lines[0]);
             if (!linfo) {
                 syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting line info");
                 return MRAA_ERROR_UNSPECIFIED;
@@ -1116,14 +1625,11 @@ mraa_gpio_mode(mraa_gpio_context dev, mraa_gpio_mode_t mode)
 
         for_each_gpio_group(gpio_iter, dev)
         {
-            line_handle = mraa_get_lines_handle(gpio_iter->dev_fd, gpio_iter->gpio_lines,
-                                                gpio_iter->num_gpio_lines, flags, 0);
+            line_handle = _mraa_gpiod_group_request(gpio_iter, flags);
             if (line_handle <= 0) {
                 syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting line handle");
                 return MRAA_ERROR_INVALID_RESOURCE;
             }
-
-            gpio_iter->gpiod_handle = line_handle;
         }
     } else {
 
@@ -1185,7 +1691,7 @@ mraa_gpio_chardev_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir)
     for_each_gpio_group(gpio_iter, dev)
     {
         mraa_gpiod_line_info* linfo =
-        mraa_get_line_info_by_chip_number(gpio_iter->gpio_chip, gpio_iter->gpio_lines[0]);
+        mraa_get_line_info_from_descriptor(gpio_iter->dev_fd, gpio_iter->gpio_lines[0]);
         if (!linfo) {
             syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting line info");
             return MRAA_ERROR_UNSPECIFIED;
@@ -1217,14 +1723,11 @@ mraa_gpio_chardev_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir)
             gpio_iter->gpiod_handle = -1;
         }
 
-        line_handle = mraa_get_lines_handle(gpio_iter->dev_fd, gpio_iter->gpio_lines,
-                                            gpio_iter->num_gpio_lines, flags, 0);
+        line_handle = _mraa_gpiod_group_request(gpio_iter, flags);
         if (line_handle <= 0) {
             syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting line handle");
             return MRAA_ERROR_INVALID_RESOURCE;
         }
-
-        gpio_iter->gpiod_handle = line_handle;
     }
 
     return MRAA_SUCCESS;
@@ -1366,7 +1869,7 @@ mraa_gpio_read_dir(mraa_gpio_context dev, mraa_gpio_dir_t* dir)
         for_each_gpio_group(gpio_iter, dev)
         {
             mraa_gpiod_line_info* linfo =
-            mraa_get_line_info_by_chip_number(gpio_iter->gpio_chip, gpio_iter->gpio_lines[0]);
+            mraa_get_line_info_from_descriptor(gpio_iter->dev_fd, gpio_iter->gpio_lines[0]);
             if (!linfo) {
                 syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting line info");
                 return MRAA_ERROR_UNSPECIFIED;
@@ -1425,6 +1928,10 @@ mraa_gpio_read(mraa_gpio_context dev)
         return dev->advance_func->gpio_read_replace(dev);
     }
 
+    if (dev->mmap_read != NULL) {
+        return dev->mmap_read(dev);
+    }
+
     if (plat->chardev_capable) {
         int output_values[1] = { 0 };
 
@@ -1434,27 +1941,7 @@ mraa_gpio_read(mraa_gpio_context dev)
         return output_values[0];
     }
 
-    if (dev->mmap_read != NULL) {
-        return dev->mmap_read(dev);
-    }
-
-    if (dev->value_fp == -1) {
-        if (_mraa_gpio_get_valfp(dev) != MRAA_SUCCESS) {
-            return -1;
-        }
-    } else {
-        // if value_fp is new this is pointless
-        lseek(dev->value_fp, 0, SEEK_SET);
-    }
-    char bu[2];
-    if (read(dev->value_fp, bu, 2 * sizeof(char)) != 2) {
-        syslog(LOG_ERR, "gpio%i: read: Failed to read a sensible value from sysfs: %s", dev->pin,
-               strerror(errno));
-        return -1;
-    }
-    lseek(dev->value_fp, 0, SEEK_SET);
-
-    return (int) strtol(bu, NULL, 10);
+    return _mraa_gpio_sysfs_read_value(dev);
 }
 
 mraa_result_t
@@ -1476,16 +1963,13 @@ mraa_gpio_read_multi(mraa_gpio_context dev, int output_values[])
             unsigned flags = GPIOHANDLE_REQUEST_INPUT;
 
             if (gpio_iter->gpiod_handle <= 0) {
-                gpio_iter->gpiod_handle = mraa_get_lines_handle(gpio_iter->dev_fd, gpio_iter->gpio_lines,
-                                                                gpio_iter->num_gpio_lines, flags, 0);
-                if (gpio_iter->gpiod_handle <= 0) {
+                if (_mraa_gpiod_group_request(gpio_iter, flags) <= 0) {
                     syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting gpio line handle");
                     return MRAA_ERROR_INVALID_HANDLE;
                 }
             }
 
-            status =
-            mraa_get_line_values(gpio_iter->gpiod_handle, gpio_iter->num_gpio_lines, gpio_iter->rw_values);
+            status = _mraa_gpiod_group_get_values(gpio_iter);
             if (status < 0) {
                 syslog(LOG_ERR, "[GPIOD_INTERFACE]: error writing gpio");
                 return MRAA_ERROR_INVALID_RESOURCE;
@@ -1501,8 +1985,13 @@ mraa_gpio_read_multi(mraa_gpio_context dev, int output_values[])
         mraa_gpio_context it = dev;
         int i = 0;
 
+        /* The value fds stay open, a plain pin costs a single pread. */
         while (it) {
-            output_values[i] = mraa_gpio_read(it);
+            if (IS_FUNC_DEFINED(it, gpio_read_replace) || it->mmap_read != NULL) {
+                output_values[i] = mraa_gpio_read(it);
+            } else {
+                output_values[i] = _mraa_gpio_sysfs_read_value(it);
+            }
 
             if (output_values[i] == -1) {
                 syslog(LOG_ERR, "gpio: read_multiple: failed to read multiple gpio pins");
@@ -1535,32 +2024,19 @@ mraa_gpio_write(mraa_gpio_context dev, int value)
         return dev->advance_func->gpio_write_replace(dev, value);
     }
 
-    if (plat->chardev_capable) {
-        int input_values[1] = { value };
-
-        return mraa_gpio_write_multi(dev, input_values);
-    }
-
     if (dev->mmap_write != NULL) {
         return dev->mmap_write(dev, value);
     }
 
-    if (dev->value_fp == -1) {
-        if (_mraa_gpio_get_valfp(dev) != MRAA_SUCCESS) {
-            return MRAA_ERROR_INVALID_RESOURCE;
-        }
-    }
+    if (plat->chardev_capable) {
+        int input_values[1] = { value };
 
-    if (lseek(dev->value_fp, 0, SEEK_SET) == -1) {
-        syslog(LOG_ERR, "gpio%i: write: Failed to lseek 'value': %s", dev->pin, strerror(errno));
-        return MRAA_ERROR_UNSPECIFIED;
+        return mraa_gpio_write_multi(dev, input_values);
     }
 
-    char bu[MAX_SIZE];
-    int length = snprintf(bu, sizeof(bu), "%d", value);
-    if (write(dev->value_fp, bu, length * sizeof(char)) == -1) {
-        syslog(LOG_ERR, "gpio%i: write: Failed to write to 'value': %s", dev->pin, strerror(errno));
-        return MRAA_ERROR_UNSPECIFIED;
+    mraa_result_t ret = _mraa_gpio_sysfs_write_value(dev, value);
+    if (ret != MRAA_SUCCESS) {
+        return ret;
     }
 
     if (IS_FUNC_DEFINED(dev, gpio_write_post)) {
@@ -1570,8 +2046,8 @@ mraa_gpio_write(mraa_gpio_context dev, int value)
     return MRAA_SUCCESS;
 }
 
-mraa_result_t
-mraa_gpio_write_multi(mraa_gpio_context dev, int input_values[])
+static mraa_result_t
+mraa_gpio_write_multi_internal(mraa_gpio_context dev, int input_values[], int write_mask[])
 {
     if (dev == NULL) {
         syslog(LOG_ERR, "gpio: write: context is invalid");
@@ -1581,36 +2057,34 @@ mraa_gpio_write_multi(mraa_gpio_context dev, int input_values[])
     if (plat->chardev_capable) {
         mraa_gpiod_group_t gpio_iter;
 
-        int* counters = calloc(dev->num_chips, sizeof(int));
-        if (counters == NULL) {
-            syslog(LOG_ERR, "mraa_gpio_write_multi() malloc error");
-            return MRAA_ERROR_NO_RESOURCES;
-        }
-
-        for (int i = 0; i < dev->num_pins; ++i) {
-            int chip_id = dev->pin_to_gpio_table[i];
-            gpio_iter = &dev->gpio_group[chip_id];
-            gpio_iter->rw_values[counters[chip_id]] = input_values[i];
-            counters[chip_id]++;
-        }
-        free(counters);
-
         for_each_gpio_group(gpio_iter, dev)
         {
             int status;
+            uint64_t mask = 0;
             unsigned flags = GPIOHANDLE_REQUEST_OUTPUT;
 
+            /* Only the selected lines are updated, the others keep their last value. */
+            for (int j = 0; j < gpio_iter->num_gpio_lines; ++j) {
+                int pin_idx = gpio_iter->gpio_group_to_pins_table[j];
+
+                if (write_mask == NULL || write_mask[pin_idx]) {
+                    gpio_iter->rw_values[j] = input_values[pin_idx] ? 1 : 0;
+                    mask |= 1ULL << j;
+                }
+            }
+
+            if (mask == 0) {
+                continue;
+            }
+
             if (gpio_iter->gpiod_handle <= 0) {
-                gpio_iter->gpiod_handle = mraa_get_lines_handle(gpio_iter->dev_fd, gpio_iter->gpio_lines,
-                                                                gpio_iter->num_gpio_lines, flags, 0);
-                if (gpio_iter->gpiod_handle <= 0) {
+                if (_mraa_gpiod_group_request(gpio_iter, flags) <= 0) {
                     syslog(LOG_ERR, "[GPIOD_INTERFACE]: error getting gpio line handle");
                     return MRAA_ERROR_INVALID_HANDLE;
                 }
             }
 
-            status =
-            mraa_set_line_values(gpio_iter->gpiod_handle, gpio_iter->num_gpio_lines, gpio_iter->rw_values);
+            status = _mraa_gpiod_group_set_values(gpio_iter, mask);
             if (status < 0) {
                 syslog(LOG_ERR, "[GPIOD_INTERFACE]: error writing gpio");
                 return MRAA_ERROR_INVALID_RESOURCE;
@@ -1621,12 +2095,21 @@ mraa_gpio_write_multi(mraa_gpio_context dev, int input_values[])
         int i = 0;
         mraa_result_t status;
 
+        /* The value fds stay open, a plain pin costs a single pwrite. */
         while (it) {
-            status = mraa_gpio_write(it, input_values[i++]);
-            if (status != MRAA_SUCCESS) {
-                syslog(LOG_ERR, "gpio: read_multiple: failed to write to multiple gpio pins");
-                return status;
+            if (write_mask == NULL || write_mask[i]) {
+                if (IS_FUNC_DEFINED(it, gpio_write_pre) || IS_FUNC_DEFINED(it, gpio_write_replace) ||
+                    IS_FUNC_DEFINED(it, gpio_write_post) || it->mmap_write != NULL) {
+                    status = mraa_gpio_write(it, input_values[i]);
+                } else {
+                    status = _mraa_gpio_sysfs_write_value(it, input_values[i]);
+                }
+                if (status != MRAA_SUCCESS) {
+                    syslog(LOG_ERR, "gpio: read_multiple: failed to write to multiple gpio pins");
+                    return status;
+                }
             }
+            i++;
             it = it->next;
         }
     }
@@ -1634,6 +2117,23 @@ mraa_gpio_write_multi(mraa_gpio_context dev, int input_values[])
     return MRAA_SUCCESS;
 }
 
+mraa_result_t
+mraa_gpio_write_multi(mraa_gpio_context dev, int input_values[])
+{
+    return mraa_gpio_write_multi_internal(dev, input_values, NULL);
+}
+
+mraa_result_t
+mraa_gpio_write_multi_masked(mraa_gpio_context dev, int input_values[], int write_mask[])
+{
+    if (write_mask == NULL) {
+        syslog(LOG_ERR, "gpio: write_multi_masked: mask is invalid");
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    return mraa_gpio_write_multi_internal(dev, input_values, write_mask);
+}
+
 static mraa_result_t
 mraa_gpio_unexport_force(mraa_gpio_context dev)
 {
@@ -1694,6 +2194,10 @@ _mraa_gpio_close_internal(mraa_gpio_context dev)
         close(dev->value_fp);
     }
 
+    if (dev->isr_value_fp != -1) {
+        close(dev->isr_value_fp);
+    }
+
     mraa_gpio_unexport(dev);
 
     free(dev);
@@ -1711,12 +2215,19 @@ mraa_gpio_close(mraa_gpio_context dev)
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
+    /* Free any ISRs, the dispatcher may write dev->events until it is unregistered */
+    mraa_gpio_isr_exit(dev);
+
     if (dev->events) {
         free(dev->events);
+        dev->events = NULL;
     }
 
-    /* Free any ISRs */
-    mraa_gpio_isr_exit(dev);
+    /* Drop our reference on the generic mmap backend mapping */
+    if (dev->mmap_set != NULL) {
+        mraa_gpio_mmap_generic_setup(dev, 0);
+    }
+    mraa_gpio_event_queue_free(dev);
 
     if (plat && plat->chardev_capable) {
         _mraa_free_gpio_groups(dev);
@@ -1763,6 +2274,10 @@ mraa_gpio_use_mmaped_internal(mraa_gpio_context dev, mraa_boolean_t mmap_en)
         return dev->advance_func->gpio_mmap_setup(dev, mmap_en);
     }
 
+    if (plat->gpio_mmap != NULL) {
+        return mraa_gpio_mmap_generic_setup(dev, mmap_en);
+    }
+
     syslog(LOG_ERR, "gpio%i: use_mmaped: mmap not implemented on this platform", dev->pin);
 
     return MRAA_ERROR_FEATURE_NOT_IMPLEMENTED;
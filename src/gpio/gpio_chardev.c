@@ -216,13 +216,6 @@ mraa_get_chip_info_by_name(const char* name)
     return cinfo;
 }
 
-mraa_gpiod_chip_info*
-mraa_get_chip_info_by_label(const char* label)
-{
-    /* TODO */
-    return NULL;
-}
-
 mraa_gpiod_chip_info*
 mraa_get_chip_info_by_number(unsigned number)
 {
@@ -398,6 +391,273 @@ mraa_get_line_values(int line_handle, unsigned int num_lines, unsigned char outp
     return status;
 }
 
+mraa_boolean_t
+mraa_gpiod_has_uapi_v2(int chip_fd)
+{
+    /* The ABI version is a property of the running kernel, probe it once. */
+    static int has_v2 = -1;
+    struct gpio_v2_line_info linfo;
+
+    if (has_v2 == -1) {
+        memset(&linfo, 0, sizeof linfo);
+        /* Don't go through _mraa_gpiod_ioctl(), a failure here is not an error. */
+        has_v2 = (ioctl(chip_fd, GPIO_V2_GET_LINEINFO_IOCTL, &linfo) == 0);
+        syslog(LOG_DEBUG, "[GPIOD_INTERFACE]: using GPIO uAPI v%d", has_v2 ? 2 : 1);
+    }
+
+    return has_v2;
+}
+
+uint64_t
+mraa_gpiod_flags_to_v2(unsigned flags)
+{
+    uint64_t v2_flags = 0;
+
+    if (flags & GPIOHANDLE_REQUEST_INPUT)
+        v2_flags |= GPIO_V2_LINE_FLAG_INPUT;
+    if (flags & GPIOHANDLE_REQUEST_OUTPUT)
+        v2_flags |= GPIO_V2_LINE_FLAG_OUTPUT;
+    if (flags & GPIOHANDLE_REQUEST_ACTIVE_LOW)
+        v2_flags |= GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+    if (flags & GPIOHANDLE_REQUEST_OPEN_DRAIN)
+        v2_flags |= GPIO_V2_LINE_FLAG_OPEN_DRAIN;
+    if (flags & GPIOHANDLE_REQUEST_OPEN_SOURCE)
+        v2_flags |= GPIO_V2_LINE_FLAG_OPEN_SOURCE;
+
+    return v2_flags;
+}
+
+int
+mraa_get_lines_handle_v2(int chip_fd, unsigned line_offsets[], unsigned num_lines, uint64_t flags, uint64_t default_bits)
+{
+    int status;
+    struct gpio_v2_line_request req;
+
+    if (num_lines > GPIO_V2_LINES_MAX) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: too many lines requested (%u)", num_lines);
+        return -1;
+    }
+
+    memset(&req, 0, sizeof req);
+    memcpy(req.offsets, line_offsets, num_lines * sizeof req.offsets[0]);
+    strncpy(req.consumer, "libmraa", sizeof req.consumer - 1);
+    req.num_lines = num_lines;
+    req.config.flags = flags;
+
+    if ((flags & GPIO_V2_LINE_FLAG_OUTPUT) && num_lines > 0) {
+        req.config.num_attrs = 1;
+        req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        req.config.attrs[0].attr.values = default_bits;
+        req.config.attrs[0].mask = (num_lines == 64) ? ~0ULL : ((1ULL << num_lines) - 1);
+    }
+
+    status = _mraa_gpiod_ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+    if (status < 0) {
+        syslog(LOG_ERR, "gpiod: ioctl() fail");
+        return status;
+    }
+
+    if (req.fd <= 0) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: invalid file descriptor");
+    }
+
+    return req.fd;
+}
+
+int
+mraa_set_line_values_v2(int line_handle, uint64_t mask, uint64_t bits)
+{
+    int status;
+    struct gpio_v2_line_values vals;
+
+    vals.mask = mask;
+    vals.bits = bits;
+
+    status = _mraa_gpiod_ioctl(line_handle, GPIO_V2_LINE_SET_VALUES_IOCTL, &vals);
+    if (status < 0) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: ioctl() fail");
+    }
+
+    return status;
+}
+
+int
+mraa_get_line_values_v2(int line_handle, uint64_t mask, uint64_t* bits)
+{
+    int status;
+    struct gpio_v2_line_values vals;
+
+    vals.mask = mask;
+    vals.bits = 0;
+
+    status = _mraa_gpiod_ioctl(line_handle, GPIO_V2_LINE_GET_VALUES_IOCTL, &vals);
+    if (status < 0) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: ioctl() fail");
+        return status;
+    }
+
+    *bits = vals.bits;
+
+    return status;
+}
+
+int
+mraa_get_line_event_handle_v2(int chip_fd, unsigned line_offset, uint64_t flags, unsigned buffer_size)
+{
+    int status;
+    struct gpio_v2_line_request req;
+
+    memset(&req, 0, sizeof req);
+    req.offsets[0] = line_offset;
+    strncpy(req.consumer, "libmraa", sizeof req.consumer - 1);
+    req.num_lines = 1;
+    req.config.flags = flags;
+    /* 0 lets the kernel pick its default, larger values are clamped by the kernel. */
+    req.event_buffer_size = buffer_size;
+
+    status = _mraa_gpiod_ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+    if (status < 0) {
+        syslog(LOG_ERR, "gpiod: ioctl() fail");
+        return status;
+    }
+
+    return req.fd;
+}
+
+int
+mraa_read_line_events(int fd, mraa_boolean_t uapi_v2, mraa_gpiod_line_event events[], int max)
+{
+    ssize_t len;
+    int num = 0;
+
+    if (max > MRAA_GPIOD_EVENTS_PER_READ) {
+        max = MRAA_GPIOD_EVENTS_PER_READ;
+    }
+
+    /* A single read() returns every queued event that fits in the buffer. */
+    if (uapi_v2) {
+        struct gpio_v2_line_event data[MRAA_GPIOD_EVENTS_PER_READ];
+
+        len = read(fd, data, max * sizeof data[0]);
+        if (len > 0) {
+            num = len / sizeof data[0];
+            for (int i = 0; i < num; ++i) {
+                events[i].timestamp = data[i].timestamp_ns;
+                events[i].id = data[i].id;
+                events[i].line_seqno = data[i].line_seqno;
+            }
+        }
+    } else {
+        struct gpioevent_data data[MRAA_GPIOD_EVENTS_PER_READ];
+
+        len = read(fd, data, max * sizeof data[0]);
+        if (len > 0) {
+            num = len / sizeof data[0];
+            for (int i = 0; i < num; ++i) {
+                events[i].timestamp = data[i].timestamp;
+                events[i].id = data[i].id;
+                events[i].line_seqno = 0;
+            }
+        }
+    }
+
+    if (len < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    return num;
+}
+
+int
+_mraa_gpiod_group_request(mraa_gpiod_group_t group, unsigned flags)
+{
+    int line_handle;
+
+    if (group->uapi_v2) {
+        uint64_t default_bits = 0;
+
+        /* Keep the levels last written through this group when re-requesting. */
+        if (group->rw_values != NULL) {
+            for (int i = 0; i < group->num_gpio_lines; ++i) {
+                if (group->rw_values[i])
+                    default_bits |= 1ULL << i;
+            }
+        }
+
+        line_handle = mraa_get_lines_handle_v2(group->dev_fd, group->gpio_lines, group->num_gpio_lines,
+                                               mraa_gpiod_flags_to_v2(flags), default_bits);
+    } else {
+        line_handle = mraa_get_lines_handle(group->dev_fd, group->gpio_lines, group->num_gpio_lines, flags, 0);
+    }
+
+    if (line_handle > 0) {
+        group->gpiod_handle = line_handle;
+        group->flags = flags;
+    }
+
+    return line_handle;
+}
+
+int
+_mraa_gpiod_group_set_values(mraa_gpiod_group_t group, uint64_t mask)
+{
+    uint64_t bits = 0;
+
+    /*
+     * v1 has no mask and sets every line of the handle. Read the lines outside
+     * the mask back first, so they are rewritten with the level they have now
+     * rather than the last one written through this group.
+     */
+    if (!group->uapi_v2) {
+        uint64_t all = (group->num_gpio_lines == 64) ? ~0ULL : ((1ULL << group->num_gpio_lines) - 1);
+
+        if ((mask & all) != all) {
+            unsigned char current[GPIOHANDLES_MAX];
+            int status = mraa_get_line_values(group->gpiod_handle, group->num_gpio_lines, current);
+            if (status < 0) {
+                return status;
+            }
+
+            for (int i = 0; i < group->num_gpio_lines; ++i) {
+                if (!(mask & (1ULL << i)))
+                    group->rw_values[i] = current[i];
+            }
+        }
+
+        return mraa_set_line_values(group->gpiod_handle, group->num_gpio_lines, group->rw_values);
+    }
+
+    for (int i = 0; i < group->num_gpio_lines; ++i) {
+        if (group->rw_values[i])
+            bits |= 1ULL << i;
+    }
+
+    return mraa_set_line_values_v2(group->gpiod_handle, mask, bits);
+}
+
+int
+_mraa_gpiod_group_get_values(mraa_gpiod_group_t group)
+{
+    int status;
+    uint64_t mask, bits;
+
+    if (!group->uapi_v2) {
+        return mraa_get_line_values(group->gpiod_handle, group->num_gpio_lines, group->rw_values);
+    }
+
+    mask = (group->num_gpio_lines == 64) ? ~0ULL : ((1ULL << group->num_gpio_lines) - 1);
+    status = mraa_get_line_values_v2(group->gpiod_handle, mask, &bits);
+    if (status < 0) {
+        return status;
+    }
+
+    for (int i = 0; i < group->num_gpio_lines; ++i) {
+        group->rw_values[i] = (bits >> i) & 1;
+    }
+
+    return status;
+}
+
 
 mraa_boolean_t
 mraa_is_gpio_line_kernel_owned(mraa_gpiod_line_info* linfo)
@@ -429,24 +689,191 @@ mraa_is_gpio_line_open_source(mraa_gpiod_line_info* linfo)
     return (linfo->flags & GPIOLINE_FLAG_OPEN_SOURCE);
 }
 
+#ifndef GPIO_MAX_NAME_SIZE
+#define GPIO_MAX_NAME_SIZE 32
+#endif
+
+/*
+ * Process wide view of the gpiochips. Scanning /dev and issuing a LINEINFO
+ * ioctl per line is by far the most expensive part of a name lookup, so the
+ * chip list is built on first use and the line names of a chip on the first
+ * name lookup. Chips don't come and go on a running board, the cache is only
+ * dropped by mraa_gpio_invalidate_chip_cache().
+ */
+typedef struct {
+    unsigned int number; /* N of /dev/gpiochipN */
+    char name[GPIO_MAX_NAME_SIZE];
+    char label[GPIO_MAX_NAME_SIZE];
+    unsigned int lines;
+    char (*line_names)[GPIO_MAX_NAME_SIZE]; /* NULL until first needed */
+} mraa_gpiod_chip_cache_entry;
+
+static mraa_gpiod_chip_cache_entry* chip_cache = NULL;
+static int chip_cache_count = -1; /* -1 until /dev was scanned */
+static pthread_mutex_t chip_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static int
 dir_filter(const struct dirent* dir)
 {
-    return !strncmp(dir->d_name, CHIP_DEV_PREFIX, strlen(CHIP_DEV_PREFIX));
+    const char* num = dir->d_name + strlen(CHIP_DEV_PREFIX);
+
+    if (strncmp(dir->d_name, CHIP_DEV_PREFIX, strlen(CHIP_DEV_PREFIX)) || *num == '\0') {
+        return 0;
+    }
+    for (; *num; num++) {
+        if (*num < '0' || *num > '9') {
+            return 0;
+        }
+    }
+    return 1;
 }
 
-int
-mraa_get_number_of_gpio_chips()
+static int
+chip_cache_cmp(const void* a, const void* b)
+{
+    unsigned int na = ((const mraa_gpiod_chip_cache_entry*) a)->number;
+    unsigned int nb = ((const mraa_gpiod_chip_cache_entry*) b)->number;
+    return (na > nb) - (na < nb);
+}
+
+static void
+_mraa_chip_cache_free()
+{
+    for (int i = 0; i < chip_cache_count; i++) {
+        free(chip_cache[i].line_names);
+    }
+    free(chip_cache);
+    chip_cache = NULL;
+    chip_cache_count = -1;
+}
+
+/* Called with chip_cache_lock held. */
+static int
+_mraa_chip_cache_scan()
 {
-    int num_chips;
     struct dirent** dirs;
+    int num_dirs, i;
 
-    num_chips = scandir("/dev", &dirs, dir_filter, alphasort);
-    if (num_chips < 0) {
+    if (chip_cache_count >= 0) {
+        return chip_cache_count;
+    }
+
+    num_dirs = scandir("/dev", &dirs, dir_filter, NULL);
+    if (num_dirs < 0) {
         syslog(LOG_ERR, "[GPIOD_INTERFACE]: scandir() error");
         return -1;
     }
 
+    chip_cache = calloc(num_dirs > 0 ? num_dirs : 1, sizeof(mraa_gpiod_chip_cache_entry));
+    if (!chip_cache) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: Failed to allocate memory for chip info");
+        for (i = 0; i < num_dirs; i++) {
+            free(dirs[i]);
+        }
+        free(dirs);
+        return -1;
+    }
+
+    chip_cache_count = 0;
+    for (i = 0; i < num_dirs; i++) {
+        mraa_gpiod_chip_info* cinfo = mraa_get_chip_info_by_name(dirs[i]->d_name);
+        if (cinfo) {
+            mraa_gpiod_chip_cache_entry* entry = &chip_cache[chip_cache_count++];
+            entry->number = (unsigned int) strtoul(dirs[i]->d_name + strlen(CHIP_DEV_PREFIX), NULL, 10);
+            memcpy(entry->name, cinfo->chip_info.name, GPIO_MAX_NAME_SIZE);
+            memcpy(entry->label, cinfo->chip_info.label, GPIO_MAX_NAME_SIZE);
+            entry->name[GPIO_MAX_NAME_SIZE - 1] = '\0';
+            entry->label[GPIO_MAX_NAME_SIZE - 1] = '\0';
+            entry->lines = cinfo->chip_info.lines;
+            close(cinfo->chip_fd);
+            free(cinfo);
+        } else {
+            syslog(LOG_ERR, "[GPIOD_INTERFACE]: invalid chip %s", dirs[i]->d_name);
+        }
+        free(dirs[i]);
+    }
+    free(dirs);
+
+    qsort(chip_cache, chip_cache_count, sizeof(mraa_gpiod_chip_cache_entry), chip_cache_cmp);
+
+    return chip_cache_count;
+}
+
+/* Called with chip_cache_lock held. */
+static mraa_result_t
+_mraa_chip_cache_load_lines(mraa_gpiod_chip_cache_entry* entry)
+{
+    mraa_gpiod_chip_info* cinfo;
+    struct gpioline_info linfo;
+
+    if (entry->line_names != NULL || entry->lines == 0) {
+        return MRAA_SUCCESS;
+    }
+
+    entry->line_names = calloc(entry->lines, GPIO_MAX_NAME_SIZE);
+    if (!entry->line_names) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: Failed to allocate memory for line names");
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    cinfo = mraa_get_chip_info_by_number(entry->number);
+    if (!cinfo) {
+        free(entry->line_names);
+        entry->line_names = NULL;
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    /* One open for the whole chip rather than one per line. */
+    for (unsigned int i = 0; i < entry->lines; i++) {
+        memset(&linfo, 0, sizeof linfo);
+        linfo.line_offset = i;
+        if (_mraa_gpiod_ioctl(cinfo->chip_fd, GPIO_GET_LINEINFO_IOCTL, &linfo) == 0) {
+            memcpy(entry->line_names[i], linfo.name, GPIO_MAX_NAME_SIZE);
+            entry->line_names[i][GPIO_MAX_NAME_SIZE - 1] = '\0';
+        }
+    }
+
+    close(cinfo->chip_fd);
+    free(cinfo);
+
+    return MRAA_SUCCESS;
+}
+
+void
+mraa_gpio_invalidate_chip_cache()
+{
+    pthread_mutex_lock(&chip_cache_lock);
+    _mraa_chip_cache_free();
+    pthread_mutex_unlock(&chip_cache_lock);
+}
+
+mraa_result_t
+mraa_gpio_refresh_chip_cache()
+{
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    pthread_mutex_lock(&chip_cache_lock);
+    _mraa_chip_cache_free();
+    if (_mraa_chip_cache_scan() <= 0) {
+        ret = MRAA_ERROR_NO_DATA_AVAILABLE;
+    }
+    for (int i = 0; i < chip_cache_count && ret == MRAA_SUCCESS; i++) {
+        ret = _mraa_chip_cache_load_lines(&chip_cache[i]);
+    }
+    pthread_mutex_unlock(&chip_cache_lock);
+
+    return ret;
+}
+
+int
+mraa_get_number_of_gpio_chips()
+{
+    int num_chips;
+
+    pthread_mutex_lock(&chip_cache_lock);
+    num_chips = _mraa_chip_cache_scan();
+    pthread_mutex_unlock(&chip_cache_lock);
+
     return num_chips;
 }
 
@@ -454,75 +881,104 @@ int
 mraa_get_chip_infos(mraa_gpiod_chip_info*** cinfos)
 {
     int num_chips, i;
-    struct dirent** dirs;
     mraa_gpiod_chip_info** cinfo;
 
-    num_chips = scandir("/dev", &dirs, dir_filter, alphasort);
+    pthread_mutex_lock(&chip_cache_lock);
+    num_chips = _mraa_chip_cache_scan();
     if (num_chips < 0) {
-        syslog(LOG_ERR, "[GPIOD_INTERFACE]: scandir() error");
+        pthread_mutex_unlock(&chip_cache_lock);
         return -1;
     }
 
-    cinfo = (mraa_gpiod_chip_info**) calloc(num_chips, sizeof(mraa_gpiod_chip_info*));
+    cinfo = (mraa_gpiod_chip_info**) calloc(num_chips > 0 ? num_chips : 1, sizeof(mraa_gpiod_chip_info*));
     if (!cinfo) {
         syslog(LOG_ERR, "[GPIOD_INTERFACE]: Failed to allocate memory for chip info");
+        pthread_mutex_unlock(&chip_cache_lock);
         return -1;
     }
 
     *cinfos = cinfo;
 
-    /* Get chip info for all gpiochips present in the platform */
+    /* Get chip info for all gpiochips present in the platform, ordered by chip number */
     for (i = 0; i < num_chips; i++) {
-        cinfo[i] = mraa_get_chip_info_by_name(dirs[i]->d_name);
+        cinfo[i] = mraa_get_chip_info_by_number(chip_cache[i].number);
         if (!cinfo[i]) {
-            syslog(LOG_ERR, "[GPIOD_INTERFACE]: invalid chip %s", dirs[i]->d_name);
+            syslog(LOG_ERR, "[GPIOD_INTERFACE]: invalid chip %s", chip_cache[i].name);
+            pthread_mutex_unlock(&chip_cache_lock);
             return 0;
         }
     }
+    pthread_mutex_unlock(&chip_cache_lock);
 
     return num_chips;
 }
 
-#ifndef GPIO_MAX_NAME_SIZE
-#define GPIO_MAX_NAME_SIZE 32
-#endif
+mraa_gpiod_chip_info*
+mraa_get_chip_info_by_label(const char* label)
+{
+    int number = -1;
+
+    if (label == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&chip_cache_lock);
+    _mraa_chip_cache_scan();
+    for (int i = 0; i < chip_cache_count; i++) {
+        if (!strncmp(chip_cache[i].label, label, GPIO_MAX_NAME_SIZE)) {
+            number = chip_cache[i].number;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&chip_cache_lock);
+
+    if (number < 0) {
+        syslog(LOG_ERR, "[GPIOD_INTERFACE]: no gpiochip labelled %s", label);
+        return NULL;
+    }
+
+    return mraa_get_chip_info_by_number(number);
+}
 
 int
 mraa_find_gpio_line_by_name(const char *name, unsigned *chip_number, unsigned *line_number)
 {
-    mraa_gpiod_chip_info **cinfos;
-    mraa_gpiod_chip_info *cinfo;
-    mraa_gpiod_line_info *linfo;
-    int num_chips, i;
+    int ret = -1;
 
-    num_chips = mraa_get_chip_infos(&cinfos);
-    if (num_chips < 0) {
+    /* Unnamed lines report an empty name, never match those. */
+    if (name == NULL || name[0] == '\0') {
         return -1;
     }
 
-    for_each_gpio_chip(cinfo, cinfos, num_chips) {
-        for (i = 0; i < cinfo->chip_info.lines; i++) {
-            linfo = mraa_get_line_info_by_chip_name(cinfo->chip_info.name, i);
+    pthread_mutex_lock(&chip_cache_lock);
+    if (_mraa_chip_cache_scan() < 0) {
+        pthread_mutex_unlock(&chip_cache_lock);
+        return -1;
+    }
 
-            if (!strncmp(linfo->name, name, GPIO_MAX_NAME_SIZE)) {
+    for (int i = 0; i < chip_cache_count && ret != 0; i++) {
+        mraa_gpiod_chip_cache_entry* entry = &chip_cache[i];
+
+        if (_mraa_chip_cache_load_lines(entry) != MRAA_SUCCESS || entry->line_names == NULL) {
+            continue;
+        }
+
+        for (unsigned int j = 0; j < entry->lines; j++) {
+            if (!strncmp(entry->line_names[j], name, GPIO_MAX_NAME_SIZE)) {
                 if (chip_number) {
-                    /* idx is coming from `for_each_gpio_chip` definition */
-                    *chip_number = idx;
+                    *chip_number = entry->number;
                 }
 
                 if (line_number) {
-                    *line_number = linfo->line_offset;
+                    *line_number = j;
                 }
 
-                free(linfo);
-                free(cinfos);
-                return 0;
+                ret = 0;
+                break;
             }
-
-            free(linfo);
         }
     }
+    pthread_mutex_unlock(&chip_cache_lock);
 
-    free(cinfos);
-    return -1;
+    return ret;
 }
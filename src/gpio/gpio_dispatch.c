@@ -0,0 +1,475 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "gpio/gpio_dispatch.h"
+#include "gpio.h"
+#include "gpio/gpio_chardev.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#define SYSFS_CLASS_GPIO "/sys/class/gpio"
+#define MAX_SIZE 64
+#define MRAA_GPIO_DISPATCH_MAX_EVENTS 32
+#define MRAA_GPIO_DISPATCH_WAKE_KEY UINT64_MAX
+
+/* One polled fd of a registered context. */
+typedef struct {
+    mraa_gpio_context dev; /* NULL when the slot is free */
+    uint32_t generation; /* bumped on release, stale epoll events are ignored */
+    int fd;
+    int idx; /* index in dev->events */
+    int pin;
+    unsigned int line_seqno;
+    mraa_boolean_t sysfs; /* the value fd is owned by the dispatcher */
+    mraa_boolean_t uapi_v2;
+} mraa_gpio_dispatch_slot;
+
+struct _gpio_dispatcher {
+    pthread_t thread_id;
+    int epoll_fd;
+    int wake_pipe[2];
+    mraa_boolean_t stopping;
+    mraa_boolean_t java_attached;
+    pthread_mutex_t lock; /* protects everything below, never held across a callback */
+    pthread_cond_t idle;
+    mraa_gpio_context running; /* context whose callback is executing */
+    mraa_gpio_dispatch_slot* slots;
+    unsigned int num_slots;
+    unsigned int num_contexts;
+};
+
+static struct _gpio_dispatcher* dispatchers = NULL;
+static unsigned int num_dispatchers = 0;
+static pthread_mutex_t dispatchers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+mraa_gpio_dispatch_run_isr(struct _gpio_dispatcher* d, mraa_gpio_context dev)
+{
+    if (lang_func->java_attach_thread != NULL && dev->isr == lang_func->java_isr_callback &&
+        !d->java_attached) {
+        d->java_attached = (lang_func->java_attach_thread() == MRAA_SUCCESS);
+        if (!d->java_attached) {
+            return;
+        }
+    }
+
+    if (lang_func->python_isr != NULL) {
+        lang_func->python_isr(dev->isr, dev->isr_args);
+    } else {
+        dev->isr(dev->isr_args);
+    }
+}
+
+static void*
+mraa_gpio_dispatch_thread(void* arg)
+{
+    struct _gpio_dispatcher* d = (struct _gpio_dispatcher*) arg;
+    struct epoll_event evs[MRAA_GPIO_DISPATCH_MAX_EVENTS];
+    struct {
+        mraa_gpio_context dev;
+        uint32_t slot;
+        uint32_t generation;
+    } fired[MRAA_GPIO_DISPATCH_MAX_EVENTS];
+    char c;
+
+    for (;;) {
+        int num = epoll_wait(d->epoll_fd, evs, MRAA_GPIO_DISPATCH_MAX_EVENTS, -1);
+        if (num < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            syslog(LOG_ERR, "gpio: dispatcher: epoll_wait() failed: %s", strerror(errno));
+            break;
+        }
+
+        int num_fired = 0;
+
+        pthread_mutex_lock(&d->lock);
+        if (d->stopping) {
+            pthread_mutex_unlock(&d->lock);
+            break;
+        }
+
+        /* Decode everything first, so a multi pin context gets a single callback. */
+        for (int i = 0; i < num; ++i) {
+            if (evs[i].data.u64 == MRAA_GPIO_DISPATCH_WAKE_KEY) {
+                read(d->wake_pipe[0], &c, 1);
+                continue;
+            }
+
+            uint32_t slot_idx = (uint32_t) evs[i].data.u64;
+            uint32_t generation = (uint32_t)(evs[i].data.u64 >> 32);
+            if (slot_idx >= d->num_slots || d->slots[slot_idx].dev == NULL ||
+                d->slots[slot_idx].generation != generation) {
+                continue;
+            }
+
+            mraa_gpio_dispatch_slot* slot = &d->slots[slot_idx];
+            mraa_gpio_context dev = slot->dev;
+            if (dev->isr_thread_terminating) {
+                continue;
+            }
+
+            int j;
+            for (j = 0; j < num_fired && fired[j].dev != dev; ++j)
+                ;
+            if (j == num_fired) {
+                fired[num_fired].dev = dev;
+                fired[num_fired].slot = slot_idx;
+                fired[num_fired].generation = generation;
+                num_fired++;
+            }
+
+            /* Only the queue, which has its own lock, is shared with the reader. */
+            if (slot->sysfs) {
+                mraa_gpio_sysfs_read_event(dev, NULL, slot->fd, slot->idx, slot->pin);
+            } else {
+                mraa_gpio_chardev_read_events(dev, NULL, slot->fd, slot->idx, slot->pin,
+                                              &slot->line_seqno, slot->uapi_v2);
+            }
+        }
+
+        for (int j = 0; j < num_fired; ++j) {
+            /* The lock was dropped for the previous callback, check the context is still ours. */
+            mraa_gpio_dispatch_slot* slot = &d->slots[fired[j].slot];
+            if (slot->dev != fired[j].dev || slot->generation != fired[j].generation ||
+                slot->dev->isr_thread_terminating) {
+                continue;
+            }
+
+            d->running = slot->dev;
+            pthread_mutex_unlock(&d->lock);
+
+            mraa_gpio_dispatch_run_isr(d, fired[j].dev);
+
+            pthread_mutex_lock(&d->lock);
+            d->running = NULL;
+            pthread_cond_broadcast(&d->idle);
+        }
+        pthread_mutex_unlock(&d->lock);
+    }
+
+    if (d->java_attached && lang_func->java_detach_thread != NULL) {
+        lang_func->java_detach_thread();
+    }
+
+    return NULL;
+}
+
+static int
+mraa_gpio_dispatch_add_slot(struct _gpio_dispatcher* d, mraa_gpio_context dev, int fd, int idx, int pin, mraa_boolean_t sysfs, mraa_boolean_t uapi_v2)
+{
+    unsigned int slot_idx;
+
+    for (slot_idx = 0; slot_idx < d->num_slots && d->slots[slot_idx].dev != NULL; ++slot_idx)
+        ;
+
+    if (slot_idx == d->num_slots) {
+        unsigned int num_slots = d->num_slots ? d->num_slots * 2 : 8;
+        mraa_gpio_dispatch_slot* slots = realloc(d->slots, num_slots * sizeof(mraa_gpio_dispatch_slot));
+        if (slots == NULL) {
+            syslog(LOG_ERR, "gpio: dispatcher: malloc error");
+            return -1;
+        }
+        memset(&slots[d->num_slots], 0, (num_slots - d->num_slots) * sizeof(mraa_gpio_dispatch_slot));
+        d->slots = slots;
+        d->num_slots = num_slots;
+    }
+
+    mraa_gpio_dispatch_slot* slot = &d->slots[slot_idx];
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof ev);
+    /* sysfs signals edges with POLLPRI, chardev with POLLIN. */
+    ev.events = sysfs ? (EPOLLPRI | EPOLLERR) : EPOLLIN;
+    ev.data.u64 = ((uint64_t) slot->generation << 32) | slot_idx;
+    if (epoll_ctl(d->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        syslog(LOG_ERR, "gpio: dispatcher: epoll_ctl() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    slot->dev = dev;
+    slot->fd = fd;
+    slot->idx = idx;
+    slot->pin = pin;
+    slot->line_seqno = 0;
+    slot->sysfs = sysfs;
+    slot->uapi_v2 = uapi_v2;
+
+    return 0;
+}
+
+/* Called with d->lock held. */
+static void
+mraa_gpio_dispatch_remove_slots(struct _gpio_dispatcher* d, mraa_gpio_context dev)
+{
+    for (unsigned int i = 0; i < d->num_slots; ++i) {
+        mraa_gpio_dispatch_slot* slot = &d->slots[i];
+        if (slot->dev != dev) {
+            continue;
+        }
+
+        epoll_ctl(d->epoll_fd, EPOLL_CTL_DEL, slot->fd, NULL);
+        if (slot->sysfs) {
+            close(slot->fd);
+        }
+        slot->dev = NULL;
+        slot->generation++;
+    }
+}
+
+mraa_result_t
+mraa_gpio_dispatch_register(mraa_gpio_context dev)
+{
+    struct _gpio_dispatcher* d = NULL;
+    char c;
+    int idx = 0;
+    int status = 0;
+
+    /* The shared threads report edges through the queue only, see mraa_gpio_use_isr_dispatcher(). */
+    if (dev->event_queue == NULL &&
+        mraa_gpio_event_queue_init(dev, MRAA_GPIO_DISPATCH_QUEUE_SIZE) != MRAA_SUCCESS) {
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    pthread_mutex_lock(&dispatchers_lock);
+    if (num_dispatchers == 0) {
+        pthread_mutex_unlock(&dispatchers_lock);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    /* Spread the contexts over the threads. */
+    for (unsigned int i = 0; i < num_dispatchers; ++i) {
+        if (d == NULL || dispatchers[i].num_contexts < d->num_contexts) {
+            d = &dispatchers[i];
+        }
+    }
+
+    pthread_mutex_lock(&d->lock);
+
+    if (plat->chardev_capable) {
+        mraa_gpiod_group_t gpio_group;
+
+        for_each_gpio_group(gpio_group, dev)
+        {
+            for (int i = 0; i < gpio_group->num_gpio_lines && status == 0; ++i) {
+                int fd = gpio_group->event_handles[i];
+
+                /* A spurious wakeup must never block the other contexts. */
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                status = mraa_gpio_dispatch_add_slot(d, dev, fd, idx++,
+                                                     dev->provided_pins[gpio_group->gpio_group_to_pins_table[i]],
+                                                     0, gpio_group->uapi_v2);
+            }
+        }
+    } else {
+        mraa_gpio_context it = dev;
+
+        while (it && status == 0) {
+            char bu[MAX_SIZE];
+            snprintf(bu, MAX_SIZE, SYSFS_CLASS_GPIO "/gpio%d/value", it->pin);
+            int fd = open(bu, O_RDONLY);
+            if (fd < 0) {
+                syslog(LOG_ERR, "gpio%i: dispatcher: failed to open 'value' : %s", it->pin, strerror(errno));
+                status = -1;
+                break;
+            }
+
+            // do an initial read to clear interrupt
+            pread(fd, &c, 1, 0);
+            status = mraa_gpio_dispatch_add_slot(d, dev, fd, idx++, it->event_pin, 1, 0);
+            if (status != 0) {
+                close(fd);
+            }
+
+            it = it->next;
+        }
+    }
+
+    if (status != 0) {
+        mraa_gpio_dispatch_remove_slots(d, dev);
+    } else {
+        d->num_contexts++;
+        dev->isr_dispatcher = d;
+    }
+
+    pthread_mutex_unlock(&d->lock);
+    pthread_mutex_unlock(&dispatchers_lock);
+
+    return status == 0 ? MRAA_SUCCESS : MRAA_ERROR_INVALID_RESOURCE;
+}
+
+void
+mraa_gpio_dispatch_unregister(mraa_gpio_context dev)
+{
+    struct _gpio_dispatcher* d = dev->isr_dispatcher;
+
+    if (d == NULL) {
+        return;
+    }
+
+    /* d stays alive while it counts this context, see mraa_gpio_use_isr_dispatcher(). */
+    pthread_mutex_lock(&d->lock);
+    mraa_gpio_dispatch_remove_slots(d, dev);
+
+    /* Same guarantee as joining the isr thread: the callback is not running on
+     * return, unless the callback itself is the caller. */
+    if (!pthread_equal(pthread_self(), d->thread_id)) {
+        while (d->running == dev) {
+            pthread_cond_wait(&d->idle, &d->lock);
+        }
+    }
+
+    d->num_contexts--;
+    dev->isr_dispatcher = NULL;
+    pthread_mutex_unlock(&d->lock);
+}
+
+mraa_boolean_t
+mraa_gpio_dispatch_enabled()
+{
+    mraa_boolean_t enabled;
+
+    pthread_mutex_lock(&dispatchers_lock);
+    enabled = num_dispatchers > 0;
+    pthread_mutex_unlock(&dispatchers_lock);
+
+    return enabled;
+}
+
+static void
+mraa_gpio_dispatch_stop(struct _gpio_dispatcher* d)
+{
+    char c = 0;
+
+    pthread_mutex_lock(&d->lock);
+    d->stopping = 1;
+    pthread_mutex_unlock(&d->lock);
+
+    write(d->wake_pipe[1], &c, 1);
+    pthread_join(d->thread_id, NULL);
+
+    close(d->wake_pipe[0]);
+    close(d->wake_pipe[1]);
+    close(d->epoll_fd);
+    pthread_cond_destroy(&d->idle);
+    pthread_mutex_destroy(&d->lock);
+    free(d->slots);
+}
+
+static mraa_result_t
+mraa_gpio_dispatch_start(struct _gpio_dispatcher* d)
+{
+    struct epoll_event ev;
+
+    memset(d, 0, sizeof(struct _gpio_dispatcher));
+
+    d->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (d->epoll_fd < 0) {
+        syslog(LOG_ERR, "gpio: dispatcher: epoll_create1() failed: %s", strerror(errno));
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    if (pipe(d->wake_pipe) != 0) {
+        syslog(LOG_ERR, "gpio: dispatcher: failed to create wake pipe: %s", strerror(errno));
+        close(d->epoll_fd);
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    memset(&ev, 0, sizeof ev);
+    ev.events = EPOLLIN;
+    ev.data.u64 = MRAA_GPIO_DISPATCH_WAKE_KEY;
+    epoll_ctl(d->epoll_fd, EPOLL_CTL_ADD, d->wake_pipe[0], &ev);
+
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->idle, NULL);
+
+    if (pthread_create(&d->thread_id, NULL, mraa_gpio_dispatch_thread, d) != 0) {
+        syslog(LOG_ERR, "gpio: dispatcher: failed to create thread");
+        close(d->wake_pipe[0]);
+        close(d->wake_pipe[1]);
+        close(d->epoll_fd);
+        pthread_cond_destroy(&d->idle);
+        pthread_mutex_destroy(&d->lock);
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_gpio_use_isr_dispatcher(unsigned int num_threads)
+{
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    if (num_threads > MRAA_GPIO_DISPATCH_MAX_THREADS) {
+        syslog(LOG_ERR, "gpio: use_isr_dispatcher: at most %d threads are supported",
+               MRAA_GPIO_DISPATCH_MAX_THREADS);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&dispatchers_lock);
+
+    if (num_threads == num_dispatchers) {
+        pthread_mutex_unlock(&dispatchers_lock);
+        return MRAA_SUCCESS;
+    }
+
+    // contexts keep a pointer to their dispatcher
+    for (unsigned int i = 0; i < num_dispatchers; ++i) {
+        pthread_mutex_lock(&dispatchers[i].lock);
+        unsigned int num_contexts = dispatchers[i].num_contexts;
+        pthread_mutex_unlock(&dispatchers[i].lock);
+
+        if (num_contexts != 0) {
+            pthread_mutex_unlock(&dispatchers_lock);
+            return MRAA_ERROR_NO_RESOURCES;
+        }
+    }
+
+    for (unsigned int i = 0; i < num_dispatchers; ++i) {
+        mraa_gpio_dispatch_stop(&dispatchers[i]);
+    }
+    free(dispatchers);
+    dispatchers = NULL;
+    num_dispatchers = 0;
+
+    if (num_threads > 0) {
+        dispatchers = calloc(num_threads, sizeof(struct _gpio_dispatcher));
+        if (dispatchers == NULL) {
+            syslog(LOG_ERR, "gpio: use_isr_dispatcher: malloc error");
+            pthread_mutex_unlock(&dispatchers_lock);
+            return MRAA_ERROR_NO_RESOURCES;
+        }
+
+        for (; num_dispatchers < num_threads; ++num_dispatchers) {
+            ret = mraa_gpio_dispatch_start(&dispatchers[num_dispatchers]);
+            if (ret != MRAA_SUCCESS) {
+                break;
+            }
+        }
+
+        if (ret != MRAA_SUCCESS) {
+            for (unsigned int i = 0; i < num_dispatchers; ++i) {
+                mraa_gpio_dispatch_stop(&dispatchers[i]);
+            }
+            free(dispatchers);
+            dispatchers = NULL;
+            num_dispatchers = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&dispatchers_lock);
+
+    return ret;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* Controllers can sit above 2GB, e.g. 0xFE200000, so mmap with a 64-bit off_t on 32-bit hosts. */
+#define _FILE_OFFSET_BITS 64
+
+#include "gpio/gpio_mmap.h"
+#include "gpio.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* One mapping of the controller, shared by all the mmap'ed contexts. */
+static uint8_t* mmap_reg = NULL;
+static size_t mmap_size = 0;
+static unsigned int mmap_count = 0;
+static pthread_mutex_t mmap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static mraa_result_t
+mraa_gpio_mmap_generic_write(mraa_gpio_context dev, int value)
+{
+    *(value ? dev->mmap_set : dev->mmap_clear) = dev->mmap_mask;
+    return MRAA_SUCCESS;
+}
+
+static int
+mraa_gpio_mmap_generic_read(mraa_gpio_context dev)
+{
+    return (*dev->mmap_data & dev->mmap_mask) ? 1 : 0;
+}
+
+static mraa_result_t
+mraa_gpio_mmap_generic_map(const mraa_gpio_mmap_desc_t* desc)
+{
+    if ((uint64_t) (off_t) desc->base != desc->base) {
+        syslog(LOG_ERR, "gpio mmap: base 0x%llx does not fit in off_t", (unsigned long long) desc->base);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    int fd = open(desc->mem_dev, O_RDWR | O_SYNC);
+    if (fd < 0) {
+        syslog(LOG_ERR, "gpio mmap: unable to open %s: %s", desc->mem_dev, strerror(errno));
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    void* reg = mmap(NULL, desc->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t) desc->base);
+    // no need to keep the fd open after mmap
+    close(fd);
+    if (reg == MAP_FAILED) {
+        syslog(LOG_ERR, "gpio mmap: failed to mmap %s: %s", desc->mem_dev, strerror(errno));
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    mmap_reg = (uint8_t*) reg;
+    mmap_size = desc->size;
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_gpio_mmap_generic_setup(mraa_gpio_context dev, mraa_boolean_t en)
+{
+    const mraa_gpio_mmap_desc_t* desc = plat->gpio_mmap;
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    if (dev == NULL) {
+        syslog(LOG_ERR, "gpio mmap: context not valid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (desc == NULL || desc->bank_width == 0 || desc->bank_width > 32) {
+        syslog(LOG_ERR, "gpio mmap: no usable controller description for this platform");
+        return MRAA_ERROR_FEATURE_NOT_IMPLEMENTED;
+    }
+
+    pthread_mutex_lock(&mmap_lock);
+
+    if (en == 0) {
+        if (dev->mmap_write == NULL && dev->mmap_read == NULL) {
+            syslog(LOG_ERR, "gpio mmap: can't disable disabled mmap gpio");
+            pthread_mutex_unlock(&mmap_lock);
+            return MRAA_ERROR_INVALID_PARAMETER;
+        }
+        dev->mmap_write = NULL;
+        dev->mmap_read = NULL;
+        dev->mmap_set = dev->mmap_clear = dev->mmap_data = NULL;
+        if (--mmap_count == 0) {
+            munmap(mmap_reg, mmap_size);
+            mmap_reg = NULL;
+        }
+        pthread_mutex_unlock(&mmap_lock);
+        return MRAA_SUCCESS;
+    }
+
+    if (dev->mmap_write != NULL && dev->mmap_read != NULL) {
+        syslog(LOG_ERR, "gpio mmap: can't enable enabled mmap gpio");
+        pthread_mutex_unlock(&mmap_lock);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    /* Registers are addressed by the sysfs number of the gpio. */
+    int gpio = dev->pin;
+    if (plat->chardev_capable) {
+        if (dev->num_pins != 1 || dev->provided_pins == NULL) {
+            syslog(LOG_ERR, "gpio mmap: only single pin contexts can be mmap'ed");
+            pthread_mutex_unlock(&mmap_lock);
+            return MRAA_ERROR_INVALID_PARAMETER;
+        }
+        gpio = plat->pins[dev->provided_pins[0]].gpio.pinmap;
+    }
+
+    int line = gpio - desc->gpio_base;
+    uint64_t bank_offset = (uint64_t) (line / desc->bank_width) * desc->bank_stride;
+    if (line < 0 || bank_offset + desc->set_reg + 4 > desc->size ||
+        bank_offset + desc->clear_reg + 4 > desc->size || bank_offset + desc->data_reg + 4 > desc->size) {
+        syslog(LOG_ERR, "gpio%i: mmap: gpio is outside of the mapped controller", gpio);
+        pthread_mutex_unlock(&mmap_lock);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    if (mmap_reg == NULL) {
+        ret = mraa_gpio_mmap_generic_map(desc);
+        if (ret != MRAA_SUCCESS) {
+            pthread_mutex_unlock(&mmap_lock);
+            return ret;
+        }
+    }
+    mmap_count++;
+
+    /* Resolve the register addresses once, the accessors are a single volatile access. */
+    dev->mmap_set = (volatile uint32_t*) (mmap_reg + bank_offset + desc->set_reg);
+    dev->mmap_clear = (volatile uint32_t*) (mmap_reg + bank_offset + desc->clear_reg);
+    dev->mmap_data = (volatile uint32_t*) (mmap_reg + bank_offset + desc->data_reg);
+    dev->mmap_mask = (uint32_t) 1 << (line % desc->bank_width);
+    dev->mmap_write = &mraa_gpio_mmap_generic_write;
+    dev->mmap_read = &mraa_gpio_mmap_generic_read;
+
+    pthread_mutex_unlock(&mmap_lock);
+
+    return MRAA_SUCCESS;
+}
@@ -10,6 +10,8 @@
 
 #include "i2c.h"
 #include "mraa_internal.h"
+#include "bus/bus_arbiter.h"
+#include "gpio.h"
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -23,7 +25,9 @@
 #include <sys/ioctl.h>
 #include "linux/i2c-dev.h"
 #include <errno.h>
+#include <pthread.h>
 #include <string.h>
+#include <time.h>
 
 typedef union i2c_smbus_data_union {
     uint8_t byte;        ///< data byte
@@ -42,8 +46,99 @@ typedef struct i2c_smbus_ioctl_data_struct {
 
 // static mraa_adv_func_t* func_table;
 
+/* Whether the context has no /dev/i2c-* file to make SMBus calls on. */
+static mraa_boolean_t
+mraa_i2c_smbus_unavailable(mraa_i2c_context dev)
+{
+    return IS_FUNC_DEFINED(dev, i2c_init_bus_replace) || IS_FUNC_DEFINED(dev, i2c_read_replace) ||
+           IS_FUNC_DEFINED(dev, i2c_write_replace);
+}
+
+static uint64_t
+mraa_i2c_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Whether a transfer may go to the adapter. Once the breaker opened calls
+ * fail with EAGAIN until the cooling period is over, then a single transfer
+ * is let through to find out whether the device is back.
+ */
+static mraa_boolean_t
+mraa_i2c_breaker_allow(mraa_i2c_context dev)
+{
+    if (dev->breaker_threshold == 0 || dev->failures < dev->breaker_threshold) {
+        return 1;
+    }
+    if (mraa_i2c_now_ns() < dev->breaker_until_ns) {
+        errno = EAGAIN;
+        return 0;
+    }
+    return 1;
+}
+
+/* Account for the outcome of a transfer which went to the adapter. */
+static void
+mraa_i2c_breaker_record(mraa_i2c_context dev, mraa_boolean_t ok)
+{
+    if (ok) {
+        if (dev->failures > 1) {
+            syslog(LOG_NOTICE, "i2c%i: transfers succeed again after %u failures", dev->busnum, dev->failures);
+        }
+        dev->failures = 0;
+        dev->error_logged = 0;
+        return;
+    }
+
+    dev->failures++;
+    if (dev->breaker_threshold == 0 || dev->failures < dev->breaker_threshold) {
+        return;
+    }
+    if (dev->failures == dev->breaker_threshold) {
+        syslog(LOG_ERR, "i2c%i: %u transfers failed in a row, failing fast for %u ms", dev->busnum,
+               dev->failures, dev->breaker_cooldown_ms);
+    }
+    if (dev->breaker_recover) {
+        int err = errno;
+        mraa_i2c_recover(dev);
+        errno = err;
+    }
+    dev->breaker_until_ns = mraa_i2c_now_ns() + (uint64_t) dev->breaker_cooldown_ms * 1000000ULL;
+}
+
+/* Only the first failure of a streak is logged, a dead device mustn't flood syslog. */
+static void
+mraa_i2c_access_error(mraa_i2c_context dev, const char* fn)
+{
+    if (!dev->error_logged) {
+        syslog(LOG_ERR, "i2c%i: %s: Access error: %s", dev->busnum, fn, strerror(errno));
+        dev->error_logged = 1;
+    }
+}
+
+/* Every ioctl on the adapter goes through here to be counted. */
+static int
+mraa_i2c_ioctl(mraa_i2c_context dev, unsigned long request, void* arg)
+{
+    if (request != I2C_SMBUS && request != I2C_RDWR) {
+        dev->ioctl_stats.issued++;
+        return ioctl(dev->fh, request, arg);
+    }
+
+    if (!mraa_i2c_breaker_allow(dev)) {
+        return -1;
+    }
+    dev->ioctl_stats.issued++;
+    int ret = ioctl(dev->fh, request, arg);
+    mraa_i2c_breaker_record(dev, ret >= 0);
+    return ret;
+}
+
 int
-mraa_i2c_smbus_access(int fh, uint8_t read_write, uint8_t command, int size, i2c_smbus_data_t* data)
+mraa_i2c_smbus_access(mraa_i2c_context dev, uint8_t read_write, uint8_t command, int size, i2c_smbus_data_t* data)
 {
     i2c_smbus_ioctl_data_t args;
 
@@ -52,11 +147,12 @@ mraa_i2c_smbus_access(int fh, uint8_t read_write, uint8_t command, int size, i2c
     args.size = size;
     args.data = data;
 
-    return ioctl(fh, I2C_SMBUS, &args);
+    return mraa_i2c_ioctl(dev, I2C_SMBUS, &args);
 }
 
+/* arbiter_bus keys the bus arbiter, sub platform buses don't share the kernel numbering. */
 static mraa_i2c_context
-mraa_i2c_init_internal(mraa_adv_func_t* advance_func, unsigned int bus)
+mraa_i2c_init_internal(mraa_adv_func_t* advance_func, unsigned int bus, int arbiter_bus)
 {
     mraa_result_t status = MRAA_SUCCESS;
 
@@ -71,6 +167,10 @@ mraa_i2c_init_internal(mraa_adv_func_t* advance_func, unsigned int bus)
 
     dev->advance_func = advance_func;
     dev->busnum = bus;
+    dev->arbiter = mraa_bus_arbiter_get(MRAA_BUS_ARBITER_I2C, arbiter_bus);
+    dev->priority = MRAA_BUS_PRIORITY_NORMAL;
+    dev->sda_pos = -1;
+    dev->scl_pos = -1;
 
     if (IS_FUNC_DEFINED(dev, i2c_init_pre)) {
         status = advance_func->i2c_init_pre(bus);
@@ -91,7 +191,7 @@ mraa_i2c_init_internal(mraa_adv_func_t* advance_func, unsigned int bus)
             goto init_internal_cleanup;
         }
 
-        if (ioctl(dev->fh, I2C_FUNCS, &dev->funcs) < 0) {
+        if (mraa_i2c_ioctl(dev, I2C_FUNCS, &dev->funcs) < 0) {
             syslog(LOG_CRIT, "i2c%i_init: Failed to get I2C_FUNC map from device: %s", bus, strerror(errno));
             dev->funcs = 0;
         }
@@ -115,9 +215,27 @@ init_internal_cleanup:
 }
 
 
+/* Mux a board pin to its i2c function. */
+static mraa_result_t
+mraa_i2c_setup_pin(mraa_board_t* board, int pos)
+{
+    if (pos < 0) {
+        return MRAA_SUCCESS;
+    }
+    if (board->pins[pos].i2c.mux_total > 0 && mraa_setup_mux_mapped(board->pins[pos].i2c) != MRAA_SUCCESS) {
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    if (board->adv_func->mux_init_reg && board->adv_func->mux_init_reg(pos, MUX_REGISTER_MODE_I2C) != MRAA_SUCCESS) {
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    return MRAA_SUCCESS;
+}
+
 mraa_i2c_context
 mraa_i2c_init(int bus)
 {
+    mraa_init();
+
     mraa_board_t* board = plat;
     if (board == NULL) {
         syslog(LOG_ERR, "i2c%i_init: Platform Not Initialised", bus);
@@ -149,42 +267,34 @@ mraa_i2c_init(int bus)
         bus = board->def_i2c_bus;
     }
     if (!board->no_bus_mux) {
-        int pos = board->i2c_bus[bus].sda;
-        if (pos >=0 && board->pins[pos].i2c.mux_total > 0) {
-            if (mraa_setup_mux_mapped(board->pins[pos].i2c) != MRAA_SUCCESS) {
-                syslog(LOG_ERR, "i2c%i_init: Failed to set-up i2c sda multiplexer", bus);
-                return NULL;
-            }
-        }
-        if (pos >= 0 && board->adv_func->mux_init_reg) {
-            if(board->adv_func->mux_init_reg(pos, MUX_REGISTER_MODE_I2C) != MRAA_SUCCESS) {
-                syslog(LOG_ERR, "i2c%i_init: Failed to set-up i2c sda multiplex register", bus);
-                return NULL;
-            }
-        }
-        pos = board->i2c_bus[bus].scl;
-        if (pos >=0 && board->pins[pos].i2c.mux_total > 0) {
-            if (mraa_setup_mux_mapped(board->pins[pos].i2c) != MRAA_SUCCESS) {
-                syslog(LOG_ERR, "i2c%i_init: Failed to set-up i2c scl multiplexer", bus);
-                return NULL;
-            }
+        if (mraa_i2c_setup_pin(board, board->i2c_bus[bus].sda) != MRAA_SUCCESS) {
+            syslog(LOG_ERR, "i2c%i_init: Failed to set-up i2c sda multiplexer", bus);
+            return NULL;
         }
-        if (pos >= 0 && board->adv_func->mux_init_reg) {
-            if(board->adv_func->mux_init_reg(pos, MUX_REGISTER_MODE_I2C) != MRAA_SUCCESS) {
-                syslog(LOG_ERR, "i2c%i_init: Failed to set-up scl sda multiplex register", bus);
-                return NULL;
-            }
+        if (mraa_i2c_setup_pin(board, board->i2c_bus[bus].scl) != MRAA_SUCCESS) {
+            syslog(LOG_ERR, "i2c%i_init: Failed to set-up i2c scl multiplexer", bus);
+            return NULL;
         }
     }
 
-    return mraa_i2c_init_internal(board->adv_func, (unsigned int) board->i2c_bus[bus].bus_id);
+    int bus_id = board->i2c_bus[bus].bus_id;
+    int arbiter_bus = board == plat ? bus_id : mraa_get_sub_platform_id(bus_id);
+    mraa_i2c_context dev = mraa_i2c_init_internal(board->adv_func, (unsigned int) bus_id, arbiter_bus);
+    if (dev != NULL) {
+        dev->board = board;
+        dev->sda_pos = board->i2c_bus[bus].sda;
+        dev->scl_pos = board->i2c_bus[bus].scl;
+    }
+    return dev;
 }
 
 
 mraa_i2c_context
 mraa_i2c_init_raw(unsigned int bus)
 {
-    return mraa_i2c_init_internal(plat == NULL ? NULL : plat->adv_func, bus);
+    mraa_init();
+
+    return mraa_i2c_init_internal(plat == NULL ? NULL : plat->adv_func, bus, (int) bus);
 }
 
 
@@ -211,12 +321,15 @@ mraa_i2c_read(mraa_i2c_context dev, uint8_t* data, int length)
     }
 
     int bytes_read = 0;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
     if (IS_FUNC_DEFINED(dev, i2c_read_replace)) {
         bytes_read = dev->advance_func->i2c_read_replace(dev, data, length);
     }
-    else {
+    else if (mraa_i2c_breaker_allow(dev)) {
         bytes_read = read(dev->fh, data, length);
+        mraa_i2c_breaker_record(dev, bytes_read == length);
     }
+    mraa_bus_arbiter_release(dev->arbiter);
     if (bytes_read == length) {
         return length;
     }
@@ -232,14 +345,19 @@ mraa_i2c_read_byte(mraa_i2c_context dev)
         return -1;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_read_byte_replace))
-        return dev->advance_func->i2c_read_byte_replace(dev);
+    int ret;
     i2c_smbus_data_t d;
-    if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_READ, I2C_NOCMD, I2C_SMBUS_BYTE, &d) < 0) {
-        syslog(LOG_ERR, "i2c%i: read_byte: Access error: %s", dev->busnum, strerror(errno));
-        return -1;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (IS_FUNC_DEFINED(dev, i2c_read_byte_replace)) {
+        ret = dev->advance_func->i2c_read_byte_replace(dev);
+    } else if (mraa_i2c_smbus_access(dev, I2C_SMBUS_READ, I2C_NOCMD, I2C_SMBUS_BYTE, &d) < 0) {
+        mraa_i2c_access_error(dev, "read_byte");
+        ret = -1;
+    } else {
+        ret = 0x0FF & d.byte;
     }
-    return 0x0FF & d.byte;
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
 }
 
 int
@@ -250,14 +368,19 @@ mraa_i2c_read_byte_data(mraa_i2c_context dev, uint8_t command)
         return -1;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_read_byte_data_replace))
-        return dev->advance_func->i2c_read_byte_data_replace(dev, command);
+    int ret;
     i2c_smbus_data_t d;
-    if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_READ, command, I2C_SMBUS_BYTE_DATA, &d) < 0) {
-       syslog(LOG_ERR, "i2c%i: read_byte_data: Access error: %s", dev->busnum, strerror(errno));
-       return -1;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (IS_FUNC_DEFINED(dev, i2c_read_byte_data_replace)) {
+        ret = dev->advance_func->i2c_read_byte_data_replace(dev, command);
+    } else if (mraa_i2c_smbus_access(dev, I2C_SMBUS_READ, command, I2C_SMBUS_BYTE_DATA, &d) < 0) {
+        mraa_i2c_access_error(dev, "read_byte_data");
+        ret = -1;
+    } else {
+        ret = 0x0FF & d.byte;
     }
-    return 0x0FF & d.byte;
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
 }
 
 int
@@ -268,14 +391,50 @@ mraa_i2c_read_word_data(mraa_i2c_context dev, uint8_t command)
         return -1;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_read_word_data_replace))
-        return dev->advance_func->i2c_read_word_data_replace(dev, command);
+    int ret;
     i2c_smbus_data_t d;
-    if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_READ, command, I2C_SMBUS_WORD_DATA, &d) < 0) {
-        syslog(LOG_ERR, "i2c%i: read_word_data: Access error: %s", dev->busnum, strerror(errno));
-        return -1;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (IS_FUNC_DEFINED(dev, i2c_read_word_data_replace)) {
+        ret = dev->advance_func->i2c_read_word_data_replace(dev, command);
+    } else if (mraa_i2c_smbus_access(dev, I2C_SMBUS_READ, command, I2C_SMBUS_WORD_DATA, &d) < 0) {
+        mraa_i2c_access_error(dev, "read_word_data");
+        ret = -1;
+    } else {
+        ret = 0xFFFF & d.word;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
+}
+
+/*
+ * SMBus-only adapters can't do plain i2c reads, the register range is read
+ * in I2C_SMBUS_I2C_BLOCK_DATA chunks instead, the device auto-incrementing
+ * its register pointer as it would on a single read.
+ */
+static int
+mraa_i2c_read_bytes_data_smbus(mraa_i2c_context dev, uint8_t command, uint8_t* data, int length)
+{
+    i2c_smbus_data_t d;
+    int done = 0;
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    while (done < length) {
+        int chunk = length - done;
+        if (chunk > I2C_SMBUS_I2C_BLOCK_MAX) {
+            chunk = I2C_SMBUS_I2C_BLOCK_MAX;
+        }
+        d.block[0] = chunk;
+        if (mraa_i2c_smbus_access(dev, I2C_SMBUS_READ, (uint8_t) (command + done), I2C_SMBUS_I2C_BLOCK_DATA, &d) < 0) {
+            mraa_i2c_access_error(dev, "read_bytes_data");
+            mraa_bus_arbiter_release(dev->arbiter);
+            return -1;
+        }
+        memcpy(data + done, &d.block[1], chunk);
+        done += chunk;
     }
-    return 0xFFFF & d.word;
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return length;
 }
 
 int
@@ -286,8 +445,16 @@ mraa_i2c_read_bytes_data(mraa_i2c_context dev, uint8_t command, uint8_t* data, i
         return -1;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_read_bytes_data_replace))
-        return dev->advance_func->i2c_read_bytes_data_replace(dev, command, data, length);
+    if (IS_FUNC_DEFINED(dev, i2c_read_bytes_data_replace)) {
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        int ret = dev->advance_func->i2c_read_bytes_data_replace(dev, command, data, length);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
+    }
+    if (dev->funcs != 0 && !(dev->funcs & I2C_FUNC_I2C) && (dev->funcs & I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+        return mraa_i2c_read_bytes_data_smbus(dev, command, data, length);
+    }
+
     struct i2c_rdwr_ioctl_data d;
     struct i2c_msg m[2];
 
@@ -303,11 +470,13 @@ mraa_i2c_read_bytes_data(mraa_i2c_context dev, uint8_t command, uint8_t* data, i
     d.msgs = m;
     d.nmsgs = 2;
 
-    int ret = ioctl(dev->fh, I2C_RDWR, &d);
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_i2c_ioctl(dev, I2C_RDWR, &d);
+    mraa_bus_arbiter_release(dev->arbiter);
 
     if (ret < 0)
     {
-        syslog(LOG_ERR, "i2c%i: read_bytes_data: Access error: %s", dev->busnum, strerror(errno));
+        mraa_i2c_access_error(dev, "read_bytes_data");
         return -1;
     }
     return length;
@@ -321,8 +490,28 @@ mraa_i2c_write(mraa_i2c_context dev, const uint8_t* data, int length)
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_write_replace))
-        return dev->advance_func->i2c_write_replace(dev, data, length);
+    if (IS_FUNC_DEFINED(dev, i2c_write_replace)) {
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->i2c_write_replace(dev, data, length);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
+    }
+    // too long for one SMBus block, plain i2c adapters take it in one go
+    if (length > I2C_SMBUS_I2C_BLOCK_MAX + 1 && (dev->funcs & I2C_FUNC_I2C)) {
+        ssize_t written = -1;
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        if (mraa_i2c_breaker_allow(dev)) {
+            written = write(dev->fh, data, length);
+            mraa_i2c_breaker_record(dev, written == length);
+        }
+        mraa_bus_arbiter_release(dev->arbiter);
+        if (written != length) {
+            mraa_i2c_access_error(dev, "write");
+            return MRAA_ERROR_UNSPECIFIED;
+        }
+        return MRAA_SUCCESS;
+    }
+
     i2c_smbus_data_t d;
     int i;
     uint8_t command = data[0];
@@ -338,8 +527,11 @@ mraa_i2c_write(mraa_i2c_context dev, const uint8_t* data, int length)
     }
     d.block[0] = length;
 
-    if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_WRITE, command, I2C_SMBUS_I2C_BLOCK_DATA, &d) < 0) {
-        syslog(LOG_ERR, "i2c%i: write: Access error: %s", dev->busnum, strerror(errno));
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_i2c_smbus_access(dev, I2C_SMBUS_WRITE, command, I2C_SMBUS_I2C_BLOCK_DATA, &d);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
+        mraa_i2c_access_error(dev, "write");
         return MRAA_ERROR_UNSPECIFIED;
     }
     return MRAA_SUCCESS;
@@ -353,15 +545,16 @@ mraa_i2c_write_byte(mraa_i2c_context dev, const uint8_t data)
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
+    mraa_result_t ret = MRAA_SUCCESS;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
     if (IS_FUNC_DEFINED(dev, i2c_write_byte_replace)) {
-        return dev->advance_func->i2c_write_byte_replace(dev, data);
-    } else {
-        if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_WRITE, data, I2C_SMBUS_BYTE, NULL) < 0) {
-            syslog(LOG_ERR, "i2c%i: write_byte: Access error: %s", dev->busnum, strerror(errno));
-            return MRAA_ERROR_UNSPECIFIED;
-        }
-        return MRAA_SUCCESS;
+        ret = dev->advance_func->i2c_write_byte_replace(dev, data);
+    } else if (mraa_i2c_smbus_access(dev, I2C_SMBUS_WRITE, data, I2C_SMBUS_BYTE, NULL) < 0) {
+        mraa_i2c_access_error(dev, "write_byte");
+        ret = MRAA_ERROR_UNSPECIFIED;
     }
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
 }
 
 mraa_result_t
@@ -372,15 +565,18 @@ mraa_i2c_write_byte_data(mraa_i2c_context dev, const uint8_t data, const uint8_t
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_write_byte_data_replace))
-        return dev->advance_func->i2c_write_byte_data_replace(dev, data, command);
+    mraa_result_t ret = MRAA_SUCCESS;
     i2c_smbus_data_t d;
     d.byte = data;
-    if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_WRITE, command, I2C_SMBUS_BYTE_DATA, &d) < 0) {
-        syslog(LOG_ERR, "i2c%i: write_byte_data: Access error: %s", dev->busnum, strerror(errno));
-        return MRAA_ERROR_UNSPECIFIED;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (IS_FUNC_DEFINED(dev, i2c_write_byte_data_replace)) {
+        ret = dev->advance_func->i2c_write_byte_data_replace(dev, data, command);
+    } else if (mraa_i2c_smbus_access(dev, I2C_SMBUS_WRITE, command, I2C_SMBUS_BYTE_DATA, &d) < 0) {
+        mraa_i2c_access_error(dev, "write_byte_data");
+        ret = MRAA_ERROR_UNSPECIFIED;
     }
-    return MRAA_SUCCESS;
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
 }
 
 mraa_result_t
@@ -391,14 +587,118 @@ mraa_i2c_write_word_data(mraa_i2c_context dev, const uint16_t data, const uint8_
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
-    if (IS_FUNC_DEFINED(dev, i2c_write_word_data_replace))
-        return dev->advance_func->i2c_write_word_data_replace(dev, data, command);
+    mraa_result_t ret = MRAA_SUCCESS;
     i2c_smbus_data_t d;
     d.word = data;
-    if (mraa_i2c_smbus_access(dev->fh, I2C_SMBUS_WRITE, command, I2C_SMBUS_WORD_DATA, &d) < 0) {
-        syslog(LOG_ERR, "i2c%i: write_word_data: Access error: %s", dev->busnum, strerror(errno));
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (IS_FUNC_DEFINED(dev, i2c_write_word_data_replace)) {
+        ret = dev->advance_func->i2c_write_word_data_replace(dev, data, command);
+    } else if (mraa_i2c_smbus_access(dev, I2C_SMBUS_WRITE, command, I2C_SMBUS_WORD_DATA, &d) < 0) {
+        mraa_i2c_access_error(dev, "write_word_data");
+        ret = MRAA_ERROR_UNSPECIFIED;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
+}
+
+int
+mraa_i2c_read_block_data(mraa_i2c_context dev, uint8_t command, uint8_t* data)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: read_block_data: context is invalid");
+        return -1;
+    }
+
+    if (data == NULL) {
+        syslog(LOG_ERR, "i2c%i: read_block_data: buffer is invalid", dev->busnum);
+        return -1;
+    }
+
+    if (mraa_i2c_smbus_unavailable(dev) || (dev->funcs != 0 && !(dev->funcs & I2C_FUNC_SMBUS_READ_BLOCK_DATA))) {
+        syslog(LOG_ERR, "i2c%i: read_block_data: adapter doesn't support SMBus block reads", dev->busnum);
+        return -1;
+    }
+
+    i2c_smbus_data_t d;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_i2c_smbus_access(dev, I2C_SMBUS_READ, command, I2C_SMBUS_BLOCK_DATA, &d);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
+        mraa_i2c_access_error(dev, "read_block_data");
+        return -1;
+    }
+
+    int length = d.block[0];
+    if (length > I2C_SMBUS_BLOCK_MAX) {
+        length = I2C_SMBUS_BLOCK_MAX;
+    }
+    memcpy(data, &d.block[1], length);
+    return length;
+}
+
+mraa_result_t
+mraa_i2c_write_block_data(mraa_i2c_context dev, uint8_t command, const uint8_t* data, int length)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: write_block_data: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (data == NULL || length < 0 || length > I2C_SMBUS_BLOCK_MAX) {
+        syslog(LOG_ERR, "i2c%i: write_block_data: invalid block of %d bytes", dev->busnum, length);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    // what goes on the wire is the register, the count, then the bytes
+    if (IS_FUNC_DEFINED(dev, i2c_write_replace)) {
+        uint8_t buf[I2C_SMBUS_BLOCK_MAX + 2];
+        buf[0] = command;
+        buf[1] = (uint8_t) length;
+        memcpy(&buf[2], data, length);
+        return mraa_i2c_write(dev, buf, length + 2);
+    }
+
+    if (mraa_i2c_smbus_unavailable(dev) || (dev->funcs != 0 && !(dev->funcs & I2C_FUNC_SMBUS_WRITE_BLOCK_DATA))) {
+        syslog(LOG_ERR, "i2c%i: write_block_data: adapter doesn't support SMBus block writes", dev->busnum);
+        return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    i2c_smbus_data_t d;
+    d.block[0] = (uint8_t) length;
+    memcpy(&d.block[1], data, length);
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_i2c_smbus_access(dev, I2C_SMBUS_WRITE, command, I2C_SMBUS_BLOCK_DATA, &d);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
+        mraa_i2c_access_error(dev, "write_block_data");
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_set_pec(mraa_i2c_context dev, mraa_boolean_t enable)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: set_pec: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (mraa_i2c_smbus_unavailable(dev) || (enable && dev->funcs != 0 && !(dev->funcs & I2C_FUNC_SMBUS_PEC))) {
+        syslog(LOG_ERR, "i2c%i: set_pec: adapter doesn't support PEC", dev->busnum);
+        return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    enable = enable ? 1 : 0;
+    if (dev->pec == enable) {
+        dev->ioctl_stats.avoided++;
+        return MRAA_SUCCESS;
+    }
+    if (mraa_i2c_ioctl(dev, I2C_PEC, (void*) (unsigned long) enable) < 0) {
+        syslog(LOG_ERR, "i2c%i: set_pec: Failed to set PEC: %s", dev->busnum, strerror(errno));
         return MRAA_ERROR_UNSPECIFIED;
     }
+    dev->pec = enable;
     return MRAA_SUCCESS;
 }
 
@@ -410,18 +710,226 @@ mraa_i2c_address(mraa_i2c_context dev, uint8_t addr)
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
+    mraa_result_t ret = MRAA_SUCCESS;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
     dev->addr = (int) addr;
     if (IS_FUNC_DEFINED(dev, i2c_address_replace)) {
-        return dev->advance_func->i2c_address_replace(dev, addr);
+        ret = dev->advance_func->i2c_address_replace(dev, addr);
+    } else if (dev->kernel_addr_set && dev->kernel_addr == addr) {
+        // the fd already targets addr
+        dev->ioctl_stats.avoided++;
+    } else if (mraa_i2c_ioctl(dev, I2C_SLAVE_FORCE, (void*) (unsigned long) addr) < 0) {
+        syslog(LOG_ERR, "i2c%i: address: Failed to set slave address %d: %s", dev->busnum, addr, strerror(errno));
+        dev->kernel_addr_set = 0;
+        ret = MRAA_ERROR_UNSPECIFIED;
     } else {
-        if (ioctl(dev->fh, I2C_SLAVE_FORCE, addr) < 0) {
-            syslog(LOG_ERR, "i2c%i: address: Failed to set slave address %d: %s", dev->busnum, addr, strerror(errno));
-            return MRAA_ERROR_UNSPECIFIED;
+        dev->kernel_addr = addr;
+        dev->kernel_addr_set = 1;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+    return ret;
+}
+
+mraa_result_t
+mraa_i2c_set_priority(mraa_i2c_context dev, mraa_bus_priority_t priority)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: set_priority: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if ((unsigned int) priority >= MRAA_BUS_PRIORITY_COUNT) {
+        syslog(LOG_ERR, "i2c%i: set_priority: invalid priority %d", dev->busnum, priority);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    dev->priority = priority;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_bus_acquire(mraa_i2c_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: bus_acquire: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_bus_release(mraa_i2c_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: bus_release: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    return mraa_bus_arbiter_release(dev->arbiter);
+}
+
+mraa_result_t
+mraa_i2c_bus_stats(mraa_i2c_context dev, mraa_bus_stats_t* stats)
+{
+    if (dev == NULL || stats == NULL) {
+        syslog(LOG_ERR, "i2c: bus_stats: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    mraa_bus_arbiter_stats(dev->arbiter, stats);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_set_timeout(mraa_i2c_context dev, unsigned int timeout_ms)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: set_timeout: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (mraa_i2c_smbus_unavailable(dev)) {
+        syslog(LOG_ERR, "i2c%i: set_timeout: not supported on this platform", dev->busnum);
+        return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    // the kernel counts in jiffies of 10 ms
+    unsigned long ticks = (timeout_ms + 9) / 10;
+    if (mraa_i2c_ioctl(dev, I2C_TIMEOUT, (void*) ticks) < 0) {
+        syslog(LOG_ERR, "i2c%i: set_timeout: Failed to set timeout: %s", dev->busnum, strerror(errno));
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_set_retries(mraa_i2c_context dev, unsigned int retries)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: set_retries: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (mraa_i2c_smbus_unavailable(dev)) {
+        syslog(LOG_ERR, "i2c%i: set_retries: not supported on this platform", dev->busnum);
+        return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    if (mraa_i2c_ioctl(dev, I2C_RETRIES, (void*) (unsigned long) retries) < 0) {
+        syslog(LOG_ERR, "i2c%i: set_retries: Failed to set retries: %s", dev->busnum, strerror(errno));
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_set_breaker(mraa_i2c_context dev, unsigned int max_failures, unsigned int cooldown_ms, mraa_boolean_t recover)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: set_breaker: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    dev->breaker_threshold = max_failures;
+    dev->breaker_cooldown_ms = cooldown_ms;
+    dev->breaker_recover = recover ? 1 : 0;
+    dev->breaker_until_ns = 0;
+    mraa_bus_arbiter_release(dev->arbiter);
+    return MRAA_SUCCESS;
+}
+
+/* Half an SCL period at 100 kHz. */
+#define I2C_RECOVER_DELAY_US 5
+
+mraa_result_t
+mraa_i2c_recover(mraa_i2c_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: recover: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (dev->board == NULL || dev->scl_pos < 0 || !dev->board->pins[dev->scl_pos].capabilities.gpio) {
+        syslog(LOG_ERR, "i2c%i: recover: scl pin can't be driven as a gpio", dev->busnum);
+        return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    int scl_pin = dev->scl_pos;
+    int sda_pin = dev->sda_pos;
+    if (dev->board != plat) {
+        scl_pin = mraa_get_sub_platform_id(scl_pin);
+        sda_pin = sda_pin < 0 ? -1 : mraa_get_sub_platform_id(sda_pin);
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    mraa_gpio_context scl = mraa_gpio_init(scl_pin);
+    if (scl == NULL) {
+        mraa_bus_arbiter_release(dev->arbiter);
+        syslog(LOG_ERR, "i2c%i: recover: Failed to take over the scl pin", dev->busnum);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    mraa_gpio_context sda = NULL;
+    if (sda_pin >= 0 && dev->board->pins[dev->sda_pos].capabilities.gpio) {
+        sda = mraa_gpio_init(sda_pin);
+    }
+    if (sda != NULL) {
+        mraa_gpio_dir(sda, MRAA_GPIO_IN);
+    }
+
+    // up to 9 clocks make a slave stuck mid-byte shift out its data and ack
+    mraa_gpio_dir(scl, MRAA_GPIO_OUT_HIGH);
+    for (int i = 0; i < 9; i++) {
+        if (sda != NULL && mraa_gpio_read(sda) == 1) {
+            break;
         }
-        return MRAA_SUCCESS;
+        mraa_gpio_write(scl, 0);
+        usleep(I2C_RECOVER_DELAY_US);
+        mraa_gpio_write(scl, 1);
+        usleep(I2C_RECOVER_DELAY_US);
+    }
+
+    // then a stop condition, sda rising while scl is high
+    mraa_result_t ret = MRAA_SUCCESS;
+    if (sda != NULL) {
+        mraa_gpio_dir(sda, MRAA_GPIO_OUT_LOW);
+        usleep(I2C_RECOVER_DELAY_US);
+        mraa_gpio_dir(sda, MRAA_GPIO_IN);
+        usleep(I2C_RECOVER_DELAY_US);
+        if (mraa_gpio_read(sda) != 1) {
+            ret = MRAA_ERROR_UNSPECIFIED;
+        }
+        mraa_gpio_close(sda);
+    }
+    mraa_gpio_close(scl);
+
+    if (!dev->board->no_bus_mux) {
+        mraa_i2c_setup_pin(dev->board, dev->sda_pos);
+        mraa_i2c_setup_pin(dev->board, dev->scl_pos);
     }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    if (ret != MRAA_SUCCESS) {
+        syslog(LOG_ERR, "i2c%i: recover: sda is still held low", dev->busnum);
+    } else {
+        syslog(LOG_NOTICE, "i2c%i: recover: bus released", dev->busnum);
+    }
+    return ret;
 }
 
+mraa_result_t
+mraa_i2c_ioctl_stats(mraa_i2c_context dev, mraa_bus_ioctl_stats_t* stats)
+{
+    if (dev == NULL || stats == NULL) {
+        syslog(LOG_ERR, "i2c: ioctl_stats: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    *stats = dev->ioctl_stats;
+    return MRAA_SUCCESS;
+}
 
 mraa_result_t
 mraa_i2c_stop(mraa_i2c_context dev)
@@ -431,6 +939,9 @@ mraa_i2c_stop(mraa_i2c_context dev)
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
+    mraa_bus_arbiter_cancel(dev->arbiter, dev);
+    mraa_i2c_regcache_close(dev);
+
     if (IS_FUNC_DEFINED(dev, i2c_stop_replace)) {
         return dev->advance_func->i2c_stop_replace(dev);
     }
@@ -440,3 +951,976 @@ mraa_i2c_stop(mraa_i2c_context dev)
     return MRAA_SUCCESS;
 }
 
+
+/* Kernel limit on the length of a single I2C_RDWR message. */
+#define I2C_TXN_MAX_MSG_LEN 8192
+
+/* Whether messages can't go straight to I2C_RDWR on this context. */
+static mraa_boolean_t
+mraa_i2c_rdwr_unavailable(mraa_i2c_context dev)
+{
+    if (IS_FUNC_DEFINED(dev, i2c_init_bus_replace) || IS_FUNC_DEFINED(dev, i2c_read_replace) ||
+        IS_FUNC_DEFINED(dev, i2c_write_replace)) {
+        return 1;
+    }
+    return dev->funcs != 0 && !(dev->funcs & I2C_FUNC_I2C);
+}
+
+/*
+ * Hold the bus and switch the context to address, the previous address is
+ * restored by mraa_i2c_deselect().
+ */
+static mraa_result_t
+mraa_i2c_select(mraa_i2c_context dev, uint8_t address, int* orig_addr)
+{
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    *orig_addr = dev->addr;
+    if (dev->addr == address) {
+        return MRAA_SUCCESS;
+    }
+
+    mraa_result_t ret = mraa_i2c_address(dev, address);
+    if (ret != MRAA_SUCCESS) {
+        if (dev->addr != *orig_addr) {
+            mraa_i2c_address(dev, (uint8_t) *orig_addr);
+        }
+        mraa_bus_arbiter_release(dev->arbiter);
+    }
+    return ret;
+}
+
+static void
+mraa_i2c_deselect(mraa_i2c_context dev, int orig_addr)
+{
+    if (dev->addr != orig_addr) {
+        mraa_i2c_address(dev, (uint8_t) orig_addr);
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+}
+
+static mraa_result_t
+mraa_i2c_rdwr(mraa_i2c_context dev, struct i2c_msg* m, int nmsgs, const char* fn)
+{
+    struct i2c_rdwr_ioctl_data d;
+
+    d.msgs = m;
+    d.nmsgs = nmsgs;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_i2c_ioctl(dev, I2C_RDWR, &d);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
+        mraa_i2c_access_error(dev, fn);
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    return MRAA_SUCCESS;
+}
+
+int
+mraa_i2c_read_from(mraa_i2c_context dev, uint8_t address, uint8_t* data, int length)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: read_from: context is invalid");
+        return -1;
+    }
+
+    if (data == NULL || length <= 0 || length > I2C_TXN_MAX_MSG_LEN) {
+        syslog(LOG_ERR, "i2c%i: read_from: invalid read of %d bytes", dev->busnum, length);
+        return -1;
+    }
+
+    if (mraa_i2c_rdwr_unavailable(dev)) {
+        int orig_addr;
+        if (mraa_i2c_select(dev, address, &orig_addr) != MRAA_SUCCESS) {
+            return -1;
+        }
+        int ret = mraa_i2c_read(dev, data, length);
+        mraa_i2c_deselect(dev, orig_addr);
+        return ret;
+    }
+
+    struct i2c_msg m;
+    m.addr = address;
+    m.flags = I2C_M_RD;
+    m.len = length;
+    m.buf = (char*) data;
+    if (mraa_i2c_rdwr(dev, &m, 1, "read_from") != MRAA_SUCCESS) {
+        return -1;
+    }
+    return length;
+}
+
+int
+mraa_i2c_read_byte_data_from(mraa_i2c_context dev, uint8_t address, uint8_t command)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: read_byte_data_from: context is invalid");
+        return -1;
+    }
+
+    if (mraa_i2c_rdwr_unavailable(dev)) {
+        int orig_addr;
+        if (mraa_i2c_select(dev, address, &orig_addr) != MRAA_SUCCESS) {
+            return -1;
+        }
+        int ret = mraa_i2c_read_byte_data(dev, command);
+        mraa_i2c_deselect(dev, orig_addr);
+        return ret;
+    }
+
+    uint8_t data;
+    if (mraa_i2c_read_bytes_data_from(dev, address, command, &data, 1) != 1) {
+        return -1;
+    }
+    return data;
+}
+
+int
+mraa_i2c_read_bytes_data_from(mraa_i2c_context dev, uint8_t address, uint8_t command, uint8_t* data, int length)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: read_bytes_data_from: context is invalid");
+        return -1;
+    }
+
+    if (data == NULL || length <= 0 || length > I2C_TXN_MAX_MSG_LEN) {
+        syslog(LOG_ERR, "i2c%i: read_bytes_data_from: invalid read of %d bytes", dev->busnum, length);
+        return -1;
+    }
+
+    if (mraa_i2c_rdwr_unavailable(dev)) {
+        int orig_addr;
+        if (mraa_i2c_select(dev, address, &orig_addr) != MRAA_SUCCESS) {
+            return -1;
+        }
+        int ret = mraa_i2c_read_bytes_data(dev, command, data, length);
+        mraa_i2c_deselect(dev, orig_addr);
+        return ret;
+    }
+
+    struct i2c_msg m[2];
+    m[0].addr = address;
+    m[0].flags = 0;
+    m[0].len = 1;
+    m[0].buf = (char*) &command;
+    m[1].addr = address;
+    m[1].flags = I2C_M_RD;
+    m[1].len = length;
+    m[1].buf = (char*) data;
+    if (mraa_i2c_rdwr(dev, m, 2, "read_bytes_data_from") != MRAA_SUCCESS) {
+        return -1;
+    }
+    return length;
+}
+
+mraa_result_t
+mraa_i2c_write_to(mraa_i2c_context dev, uint8_t address, const uint8_t* data, int length)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: write_to: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (data == NULL || length <= 0 || length > I2C_TXN_MAX_MSG_LEN) {
+        syslog(LOG_ERR, "i2c%i: write_to: invalid write of %d bytes", dev->busnum, length);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    if (mraa_i2c_rdwr_unavailable(dev)) {
+        int orig_addr;
+        mraa_result_t ret = mraa_i2c_select(dev, address, &orig_addr);
+        if (ret != MRAA_SUCCESS) {
+            return ret;
+        }
+        ret = mraa_i2c_write(dev, data, length);
+        mraa_i2c_deselect(dev, orig_addr);
+        return ret;
+    }
+
+    struct i2c_msg m;
+    m.addr = address;
+    m.flags = 0;
+    m.len = length;
+    m.buf = (char*) data;
+    return mraa_i2c_rdwr(dev, &m, 1, "write_to");
+}
+
+mraa_result_t
+mraa_i2c_write_byte_data_to(mraa_i2c_context dev, uint8_t address, const uint8_t data, const uint8_t command)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: write_byte_data_to: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (mraa_i2c_rdwr_unavailable(dev)) {
+        int orig_addr;
+        mraa_result_t ret = mraa_i2c_select(dev, address, &orig_addr);
+        if (ret != MRAA_SUCCESS) {
+            return ret;
+        }
+        ret = mraa_i2c_write_byte_data(dev, data, command);
+        mraa_i2c_deselect(dev, orig_addr);
+        return ret;
+    }
+
+    uint8_t buf[2] = { command, data };
+    return mraa_i2c_write_to(dev, address, buf, 2);
+}
+
+mraa_i2c_txn
+mraa_i2c_txn_init(mraa_i2c_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: txn_init: context is invalid");
+        return NULL;
+    }
+
+    mraa_i2c_txn txn = (mraa_i2c_txn) calloc(1, sizeof(struct _i2c_txn));
+    if (txn == NULL) {
+        syslog(LOG_CRIT, "i2c%i: txn_init: Failed to allocate memory for transaction", dev->busnum);
+        return NULL;
+    }
+    txn->dev = dev;
+
+    return txn;
+}
+
+static mraa_result_t
+mraa_i2c_txn_add(mraa_i2c_txn txn, uint8_t address, uint16_t flags, const uint8_t* wdata, uint8_t* rbuf, int length)
+{
+    if (txn == NULL) {
+        syslog(LOG_ERR, "i2c: txn: transaction is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (length <= 0 || length > I2C_TXN_MAX_MSG_LEN || (wdata == NULL && rbuf == NULL)) {
+        syslog(LOG_ERR, "i2c%i: txn: invalid message of %d bytes", txn->dev->busnum, length);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    if (txn->num_msgs == txn->max_msgs) {
+        unsigned int max_msgs = txn->max_msgs ? txn->max_msgs * 2 : 8;
+        struct _i2c_txn_msg* msgs = realloc(txn->msgs, max_msgs * sizeof(struct _i2c_txn_msg));
+        if (msgs == NULL) {
+            syslog(LOG_CRIT, "i2c%i: txn: Failed to allocate memory for message", txn->dev->busnum);
+            return MRAA_ERROR_NO_RESOURCES;
+        }
+        txn->msgs = msgs;
+        txn->max_msgs = max_msgs;
+    }
+
+    struct _i2c_txn_msg* msg = &txn->msgs[txn->num_msgs];
+    msg->addr = address;
+    msg->flags = flags;
+    msg->len = length;
+    msg->rbuf = rbuf;
+    msg->offset = txn->pool_len;
+
+    if (wdata != NULL) {
+        if (txn->pool_len + length > txn->pool_size) {
+            size_t pool_size = txn->pool_size ? txn->pool_size : 64;
+            while (pool_size < txn->pool_len + length) {
+                pool_size *= 2;
+            }
+            uint8_t* pool = realloc(txn->pool, pool_size);
+            if (pool == NULL) {
+                syslog(LOG_CRIT, "i2c%i: txn: Failed to allocate memory for message", txn->dev->busnum);
+                return MRAA_ERROR_NO_RESOURCES;
+            }
+            txn->pool = pool;
+            txn->pool_size = pool_size;
+        }
+        memcpy(txn->pool + txn->pool_len, wdata, length);
+        txn->pool_len += length;
+    }
+
+    txn->num_msgs++;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_txn_write(mraa_i2c_txn txn, uint8_t address, const uint8_t* data, int length)
+{
+    if (data == NULL) {
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+    return mraa_i2c_txn_add(txn, address, 0, data, NULL, length);
+}
+
+mraa_result_t
+mraa_i2c_txn_write_byte_data(mraa_i2c_txn txn, uint8_t address, const uint8_t data, const uint8_t command)
+{
+    uint8_t buf[2] = { command, data };
+    return mraa_i2c_txn_add(txn, address, 0, buf, NULL, 2);
+}
+
+mraa_result_t
+mraa_i2c_txn_read(mraa_i2c_txn txn, uint8_t address, uint8_t* data, int length)
+{
+    if (data == NULL) {
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+    return mraa_i2c_txn_add(txn, address, I2C_M_RD, NULL, data, length);
+}
+
+mraa_result_t
+mraa_i2c_txn_read_bytes_data(mraa_i2c_txn txn, uint8_t address, uint8_t command, uint8_t* data, int length)
+{
+    if (data == NULL) {
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    mraa_result_t ret = mraa_i2c_txn_add(txn, address, 0, &command, NULL, 1);
+    if (ret != MRAA_SUCCESS) {
+        return ret;
+    }
+    ret = mraa_i2c_txn_add(txn, address, I2C_M_RD, NULL, data, length);
+    if (ret != MRAA_SUCCESS) {
+        // don't leave a dangling register write behind
+        txn->num_msgs--;
+        txn->pool_len--;
+    }
+    return ret;
+}
+
+/* Run the messages one by one through the platform's read/write functions. */
+static mraa_result_t
+mraa_i2c_txn_submit_fallback(mraa_i2c_txn txn)
+{
+    mraa_i2c_context dev = txn->dev;
+    mraa_result_t ret = MRAA_SUCCESS;
+    int orig_addr;
+
+    if (txn->num_msgs == 0) {
+        return MRAA_SUCCESS;
+    }
+    ret = mraa_i2c_select(dev, (uint8_t) txn->msgs[0].addr, &orig_addr);
+    if (ret != MRAA_SUCCESS) {
+        return ret;
+    }
+
+    for (unsigned int i = 0; i < txn->num_msgs && ret == MRAA_SUCCESS; i++) {
+        struct _i2c_txn_msg* msg = &txn->msgs[i];
+
+        if (dev->addr != msg->addr) {
+            ret = mraa_i2c_address(dev, (uint8_t) msg->addr);
+            if (ret != MRAA_SUCCESS) {
+                break;
+            }
+        }
+
+        if (msg->flags & I2C_M_RD) {
+            if (mraa_i2c_read(dev, msg->rbuf, msg->len) != msg->len) {
+                ret = MRAA_ERROR_UNSPECIFIED;
+            }
+        } else {
+            ret = mraa_i2c_write(dev, txn->pool + msg->offset, msg->len);
+        }
+    }
+
+    if (ret != MRAA_SUCCESS) {
+        syslog(LOG_ERR, "i2c%i: txn_submit: transfer failed", dev->busnum);
+    }
+    mraa_i2c_deselect(dev, orig_addr);
+
+    return ret;
+}
+
+mraa_result_t
+mraa_i2c_txn_submit(mraa_i2c_txn txn)
+{
+    struct i2c_msg m[I2C_RDRW_IOCTL_MAX_MSGS];
+
+    if (txn == NULL) {
+        syslog(LOG_ERR, "i2c: txn_submit: transaction is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    mraa_i2c_context dev = txn->dev;
+    if (IS_FUNC_DEFINED(dev, i2c_init_bus_replace) || IS_FUNC_DEFINED(dev, i2c_read_replace) ||
+        IS_FUNC_DEFINED(dev, i2c_write_replace)) {
+        return mraa_i2c_txn_submit_fallback(txn);
+    }
+
+    if (mraa_i2c_rdwr_unavailable(dev)) {
+        syslog(LOG_ERR, "i2c%i: txn_submit: adapter only supports SMBus transfers", dev->busnum);
+        return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    // split transactions go out back to back
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    for (unsigned int i = 0; i < txn->num_msgs; i += I2C_RDRW_IOCTL_MAX_MSGS) {
+        unsigned int n = txn->num_msgs - i;
+        if (n > I2C_RDRW_IOCTL_MAX_MSGS) {
+            n = I2C_RDRW_IOCTL_MAX_MSGS;
+        }
+
+        for (unsigned int j = 0; j < n; j++) {
+            struct _i2c_txn_msg* msg = &txn->msgs[i + j];
+            m[j].addr = msg->addr;
+            m[j].flags = msg->flags;
+            m[j].len = msg->len;
+            m[j].buf = (char*) ((msg->flags & I2C_M_RD) ? msg->rbuf : txn->pool + msg->offset);
+        }
+
+        mraa_result_t ret = mraa_i2c_rdwr(dev, m, n, "txn_submit");
+        if (ret != MRAA_SUCCESS) {
+            mraa_bus_arbiter_release(dev->arbiter);
+            return ret;
+        }
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return MRAA_SUCCESS;
+}
+
+static mraa_result_t
+mraa_i2c_txn_run_async(struct _bus_async* req)
+{
+    return mraa_i2c_txn_submit((mraa_i2c_txn) req->dev);
+}
+
+static mraa_result_t
+mraa_i2c_txn_queue_async(mraa_i2c_txn txn,
+                         mraa_bus_async_cb_t cb,
+                         void* args,
+                         mraa_bus_async_t* handle,
+                         mraa_boolean_t python)
+{
+    if (txn == NULL) {
+        syslog(LOG_ERR, "i2c: txn_submit_async: transaction is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    struct _bus_async* req = (struct _bus_async*) calloc(1, sizeof(struct _bus_async));
+    if (req == NULL) {
+        syslog(LOG_CRIT, "i2c%i: txn_submit_async: Failed to allocate memory for request", txn->dev->busnum);
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+    req->run = &mraa_i2c_txn_run_async;
+    req->owner = txn->dev;
+    req->dev = txn;
+    req->cb = cb;
+    req->args = args;
+    req->python = python;
+
+    return mraa_bus_arbiter_submit(txn->dev->arbiter, req, handle);
+}
+
+mraa_result_t
+mraa_i2c_txn_submit_async(mraa_i2c_txn txn, mraa_bus_async_cb_t cb, void* args, mraa_bus_async_t* handle)
+{
+    return mraa_i2c_txn_queue_async(txn, cb, args, handle, 0);
+}
+
+mraa_result_t
+mraa_i2c_txn_submit_async_python(mraa_i2c_txn txn, void* cb, void* args)
+{
+    return mraa_i2c_txn_queue_async(txn, (mraa_bus_async_cb_t) cb, args, NULL, 1);
+}
+
+mraa_result_t
+mraa_i2c_txn_reset(mraa_i2c_txn txn)
+{
+    if (txn == NULL) {
+        syslog(LOG_ERR, "i2c: txn_reset: transaction is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    txn->num_msgs = 0;
+    txn->pool_len = 0;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_txn_close(mraa_i2c_txn txn)
+{
+    if (txn == NULL) {
+        syslog(LOG_ERR, "i2c: txn_close: transaction is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    free(txn->msgs);
+    free(txn->pool);
+    free(txn);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_regcache_init(mraa_i2c_context dev, unsigned int num_regs, const uint8_t* volatile_regs, int num_volatile)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_init: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (num_regs == 0 || num_regs > 256 || num_volatile < 0 || (num_volatile > 0 && volatile_regs == NULL)) {
+        syslog(LOG_ERR, "i2c%i: regcache_init: invalid register map of %u registers", dev->busnum, num_regs);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    struct _i2c_regcache* cache = (struct _i2c_regcache*) calloc(1, sizeof(struct _i2c_regcache));
+    if (cache != NULL) {
+        cache->values = (uint8_t*) calloc(num_regs, sizeof(uint8_t));
+        cache->flags = (uint8_t*) calloc(num_regs, sizeof(uint8_t));
+    }
+    if (cache == NULL || cache->values == NULL || cache->flags == NULL) {
+        syslog(LOG_CRIT, "i2c%i: regcache_init: Failed to allocate memory for register cache", dev->busnum);
+        if (cache != NULL) {
+            free(cache->values);
+            free(cache->flags);
+            free(cache);
+        }
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+    cache->num_regs = num_regs;
+
+    for (int i = 0; i < num_volatile; i++) {
+        if (volatile_regs[i] < num_regs) {
+            cache->flags[volatile_regs[i]] = MRAA_I2C_REG_VOLATILE;
+        }
+    }
+
+    mraa_i2c_regcache_close(dev);
+    dev->regcache = cache;
+    return MRAA_SUCCESS;
+}
+
+int
+mraa_i2c_regcache_read(mraa_i2c_context dev, uint8_t reg)
+{
+    if (dev == NULL || dev->regcache == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_read: context has no register cache");
+        return -1;
+    }
+
+    struct _i2c_regcache* cache = dev->regcache;
+    if (reg >= cache->num_regs) {
+        return mraa_i2c_read_byte_data(dev, reg);
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = cache->values[reg];
+    if (!(cache->flags[reg] & MRAA_I2C_REG_VALID)) {
+        ret = mraa_i2c_read_byte_data(dev, reg);
+        if (ret >= 0 && !(cache->flags[reg] & MRAA_I2C_REG_VOLATILE)) {
+            cache->values[reg] = (uint8_t) ret;
+            cache->flags[reg] |= MRAA_I2C_REG_VALID;
+        }
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return ret;
+}
+
+mraa_result_t
+mraa_i2c_regcache_write(mraa_i2c_context dev, uint8_t reg, uint8_t value)
+{
+    if (dev == NULL || dev->regcache == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_write: context has no register cache");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    struct _i2c_regcache* cache = dev->regcache;
+    if (reg >= cache->num_regs || (cache->flags[reg] & MRAA_I2C_REG_VOLATILE)) {
+        return mraa_i2c_write_byte_data(dev, value, reg);
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (!(cache->flags[reg] & MRAA_I2C_REG_VALID) || cache->values[reg] != value) {
+        if (!(cache->flags[reg] & MRAA_I2C_REG_DIRTY)) {
+            cache->num_dirty++;
+        }
+        cache->values[reg] = value;
+        cache->flags[reg] |= MRAA_I2C_REG_VALID | MRAA_I2C_REG_DIRTY;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_regcache_update_bits(mraa_i2c_context dev, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    if (dev == NULL || dev->regcache == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_update_bits: context has no register cache");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    // hold the bus so the read-modify-write can't interleave
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    mraa_result_t ret = MRAA_ERROR_UNSPECIFIED;
+    int old = mraa_i2c_regcache_read(dev, reg);
+    if (old >= 0) {
+        ret = mraa_i2c_regcache_write(dev, reg, (uint8_t) ((old & ~mask) | (value & mask)));
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return ret;
+}
+
+mraa_result_t
+mraa_i2c_regcache_sync(mraa_i2c_context dev)
+{
+    /* register byte + the most mraa_i2c_write() sends in one go */
+    uint8_t buf[I2C_SMBUS_I2C_BLOCK_MAX + 1];
+
+    if (dev == NULL || dev->regcache == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_sync: context has no register cache");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    struct _i2c_regcache* cache = dev->regcache;
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    unsigned int reg = 0;
+    while (cache->num_dirty > 0 && reg < cache->num_regs) {
+        if (!(cache->flags[reg] & MRAA_I2C_REG_DIRTY)) {
+            reg++;
+            continue;
+        }
+
+        // one burst per run of contiguous dirty registers, relying on auto-increment
+        unsigned int start = reg;
+        int len = 1;
+        buf[0] = (uint8_t) start;
+        while (reg < cache->num_regs && (cache->flags[reg] & MRAA_I2C_REG_DIRTY) && len <= I2C_SMBUS_I2C_BLOCK_MAX) {
+            buf[len++] = cache->values[reg++];
+        }
+
+        ret = mraa_i2c_write(dev, buf, len);
+        if (ret != MRAA_SUCCESS) {
+            syslog(LOG_ERR, "i2c%i: regcache_sync: failed to write registers 0x%X-0x%X", dev->busnum,
+                   start, reg - 1);
+            break;
+        }
+        for (unsigned int i = start; i < reg; i++) {
+            cache->flags[i] &= ~MRAA_I2C_REG_DIRTY;
+        }
+        cache->num_dirty -= reg - start;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return ret;
+}
+
+mraa_result_t
+mraa_i2c_regcache_invalidate(mraa_i2c_context dev)
+{
+    if (dev == NULL || dev->regcache == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_invalidate: context has no register cache");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    struct _i2c_regcache* cache = dev->regcache;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    for (unsigned int i = 0; i < cache->num_regs; i++) {
+        cache->flags[i] &= MRAA_I2C_REG_VOLATILE;
+    }
+    cache->num_dirty = 0;
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_regcache_close(mraa_i2c_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "i2c: regcache_close: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (dev->regcache != NULL) {
+        if (dev->regcache->num_dirty > 0) {
+            syslog(LOG_WARNING, "i2c%i: regcache_close: dropping %u unsynced registers", dev->busnum,
+                   dev->regcache->num_dirty);
+        }
+        free(dev->regcache->values);
+        free(dev->regcache->flags);
+        free(dev->regcache);
+        dev->regcache = NULL;
+    }
+    return MRAA_SUCCESS;
+}
+
+/* Probe one address the way i2cdetect does in its default mode. */
+static mraa_i2c_scan_state_t
+mraa_i2c_probe(mraa_i2c_context dev, uint8_t addr)
+{
+    mraa_i2c_scan_state_t state = MRAA_I2C_SCAN_ABSENT;
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (IS_FUNC_DEFINED(dev, i2c_init_bus_replace) || IS_FUNC_DEFINED(dev, i2c_read_byte_replace)) {
+        // no i2c-dev node behind the context, go through the platform's functions
+        if (mraa_i2c_address(dev, addr) == MRAA_SUCCESS && mraa_i2c_read_byte(dev) >= 0) {
+            state = MRAA_I2C_SCAN_PRESENT;
+        }
+    } else if (mraa_i2c_ioctl(dev, I2C_SLAVE, (void*) (unsigned long) addr) < 0) {
+        if (errno == EBUSY) {
+            state = MRAA_I2C_SCAN_BUSY;
+        }
+    } else {
+        dev->kernel_addr = addr;
+        dev->kernel_addr_set = 1;
+        i2c_smbus_data_t d;
+        // a quick write can corrupt eeproms and a read byte can lock some write-only chips
+        mraa_boolean_t read_byte = (addr >= 0x30 && addr <= 0x37) || (addr >= 0x50 && addr <= 0x5F);
+        if (!(dev->funcs & I2C_FUNC_SMBUS_QUICK)) {
+            read_byte = 1;
+        }
+        int ret = read_byte ? mraa_i2c_smbus_access(dev, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &d) :
+                              mraa_i2c_smbus_access(dev, I2C_SMBUS_WRITE, 0, I2C_SMBUS_QUICK, NULL);
+        if (ret >= 0) {
+            state = MRAA_I2C_SCAN_PRESENT;
+        }
+        dev->addr = addr;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return state;
+}
+
+/* A bus being scanned by its own thread. */
+struct _i2c_scan_job {
+    int bus;
+    mraa_i2c_scan_result_t result;
+    uint64_t last_progress;
+    mraa_boolean_t done;
+    mraa_boolean_t abandoned;
+    struct _i2c_scan* scan;
+    pthread_t thread;
+};
+
+/* Shared by the scanning threads and the caller, freed by whoever is last. */
+struct _i2c_scan {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int refs;
+    int num_jobs;
+    struct _i2c_scan_job jobs[];
+};
+
+static uint64_t
+mraa_i2c_scan_now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+mraa_i2c_scan_unref(struct _i2c_scan* scan)
+{
+    pthread_mutex_lock(&scan->lock);
+    int refs = --scan->refs;
+    pthread_mutex_unlock(&scan->lock);
+
+    if (refs == 0) {
+        pthread_mutex_destroy(&scan->lock);
+        pthread_cond_destroy(&scan->cond);
+        free(scan);
+    }
+}
+
+static void*
+mraa_i2c_scan_thread(void* arg)
+{
+    struct _i2c_scan_job* job = (struct _i2c_scan_job*) arg;
+    struct _i2c_scan* scan = job->scan;
+
+    mraa_i2c_context dev = mraa_i2c_init(job->bus);
+
+    pthread_mutex_lock(&scan->lock);
+    if (dev == NULL) {
+        job->result.status = MRAA_ERROR_INVALID_RESOURCE;
+    }
+    job->last_progress = mraa_i2c_scan_now_ms();
+    pthread_cond_broadcast(&scan->cond);
+    pthread_mutex_unlock(&scan->lock);
+
+    for (int addr = MRAA_I2C_SCAN_FIRST; dev != NULL && addr <= MRAA_I2C_SCAN_LAST; addr++) {
+        mraa_i2c_scan_state_t state = mraa_i2c_probe(dev, (uint8_t) addr);
+
+        pthread_mutex_lock(&scan->lock);
+        mraa_boolean_t abandoned = job->abandoned;
+        if (!abandoned) {
+            job->result.state[addr] = state;
+            if (state == MRAA_I2C_SCAN_PRESENT) {
+                job->result.num_found++;
+            }
+            job->last_progress = mraa_i2c_scan_now_ms();
+        }
+        pthread_mutex_unlock(&scan->lock);
+        if (abandoned) {
+            break;
+        }
+    }
+
+    if (dev != NULL) {
+        mraa_i2c_stop(dev);
+    }
+
+    pthread_mutex_lock(&scan->lock);
+    job->done = 1;
+    pthread_cond_broadcast(&scan->cond);
+    pthread_mutex_unlock(&scan->lock);
+
+    mraa_i2c_scan_unref(scan);
+    return NULL;
+}
+
+/* Scan the buses in parallel and fill one result per bus. */
+static mraa_result_t
+mraa_i2c_scan_buses(const int* buses, int num_buses, unsigned int timeout_ms, mraa_i2c_scan_result_t* results)
+{
+    struct _i2c_scan* scan = calloc(1, sizeof(struct _i2c_scan) + num_buses * sizeof(struct _i2c_scan_job));
+    if (scan == NULL) {
+        syslog(LOG_CRIT, "i2c: scan: Failed to allocate memory for scan");
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&scan->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&scan->lock, NULL);
+    scan->num_jobs = num_buses;
+    scan->refs = 1;
+
+    uint64_t now = mraa_i2c_scan_now_ms();
+    pthread_mutex_lock(&scan->lock);
+    for (int i = 0; i < num_buses; i++) {
+        struct _i2c_scan_job* job = &scan->jobs[i];
+        job->bus = buses[i];
+        job->scan = scan;
+        job->result.bus = buses[i];
+        job->result.status = MRAA_SUCCESS;
+        for (int addr = 0; addr < 128; addr++) {
+            job->result.state[addr] = MRAA_I2C_SCAN_SKIPPED;
+        }
+        job->last_progress = now;
+
+        scan->refs++;
+        if (pthread_create(&job->thread, NULL, mraa_i2c_scan_thread, job) != 0) {
+            syslog(LOG_ERR, "i2c%i: scan: Failed to create scan thread", buses[i]);
+            scan->refs--;
+            job->result.status = MRAA_ERROR_NO_RESOURCES;
+            job->done = 1;
+        } else {
+            pthread_detach(job->thread);
+        }
+    }
+
+    /*
+     * A bus which doesn't complete a probe within timeout_ms is given up on.
+     * Its thread can't be interrupted and keeps the arbiter until the probe
+     * returns; I2C_TIMEOUT isn't an option, it changes the adapter for good.
+     */
+    for (;;) {
+        uint64_t deadline = UINT64_MAX;
+        mraa_boolean_t pending = 0;
+
+        now = mraa_i2c_scan_now_ms();
+        for (int i = 0; i < num_buses; i++) {
+            struct _i2c_scan_job* job = &scan->jobs[i];
+            if (job->done || job->abandoned) {
+                continue;
+            }
+            if (timeout_ms > 0 && now - job->last_progress >= timeout_ms) {
+                syslog(LOG_WARNING, "i2c%i: scan: probe timed out, giving up on the bus", job->bus);
+                job->abandoned = 1;
+                job->result.status = MRAA_ERROR_UNSPECIFIED;
+                continue;
+            }
+            pending = 1;
+            if (timeout_ms > 0 && job->last_progress + timeout_ms < deadline) {
+                deadline = job->last_progress + timeout_ms;
+            }
+        }
+        if (!pending) {
+            break;
+        }
+
+        if (deadline == UINT64_MAX) {
+            pthread_cond_wait(&scan->cond, &scan->lock);
+        } else {
+            struct timespec ts;
+            ts.tv_sec = deadline / 1000;
+            ts.tv_nsec = (deadline % 1000) * 1000000;
+            pthread_cond_timedwait(&scan->cond, &scan->lock, &ts);
+        }
+    }
+
+    for (int i = 0; i < num_buses; i++) {
+        memcpy(&results[i], &scan->jobs[i].result, sizeof(mraa_i2c_scan_result_t));
+    }
+    pthread_mutex_unlock(&scan->lock);
+
+    mraa_i2c_scan_unref(scan);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_i2c_scan(int bus, unsigned int timeout_ms, mraa_i2c_scan_result_t* result)
+{
+    if (result == NULL) {
+        syslog(LOG_ERR, "i2c%i: scan: result is invalid", bus);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    mraa_result_t ret = mraa_i2c_scan_buses(&bus, 1, timeout_ms, result);
+    if (ret != MRAA_SUCCESS) {
+        return ret;
+    }
+    return result->status;
+}
+
+int
+mraa_i2c_scan_all(unsigned int timeout_ms, mraa_i2c_scan_result_t* results, int max_results)
+{
+    int buses[2 * MAX_I2C_BUS_COUNT];
+    int num_buses = 0;
+
+    if (results == NULL || max_results <= 0) {
+        syslog(LOG_ERR, "i2c: scan_all: results are invalid");
+        return -1;
+    }
+
+    mraa_init();
+    if (plat == NULL) {
+        syslog(LOG_ERR, "i2c: scan_all: Platform Not Initialised");
+        return -1;
+    }
+
+    for (int i = 0; i < plat->i2c_bus_count; i++) {
+        int id = plat->i2c_bus[i].bus_id;
+        int j;
+        // several entries can point at the same adapter, scan it once
+        for (j = 0; j < i && plat->i2c_bus[j].bus_id != id; j++)
+            ;
+        if (id != -1 && j == i) {
+            buses[num_buses++] = i;
+        }
+    }
+    if (plat->sub_platform != NULL) {
+        for (int i = 0; i < plat->sub_platform->i2c_bus_count; i++) {
+            if (plat->sub_platform->i2c_bus[i].bus_id != -1) {
+                buses[num_buses++] = mraa_get_sub_platform_id(i);
+            }
+        }
+    }
+    if (num_buses > max_results) {
+        num_buses = max_results;
+    }
+    if (num_buses == 0) {
+        return 0;
+    }
+
+    if (mraa_i2c_scan_buses(buses, num_buses, timeout_ms, results) != MRAA_SUCCESS) {
+        return -1;
+    }
+    return num_buses;
+}
@@ -27,6 +27,11 @@
 mraa_iio_context
 mraa_iio_init(int device)
 {
+    // the IIO scan is deferred until a device is actually needed
+    if (mraa_iio_detect() != MRAA_SUCCESS && plat_iio == NULL) {
+        return NULL;
+    }
+
     if (plat_iio->iio_device_count == 0 || device >= plat_iio->iio_device_count) {
         return NULL;
     }
@@ -188,6 +193,7 @@ mraa_iio_get_device_num_by_name(const char* name)
 {
     int i;
 
+    mraa_iio_detect();
     if (plat_iio == NULL) {
         syslog(LOG_ERR, "iio: platform IIO structure is not initialized");
         return -1;
@@ -12,6 +12,21 @@
   $2 = JCALL1(GetArrayLength, jenv, $input);
 }
 
+// Spi::transferInto() works on direct ByteBuffers, without copies
+%typemap(jtype) (const uint8_t* txData, int txLength), (uint8_t* rxData, int rxLength) "java.nio.ByteBuffer"
+%typemap(jstype) (const uint8_t* txData, int txLength), (uint8_t* rxData, int rxLength) "java.nio.ByteBuffer"
+%typemap(jni) (const uint8_t* txData, int txLength), (uint8_t* rxData, int rxLength) "jobject"
+%typemap(javain) (const uint8_t* txData, int txLength), (uint8_t* rxData, int rxLength) "$javainput"
+
+%typemap(in,numinputs=1) (const uint8_t* txData, int txLength), (uint8_t* rxData, int rxLength) {
+  $1 = (uint8_t *) JCALL1(GetDirectBufferAddress, jenv, $input);
+  if ($1 == NULL) {
+    SWIG_JavaThrowException(jenv, SWIG_JavaIllegalArgumentException, "direct ByteBuffer expected");
+    return $null;
+  }
+  $2 = (int) JCALL1(GetDirectBufferCapacity, jenv, $input);
+}
+
 %typemap(jtype) (uint8_t *data, int length) "byte[]"
 %typemap(jstype) (uint8_t *data, int length) "byte[]"
 %typemap(jni) (uint8_t *data, int length) "jbyteArray"
@@ -34,6 +34,15 @@
   $2 = node::Buffer::Length($input);
 }
 
+// Spi::transferInto() works on the Buffers' memory
+%typemap(in) (const uint8_t* txData, int txLength), (uint8_t* rxData, int rxLength) {
+  if (!node::Buffer::HasInstance($input)) {
+      SWIG_exception_fail(SWIG_ERROR, "Expected a node Buffer");
+  }
+  $1 = (uint8_t*) node::Buffer::Data($input);
+  $2 = node::Buffer::Length($input);
+}
+
 %typemap(in) (v8::Handle<v8::Function> func) {
   $1 = v8::Local<v8::Function>::Cast($input);
 }
@@ -5,7 +5,9 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <errno.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +37,40 @@ mraa_init_json_platform_get_pin(json_object* jobj, const char* io, const char* k
     return MRAA_ERROR_NO_DATA_AVAILABLE;
 }
 
+mraa_result_t
+mraa_init_json_platform_get_offset(json_object* jobj, const char* io, const char* key, int index, uint64_t* offset)
+{
+    json_object* jobj_temp = NULL;
+    if (!json_object_object_get_ex(jobj, key, &jobj_temp)) {
+        syslog(LOG_ERR, "init_json_platform: No %s specified for %s at position: %d", key, io, index);
+        return MRAA_ERROR_NO_DATA_AVAILABLE;
+    }
+    // Physical addresses easily exceed INT_MAX, so accept an int64 or a "0x..." string
+    if (json_object_is_type(jobj_temp, json_type_int)) {
+        int64_t value = json_object_get_int64(jobj_temp);
+        if (value < 0) {
+            syslog(LOG_ERR, "init_json_platform: %s %s at position: %d is negative", io, key, index);
+            return MRAA_ERROR_INVALID_RESOURCE;
+        }
+        *offset = (uint64_t) value;
+        return MRAA_SUCCESS;
+    }
+    if (json_object_is_type(jobj_temp, json_type_string)) {
+        const char* str = json_object_get_string(jobj_temp);
+        char* end = NULL;
+        errno = 0;
+        unsigned long long value = strtoull(str, &end, 0);
+        if (errno != 0 || end == str || *end != '\0' || strchr(str, '-') != NULL) {
+            syslog(LOG_ERR, "init_json_platform: %s %s at position: %d is not a number", io, key, index);
+            return MRAA_ERROR_INVALID_RESOURCE;
+        }
+        *offset = (uint64_t) value;
+        return MRAA_SUCCESS;
+    }
+    syslog(LOG_ERR, "init_json_platform: %s %s at position: %d is not an int or a string", io, key, index);
+    return MRAA_ERROR_INVALID_RESOURCE;
+}
+
 mraa_result_t
 mraa_init_json_platform_get_index(json_object* jobj, const char* io, const char* key, int index, int* pos, int upper)
 {
@@ -528,6 +564,110 @@ mraa_init_json_platform_uart(json_object* jobj_uart, mraa_board_t* board, int in
     return MRAA_SUCCESS;
 }
 
+mraa_result_t
+mraa_init_json_platform_gpio_mmap(json_object* jobj_mmap, mraa_board_t* board, int index)
+{
+    json_object* jobj_temp = NULL;
+    mraa_result_t ret = MRAA_SUCCESS;
+    const char* temp_string = NULL;
+    mraa_gpio_mmap_desc_t* desc;
+
+    desc = (mraa_gpio_mmap_desc_t*) calloc(1, sizeof(mraa_gpio_mmap_desc_t));
+    if (desc == NULL) {
+        syslog(LOG_ERR, "init_json_platform: Unable to allocate space for the gpio mmap description");
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    // Setup the memory device path
+    if (json_object_object_get_ex(jobj_mmap, MEM_DEV_KEY, &jobj_temp)) {
+        if (!json_object_is_type(jobj_temp, json_type_string)) {
+            syslog(LOG_ERR, "init_json_platform: gpio mmap path was not a string");
+            free(desc);
+            return MRAA_ERROR_NO_RESOURCES;
+        }
+        temp_string = json_object_get_string(jobj_temp);
+        if (temp_string == NULL || strlen(temp_string) == 0 || strlen(temp_string) >= sizeof(desc->mem_dev)) {
+            syslog(LOG_ERR, "init_json_platform: gpio mmap path was empty or too long");
+            free(desc);
+            return MRAA_ERROR_NO_DATA_AVAILABLE;
+        }
+        strncpy(desc->mem_dev, temp_string, sizeof(desc->mem_dev) - 1);
+    } else {
+        syslog(LOG_ERR, "init_json_platform: gpio mmap config needs a path");
+        free(desc);
+        return MRAA_ERROR_NO_DATA_AVAILABLE;
+    }
+
+    uint64_t base = 0, size = 0;
+    ret = mraa_init_json_platform_get_offset(jobj_mmap, GPIO_MMAP_KEY, MEM_BASE_KEY, index, &base);
+    if (ret == MRAA_SUCCESS) {
+        ret = mraa_init_json_platform_get_offset(jobj_mmap, GPIO_MMAP_KEY, MEM_SIZE_KEY, index, &size);
+    }
+    if (ret != MRAA_SUCCESS) {
+        free(desc);
+        return ret;
+    }
+    if (size == 0 || size > SIZE_MAX) {
+        syslog(LOG_ERR, "init_json_platform: gpio mmap %s is out of range", MEM_SIZE_KEY);
+        free(desc);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    desc->base = base;
+    desc->size = (size_t) size;
+
+    // Every register layout key is required
+    const char* keys[] = { GPIO_BASE_KEY, SET_REG_KEY, CLEAR_REG_KEY, DATA_REG_KEY, BANK_STRIDE_KEY, BANK_WIDTH_KEY };
+    int values[sizeof(keys) / sizeof(keys[0])];
+    for (int i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        ret = mraa_init_json_platform_get_pin(jobj_mmap, GPIO_MMAP_KEY, keys[i], index, &values[i]);
+        if (ret != MRAA_SUCCESS) {
+            free(desc);
+            return ret;
+        }
+        if (i > 0 && values[i] < 0) {
+            syslog(LOG_ERR, "init_json_platform: gpio mmap %s can't be negative", keys[i]);
+            free(desc);
+            return MRAA_ERROR_INVALID_RESOURCE;
+        }
+    }
+    desc->gpio_base = values[0];
+    desc->set_reg = values[1];
+    desc->clear_reg = values[2];
+    desc->data_reg = values[3];
+    desc->bank_stride = values[4];
+    desc->bank_width = values[5];
+
+    if (desc->bank_width == 0 || desc->bank_width > 32) {
+        syslog(LOG_ERR, "init_json_platform: gpio mmap %s must be between 1 and 32", BANK_WIDTH_KEY);
+        free(desc);
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+
+    // The registers of the last bank used by a gpio pin of the board have to be inside the mapping
+    int last_line = 0;
+    for (int i = 0; i < board->phy_pin_count; i++) {
+        if (board->pins[i].capabilities.gpio) {
+            int line = board->pins[i].gpio.pinmap - desc->gpio_base;
+            if (line > last_line) {
+                last_line = line;
+            }
+        }
+    }
+    uint64_t last_bank = (uint64_t) (last_line / desc->bank_width) * desc->bank_stride;
+    unsigned int regs[] = { desc->set_reg, desc->clear_reg, desc->data_reg };
+    for (int i = 0; i < sizeof(regs) / sizeof(regs[0]); i++) {
+        if (last_bank + regs[i] + 4 > desc->size) {
+            syslog(LOG_ERR, "init_json_platform: gpio mmap %s registers of gpio %d exceed %s",
+                   keys[i + 1], last_line + desc->gpio_base, MEM_SIZE_KEY);
+            free(desc);
+            return MRAA_ERROR_INVALID_RESOURCE;
+        }
+    }
+
+    board->gpio_mmap = desc;
+    return MRAA_SUCCESS;
+}
+
 mraa_result_t
 mraa_init_json_platform_loop(json_object* jobj_platform, const char* obj_key, mraa_board_t* board, init_plat_func_t func)
 {
@@ -691,6 +831,13 @@ mraa_init_json_platform(const char* platform_json)
         goto unsuccessful;
     }
 
+    // Setup the optional memory mapped GPIO controller
+    ret = mraa_init_json_platform_size_check(jobj_platform, GPIO_MMAP_KEY, board,
+                                             mraa_init_json_platform_gpio_mmap, 1);
+    if (ret != MRAA_SUCCESS && ret != MRAA_ERROR_NO_DATA_AVAILABLE) {
+        goto unsuccessful;
+    }
+
     // Free the old empty platform
     free(plat);
     // Set the new one in it's place
@@ -718,6 +865,7 @@ mraa_init_json_platform(const char* platform_json)
     goto cleanup;
 
 unsuccessful:
+    free(board->gpio_mmap);
     free(board->platform_name);
     free(board->pins);
     free(board->adv_func);
@@ -129,6 +129,8 @@ mraa_led_init_internal(const char* led)
 mraa_led_context
 mraa_led_init(int index)
 {
+    mraa_init();
+
     if (plat == NULL) {
         syslog(LOG_ERR, "led: init: platform not initialised");
         return NULL;
@@ -155,6 +157,8 @@ mraa_led_init(int index)
 mraa_led_context
 mraa_led_init_raw(const char* led)
 {
+    mraa_init();
+
     if (plat == NULL) {
         syslog(LOG_ERR, "led: init: platform not initialised");
         return NULL;
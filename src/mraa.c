@@ -13,6 +13,7 @@
 
 #include <dlfcn.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <pwd.h>
 #include <sched.h>
 #include <stddef.h>
@@ -39,6 +40,7 @@
 #endif
 
 #include "aio.h"
+#include "bus/bus_arbiter.h"
 #include "firmata/firmata_mraa.h"
 #include "gpio.h"
 #include "gpio/gpio_chardev.h"
@@ -64,6 +66,11 @@ static int num_iio_devices = 0;
 mraa_board_t* plat = NULL;
 mraa_lang_func_t* lang_func = NULL;
 
+// Set once imraa_init() has returned, plat is assigned before the board is complete
+static int mraa_ready = 0;
+// Board builders call *_init_raw functions, which call mraa_init(), during detection
+static __thread int mraa_initialising = 0;
+
 char* platform_name = NULL;
 
 const char*
@@ -210,9 +217,7 @@ imraa_init()
 #endif
 
 #if !defined(PERIPHERALMAN)
-    // Look for IIO devices
-    mraa_iio_detect();
-
+    // IIO devices are only looked for on first use, see mraa_iio_detect()
     if (plat != NULL) {
         int length = strlen(plat->platform_name) + 1;
         if (mraa_has_sub_platform()) {
@@ -238,28 +243,62 @@ imraa_init()
         syslog(LOG_NOTICE, "gpio: support for chardev interface is activated");
     }
 
+    // Name lookups go through these from now on, the boards don't change after init
+    mraa_build_lookup_index(plat);
+    if (mraa_has_sub_platform()) {
+        mraa_build_lookup_index(plat->sub_platform);
+    }
+
     syslog(LOG_NOTICE, "libmraa initialised for platform '%s' of type %d", mraa_get_platform_name(),
            mraa_get_platform_type());
     return MRAA_SUCCESS;
 }
 
-#if (defined SWIGPYTHON) || (defined SWIG)
 mraa_result_t
-#else
-mraa_result_t __attribute__((constructor))
-#endif
 mraa_init()
 {
-    if (plat != NULL) {
+    static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    if (__atomic_load_n(&mraa_ready, __ATOMIC_ACQUIRE) || mraa_initialising) {
         return MRAA_SUCCESS;
-    } else {
-        return imraa_init();
     }
+
+    // Called lazily by the *_init functions, which may race each other
+    pthread_mutex_lock(&init_lock);
+    if (!__atomic_load_n(&mraa_ready, __ATOMIC_RELAXED)) {
+        mraa_initialising = 1;
+        ret = imraa_init();
+        mraa_initialising = 0;
+        __atomic_store_n(&mraa_ready, plat != NULL, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&init_lock);
+
+    return ret;
+}
+
+#if !(defined SWIGPYTHON) && !(defined SWIG)
+static void __attribute__((constructor))
+mraa_auto_init()
+{
+    const char* env_var = getenv(MRAA_NO_AUTO_INIT_ENV_VAR);
+
+    // Leave the platform detection to the first mraa_init() or *_init() call
+    if (env_var != NULL && env_var[0] != '\0' && strcmp(env_var, "0") != 0) {
+        return;
+    }
+    mraa_init();
 }
+#endif
 
 void
 mraa_deinit()
 {
+    /* Stop the shared isr threads, left running if contexts still use them. */
+    mraa_gpio_use_isr_dispatcher(0);
+    mraa_bus_arbiter_shutdown();
+    mraa_gpio_invalidate_chip_cache();
+
     if (plat != NULL) {
         if (plat->pins != NULL) {
             free(plat->pins);
@@ -267,7 +306,12 @@ mraa_deinit()
         if (plat->adv_func != NULL) {
             free(plat->adv_func);
         }
+        if (plat->gpio_mmap != NULL) {
+            free(plat->gpio_mmap);
+        }
+        mraa_free_lookup_index(plat);
         mraa_board_t* sub_plat = plat->sub_platform;
+        mraa_free_lookup_index(sub_plat);
         /* No alloc's in an FTDI_FT4222 platform structure */
         if ((sub_plat != NULL) && (sub_plat->platform_type != MRAA_FTDI_FT4222)) {
             if (sub_plat->pins != NULL) {
@@ -276,6 +320,9 @@ mraa_deinit()
             if (sub_plat->adv_func != NULL) {
                 free(sub_plat->adv_func);
             }
+            if (sub_plat->gpio_mmap != NULL) {
+                free(sub_plat->gpio_mmap);
+            }
             free(sub_plat);
         }
         if (plat->platform_type == MRAA_JSON_PLATFORM) {
@@ -298,6 +345,7 @@ mraa_deinit()
             }
         }
 
+        __atomic_store_n(&mraa_ready, 0, __ATOMIC_RELEASE);
         free(plat);
         plat = NULL;
 
@@ -353,22 +401,39 @@ mraa_count_iio_devices(const char* path, const struct stat* sb, int flag, struct
 mraa_result_t
 mraa_iio_detect()
 {
-    plat_iio = (mraa_iio_info_t*) calloc(1, sizeof(mraa_iio_info_t));
-    plat_iio->iio_device_count = num_iio_devices;
+    static pthread_mutex_t iio_detect_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    if (plat_iio != NULL) {
+        return MRAA_SUCCESS;
+    }
+
+    pthread_mutex_lock(&iio_detect_lock);
+    if (plat_iio != NULL) {
+        pthread_mutex_unlock(&iio_detect_lock);
+        return MRAA_SUCCESS;
+    }
+
+    mraa_iio_info_t* iio = (mraa_iio_info_t*) calloc(1, sizeof(mraa_iio_info_t));
+    if (iio == NULL) {
+        pthread_mutex_unlock(&iio_detect_lock);
+        return MRAA_ERROR_NO_RESOURCES;
+    }
     // Now detect IIO devices, linux only
     // find how many iio devices we have if we haven't already
     if (num_iio_devices == 0) {
         if (nftw("/sys/bus/iio/devices", &mraa_count_iio_devices, 20, FTW_PHYS) == -1) {
+            plat_iio = iio;
+            pthread_mutex_unlock(&iio_detect_lock);
             return MRAA_ERROR_UNSPECIFIED;
         }
     }
     char name[64], filepath[64];
     int fd, len, i;
-    plat_iio->iio_device_count = num_iio_devices;
-    plat_iio->iio_devices = calloc(num_iio_devices, sizeof(struct _iio));
+    iio->iio_device_count = num_iio_devices;
+    iio->iio_devices = calloc(num_iio_devices, sizeof(struct _iio));
     struct _iio* device;
     for (i = 0; i < num_iio_devices; i++) {
-        device = &plat_iio->iio_devices[i];
+        device = &iio->iio_devices[i];
         device->num = i;
         snprintf(filepath, 64, "/sys/bus/iio/devices/iio:device%d/name", i);
         fd = open(filepath, O_RDONLY);
@@ -385,6 +450,8 @@ mraa_iio_detect()
             close(fd);
         }
     }
+    plat_iio = iio;
+    pthread_mutex_unlock(&iio_detect_lock);
     return MRAA_SUCCESS;
 }
 
@@ -620,12 +687,14 @@ mraa_result_print(mraa_result_t result)
 mraa_boolean_t
 mraa_has_sub_platform()
 {
+    mraa_init();
     return (plat != NULL) && (plat->sub_platform != NULL);
 }
 
 mraa_boolean_t
 mraa_pin_mode_test(int pin, mraa_pinmodes_t mode)
 {
+    mraa_init();
     if (plat == NULL)
         return 0;
 
@@ -689,6 +758,7 @@ mraa_pin_mode_test(int pin, mraa_pinmodes_t mode)
 mraa_platform_t
 mraa_get_platform_type()
 {
+    mraa_init();
     if (plat == NULL)
         return MRAA_UNKNOWN_PLATFORM;
     return plat->platform_type;
@@ -705,6 +775,7 @@ mraa_get_platform_combined_type()
 unsigned int
 mraa_adc_raw_bits()
 {
+    mraa_init();
     if (plat == NULL)
         return 0;
 
@@ -734,6 +805,7 @@ mraa_get_platform_adc_raw_bits(uint8_t platform_offset)
 unsigned int
 mraa_adc_supported_bits()
 {
+    mraa_init();
     if (plat == NULL)
         return 0;
 
@@ -762,12 +834,14 @@ mraa_get_platform_adc_supported_bits(int platform_offset)
 const char*
 mraa_get_platform_name()
 {
+    mraa_init();
     return platform_name;
 }
 
 const char*
 mraa_get_platform_version(int platform_offset)
 {
+    mraa_init();
     if (plat == NULL) {
         return NULL;
     }
@@ -781,6 +855,7 @@ mraa_get_platform_version(int platform_offset)
 int
 mraa_get_uart_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -790,6 +865,7 @@ mraa_get_uart_count()
 int
 mraa_get_spi_bus_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -799,6 +875,7 @@ mraa_get_spi_bus_count()
 int
 mraa_get_pwm_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -808,6 +885,7 @@ mraa_get_pwm_count()
 int
 mraa_get_gpio_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -817,6 +895,7 @@ mraa_get_gpio_count()
 int
 mraa_get_aio_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -826,6 +905,7 @@ mraa_get_aio_count()
 int
 mraa_get_i2c_bus_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -835,6 +915,7 @@ mraa_get_i2c_bus_count()
 int
 mraa_get_i2c_bus_id(int i2c_bus)
 {
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
@@ -849,6 +930,7 @@ mraa_get_i2c_bus_id(int i2c_bus)
 unsigned int
 mraa_get_pin_count()
 {
+    mraa_init();
     if (plat == NULL) {
         return 0;
     }
@@ -872,6 +954,7 @@ mraa_get_platform_pin_count(uint8_t platform_offset)
 char*
 mraa_get_pin_name(int pin)
 {
+    mraa_init();
     if (plat == NULL) {
         return 0;
     }
@@ -892,123 +975,264 @@ mraa_get_pin_name(int pin)
     return (char*) current_plat->pins[pin].name;
 }
 
-int
-mraa_gpio_lookup(const char* pin_name)
+/* Name and lookup value of entry i of the given kind, NULL if it can't be looked up. */
+static const char*
+mraa_lookup_entry(mraa_board_t* board, mraa_lookup_type_t type, int i, int* value)
 {
-    int i;
+    switch (type) {
+        case MRAA_LOOKUP_GPIO:
+            // Skip non GPIO pins
+            if (!(board->pins[i].capabilities.gpio)) {
+                return NULL;
+            }
+            *value = i;
+            return board->pins[i].name;
+        case MRAA_LOOKUP_I2C:
+            *value = board->i2c_bus[i].bus_id;
+            return board->i2c_bus[i].name;
+        case MRAA_LOOKUP_SPI:
+            *value = board->spi_bus[i].bus_id;
+            return board->spi_bus[i].name;
+        case MRAA_LOOKUP_PWM:
+            *value = board->pwm_dev[i].index;
+            return board->pwm_dev[i].name;
+        case MRAA_LOOKUP_UART:
+            *value = board->uart_dev[i].index;
+            return board->uart_dev[i].name;
+        default:
+            return NULL;
+    }
+}
 
-    if (plat == NULL) {
-        return -1;
+static int
+mraa_lookup_count(mraa_board_t* board, mraa_lookup_type_t type)
+{
+    switch (type) {
+        case MRAA_LOOKUP_GPIO:
+            return board->pins != NULL ? board->phy_pin_count : 0;
+        case MRAA_LOOKUP_I2C:
+            return board->i2c_bus_count;
+        case MRAA_LOOKUP_SPI:
+            return board->spi_bus_count;
+        case MRAA_LOOKUP_PWM:
+            return board->pwm_dev_count;
+        case MRAA_LOOKUP_UART:
+            return board->uart_dev_count;
+        default:
+            return 0;
     }
+}
 
-    if (pin_name == NULL || strlen(pin_name) == 0) {
-        return -1;
+/* FNV-1a */
+static unsigned int
+mraa_lookup_hash(const char* name)
+{
+    unsigned int hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (unsigned char) *name++) * 16777619u;
     }
+    return hash;
+}
 
-    for (i = 0; i < plat->phy_pin_count; i++) {
-        // Skip non GPIO pins
-        if (!(plat->pins[i].capabilities.gpio))
-            continue;
+static mraa_result_t
+mraa_build_lookup_table(mraa_board_t* board, mraa_lookup_type_t type, mraa_lookup_table_t* table)
+{
+    int count = mraa_lookup_count(board, type);
+    unsigned int slots = 4;
+    int i, value;
+
+    table->names = NULL;
+    table->values = NULL;
+    table->mask = 0;
+    if (count <= 0) {
+        return MRAA_SUCCESS;
+    }
+
+    // keep the load factor under 1/2 so probe sequences stay short
+    while (slots < (unsigned int) count * 2) {
+        slots <<= 1;
+    }
+    table->names = (const char**) calloc(slots, sizeof(char*));
+    table->values = (int*) calloc(slots, sizeof(int));
+    if (table->names == NULL || table->values == NULL) {
+        free(table->names);
+        free(table->values);
+        table->names = NULL;
+        table->values = NULL;
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+    table->mask = slots - 1;
 
-        if (plat->pins[i].name != NULL &&
-            strncmp(pin_name, plat->pins[i].name, strlen(plat->pins[i].name) + 1) == 0) {
-            return i;
+    for (i = 0; i < count; i++) {
+        const char* name = mraa_lookup_entry(board, type, i, &value);
+        if (name == NULL || name[0] == '\0') {
+            continue;
+        }
+        unsigned int slot = mraa_lookup_hash(name) & table->mask;
+        // the first entry with a given name wins, as with the old linear scan
+        while (table->names[slot] != NULL && strcmp(table->names[slot], name) != 0) {
+            slot = (slot + 1) & table->mask;
+        }
+        if (table->names[slot] == NULL) {
+            table->names[slot] = name;
+            table->values[slot] = value;
         }
     }
-    return -1;
+
+    return MRAA_SUCCESS;
 }
 
-int
-mraa_i2c_lookup(const char* i2c_name)
+/* Serialises rebuilds, lookups never take it. */
+static pthread_mutex_t mraa_lookup_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+mraa_free_lookup_tables(mraa_lookup_index_t* index)
 {
-    int i;
+    int type;
 
-    if (plat == NULL) {
-        return -1;
+    for (type = 0; type < MRAA_LOOKUP_TYPES; type++) {
+        free(index->tables[type].names);
+        free(index->tables[type].values);
     }
+    free(index);
+}
 
-    if (i2c_name == NULL || strlen(i2c_name) == 0) {
-        return -1;
+void
+mraa_free_lookup_index(mraa_board_t* board)
+{
+    if (board == NULL) {
+        return;
     }
-
-    for (i = 0; i < plat->i2c_bus_count; i++) {
-        if (plat->i2c_bus[i].name != NULL &&
-            strncmp(i2c_name, plat->i2c_bus[i].name, strlen(plat->i2c_bus[i].name) + 1) == 0) {
-            return plat->i2c_bus[i].bus_id;
-        }
+    mraa_lookup_index_t* index = board->lookup_index;
+    board->lookup_index = NULL;
+    while (index != NULL) {
+        mraa_lookup_index_t* retired = index->retired;
+        mraa_free_lookup_tables(index);
+        index = retired;
     }
-    return -1;
 }
 
-int
-mraa_spi_lookup(const char* spi_name)
+mraa_result_t
+mraa_build_lookup_index(mraa_board_t* board)
 {
-    int i;
+    int type;
 
-    if (plat == NULL) {
-        return -1;
+    if (board == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
     }
 
-    if (spi_name == NULL || strlen(spi_name) == 0) {
-        return -1;
+    mraa_lookup_index_t* index = (mraa_lookup_index_t*) calloc(1, sizeof(mraa_lookup_index_t));
+    if (index == NULL) {
+        return MRAA_ERROR_NO_RESOURCES;
     }
-
-    for (i = 0; i < plat->spi_bus_count; i++) {
-        if (plat->spi_bus[i].name != NULL &&
-            strncmp(spi_name, plat->spi_bus[i].name, strlen(plat->spi_bus[i].name) + 1) == 0) {
-            return plat->spi_bus[i].bus_id;
+    for (type = 0; type < MRAA_LOOKUP_TYPES; type++) {
+        if (mraa_build_lookup_table(board, type, &index->tables[type]) != MRAA_SUCCESS) {
+            mraa_free_lookup_tables(index);
+            syslog(LOG_WARNING, "mraa: no memory for the name lookup index, keeping the previous one");
+            return MRAA_ERROR_NO_RESOURCES;
         }
     }
-    return -1;
+
+    // lookups run unlocked, so publish the complete index in one store and
+    // keep the old one alive until the board goes away
+    pthread_mutex_lock(&mraa_lookup_index_lock);
+    index->retired = board->lookup_index;
+    __atomic_store_n(&board->lookup_index, index, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mraa_lookup_index_lock);
+
+    return MRAA_SUCCESS;
 }
 
-int
-mraa_pwm_lookup(const char* pwm_name)
+static int
+mraa_lookup_board(mraa_board_t* board, mraa_lookup_type_t type, const char* name)
 {
-    int i;
-
-    if (plat == NULL) {
-        return -1;
-    }
+    int i, value;
 
-    if (pwm_name == NULL || strlen(pwm_name) == 0) {
+    const mraa_lookup_index_t* index = __atomic_load_n(&board->lookup_index, __ATOMIC_ACQUIRE);
+    if (index != NULL) {
+        const mraa_lookup_table_t* table = &index->tables[type];
+        if (table->names == NULL) {
+            return -1;
+        }
+        unsigned int slot = mraa_lookup_hash(name) & table->mask;
+        while (table->names[slot] != NULL) {
+            if (strcmp(table->names[slot], name) == 0) {
+                return table->values[slot];
+            }
+            slot = (slot + 1) & table->mask;
+        }
         return -1;
     }
 
-    for (i = 0; i < plat->pwm_dev_count; i++) {
-        if (plat->pwm_dev[i].name != NULL &&
-            strncmp(pwm_name, plat->pwm_dev[i].name, strlen(plat->pwm_dev[i].name) + 1) == 0) {
-            return plat->pwm_dev[i].index;
+    // index not built, scan the board
+    for (i = 0; i < mraa_lookup_count(board, type); i++) {
+        const char* entry = mraa_lookup_entry(board, type, i, &value);
+        if (entry != NULL && strcmp(name, entry) == 0) {
+            return value;
         }
     }
     return -1;
 }
 
-int
-mraa_uart_lookup(const char* uart_name)
+/* Main platform first, sub platform matches are returned as sub platform ids. */
+static int
+mraa_lookup_name(mraa_lookup_type_t type, const char* name)
 {
-    int i;
+    int ret;
 
+    mraa_init();
     if (plat == NULL) {
         return -1;
     }
 
-    if (uart_name == NULL || strlen(uart_name) == 0) {
+    if (name == NULL || name[0] == '\0') {
         return -1;
     }
 
-    for (i = 0; i < plat->uart_dev_count; i++) {
-        if (plat->uart_dev[i].name != NULL &&
-            strncmp(uart_name, plat->uart_dev[i].name, strlen(plat->uart_dev[i].name) + 1) == 0) {
-            return plat->uart_dev[i].index;
+    ret = mraa_lookup_board(plat, type, name);
+    if (ret == -1 && mraa_has_sub_platform()) {
+        ret = mraa_lookup_board(plat->sub_platform, type, name);
+        if (ret != -1) {
+            ret = mraa_get_sub_platform_id(ret);
         }
     }
-    return -1;
+    return ret;
+}
+
+int
+mraa_gpio_lookup(const char* pin_name)
+{
+    return mraa_lookup_name(MRAA_LOOKUP_GPIO, pin_name);
+}
+
+int
+mraa_i2c_lookup(const char* i2c_name)
+{
+    return mraa_lookup_name(MRAA_LOOKUP_I2C, i2c_name);
+}
+
+int
+mraa_spi_lookup(const char* spi_name)
+{
+    return mraa_lookup_name(MRAA_LOOKUP_SPI, spi_name);
+}
+
+int
+mraa_pwm_lookup(const char* pwm_name)
+{
+    return mraa_lookup_name(MRAA_LOOKUP_PWM, pwm_name);
+}
+
+int
+mraa_uart_lookup(const char* uart_name)
+{
+    return mraa_lookup_name(MRAA_LOOKUP_UART, uart_name);
 }
 
 int
 mraa_get_default_i2c_bus(uint8_t platform_offset)
 {
+    mraa_init();
     if (plat == NULL)
         return -1;
     if (platform_offset == MRAA_MAIN_PLATFORM_OFFSET) {
@@ -1326,13 +1550,15 @@ mraa_get_iio_device_count()
 #if defined(PERIPHERALMAN)
     return -1;
 #else
-    return plat_iio->iio_device_count;
+    mraa_iio_detect();
+    return plat_iio != NULL ? plat_iio->iio_device_count : 0;
 #endif
 }
 
 mraa_result_t
 mraa_add_subplatform(mraa_platform_t subplatformtype, const char* dev)
 {
+    mraa_init();
 #if defined(FIRMATA)
     if (subplatformtype == MRAA_GENERIC_FIRMATA) {
         if (plat->sub_platform != NULL) {
@@ -1344,6 +1570,7 @@ mraa_add_subplatform(mraa_platform_t subplatformtype, const char* dev)
             return MRAA_ERROR_FEATURE_NOT_SUPPORTED;
         }
         if (mraa_firmata_platform(plat, dev) == MRAA_GENERIC_FIRMATA) {
+            mraa_build_lookup_index(plat->sub_platform);
             syslog(LOG_NOTICE, "mraa: Added firmata subplatform");
             return MRAA_SUCCESS;
         }
@@ -1372,6 +1599,7 @@ mraa_add_subplatform(mraa_platform_t subplatformtype, const char* dev)
         }
         free(dev_dup);
         if (mraa_grovepi_platform(plat, i2c_bus) == MRAA_GROVEPI) {
+            mraa_build_lookup_index(plat->sub_platform);
             syslog(LOG_NOTICE, "mraa: Added GrovePi subplatform");
             return MRAA_SUCCESS;
         }
@@ -1383,13 +1611,16 @@ mraa_add_subplatform(mraa_platform_t subplatformtype, const char* dev)
 mraa_result_t
 mraa_remove_subplatform(mraa_platform_t subplatformtype)
 {
+    mraa_init();
     if (subplatformtype != MRAA_FTDI_FT4222) {
         if (plat == NULL || plat->sub_platform == NULL) {
             return MRAA_ERROR_INVALID_PARAMETER;
         }
+        mraa_free_lookup_index(plat->sub_platform);
         free(plat->sub_platform->adv_func);
         free(plat->sub_platform->pins);
         free(plat->sub_platform);
+        plat->sub_platform = NULL;
         return MRAA_SUCCESS;
     }
     return MRAA_ERROR_INVALID_PARAMETER;
@@ -1488,6 +1719,81 @@ mraa_atoi(char* intStr, int* value)
     return MRAA_SUCCESS;
 }
 
+/* Two ASCII digits per entry, "00" to "99". */
+static const char sysfs_digit_pairs[201] = "00010203040506070809"
+                                           "10111213141516171819"
+                                           "20212223242526272829"
+                                           "30313233343536373839"
+                                           "40414243444546474849"
+                                           "50515253545556575859"
+                                           "60616263646566676869"
+                                           "70717273747576777879"
+                                           "80818283848586878889"
+                                           "90919293949596979899";
+
+mraa_result_t
+mraa_parse_sysfs_int(const char* buf, ssize_t len, int* value)
+{
+    ssize_t i = 0;
+    mraa_boolean_t negative = 0;
+    long long val = 0;
+
+    if (len > 0 && buf[0] == '-') {
+        negative = 1;
+        i++;
+    }
+    if (i >= len || buf[i] < '0' || buf[i] > '9') {
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    for (; i < len && buf[i] >= '0' && buf[i] <= '9'; i++) {
+        val = val * 10 + (buf[i] - '0');
+        if (val > (long long) INT_MAX + 1) {
+            return MRAA_ERROR_UNSPECIFIED;
+        }
+    }
+    if (i < len && buf[i] != '\n' && buf[i] != '\0') {
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    if (negative) {
+        val = -val;
+    }
+    if (val > INT_MAX) {
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+
+    *value = (int) val;
+    return MRAA_SUCCESS;
+}
+
+int
+mraa_format_sysfs_int(char* buf, int value)
+{
+    char tmp[MRAA_SYSFS_INT_MAX_LEN];
+    char* p = tmp + sizeof(tmp);
+    unsigned int u = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+    int len;
+
+    while (u >= 100) {
+        unsigned int pair = (u % 100) * 2;
+        u /= 100;
+        *--p = sysfs_digit_pairs[pair + 1];
+        *--p = sysfs_digit_pairs[pair];
+    }
+    if (u >= 10) {
+        *--p = sysfs_digit_pairs[u * 2 + 1];
+        *--p = sysfs_digit_pairs[u * 2];
+    } else {
+        *--p = (char) ('0' + u);
+    }
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    len = (int) (tmp + sizeof(tmp) - p);
+    memcpy(buf, p, len);
+    return len;
+}
+
 mraa_result_t
 mraa_init_io_helper(char** str, int* value, const char* delim)
 {
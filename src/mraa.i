@@ -50,6 +50,7 @@
 %ignore Gpio::v8isr(uv_work_t* req, int status);
 %ignore Gpio::uvwork(void *ctx);
 %ignore isr(Edge mode, void (*fptr)(void*), void* args);
+%ignore submitAsync(void (*fptr)(mraa_result_t, void*), void* args);
 
 %include "gpio.hpp"
 
@@ -55,9 +55,9 @@ mraa_pwm_write_period(mraa_pwm_context dev, int period)
         syslog(LOG_ERR, "pwm%i write_period: Failed to open period for writing: %s", dev->pin, strerror(errno));
         return MRAA_ERROR_INVALID_RESOURCE;
     }
-    char out[MAX_SIZE];
-    int length = snprintf(out, MAX_SIZE, "%d", period);
-    if (write(period_f, out, length * sizeof(char)) == -1) {
+    char out[MRAA_SYSFS_INT_MAX_LEN];
+    int length = mraa_format_sysfs_int(out, period);
+    if (write(period_f, out, length) == -1) {
         close(period_f);
         syslog(LOG_ERR, "pwm%i write_period: Failed to write to period: %s", dev->pin, strerror(errno));
         return MRAA_ERROR_INVALID_RESOURCE;
@@ -85,10 +85,10 @@ mraa_pwm_write_duty(mraa_pwm_context dev, int duty)
             return MRAA_ERROR_INVALID_RESOURCE;
         }
     }
-    char bu[MAX_SIZE];
-    int length = snprintf(bu, MAX_SIZE, "%d", duty);
-    if (write(dev->duty_fp, bu, length * sizeof(char)) == -1)
-    {
+    /* duty_cycle is rewritten on every mraa_pwm_write(), keep it to one pwrite. */
+    char bu[MRAA_SYSFS_INT_MAX_LEN];
+    int length = mraa_format_sysfs_int(bu, duty);
+    if (pwrite(dev->duty_fp, bu, length, 0) == -1) {
         syslog(LOG_ERR, "pwm%i write_duty: Failed to write to duty_cycle: %s", dev->pin, strerror(errno));
         return MRAA_ERROR_INVALID_RESOURCE;
     }
@@ -125,17 +125,13 @@ mraa_pwm_read_period(mraa_pwm_context dev)
         return -1;
     }
 
-    char* endptr;
-    long int ret = strtol(output, &endptr, 10);
-    if ('\0' != *endptr && '\n' != *endptr) {
+    int ret;
+    if (mraa_parse_sysfs_int(output, rb, &ret) != MRAA_SUCCESS) {
         syslog(LOG_ERR, "pwm%i read_period: Error in string conversion", dev->pin);
         return -1;
-    } else if (ret > INT_MAX || ret < INT_MIN) {
-        syslog(LOG_ERR, "pwm%i read_period: Number is invalid", dev->pin);
-        return -1;
     }
-    dev->period = (int) ret;
-    return (int) ret;
+    dev->period = ret;
+    return ret;
 }
 
 static int
@@ -156,27 +152,21 @@ mraa_pwm_read_duty(mraa_pwm_context dev)
                     dev->pin, strerror(errno));
             return -1;
         }
-    } else {
-        lseek(dev->duty_fp, 0, SEEK_SET);
     }
 
     char output[MAX_SIZE];
-    ssize_t rb = read(dev->duty_fp, output, MAX_SIZE);
+    ssize_t rb = pread(dev->duty_fp, output, MAX_SIZE, 0);
     if (rb < 0) {
         syslog(LOG_ERR, "pwm%i read_duty: Failed to read duty_cycle: %s", dev->pin, strerror(errno));
         return -1;
     }
 
-    char* endptr;
-    long int ret = strtol(output, &endptr, 10);
-    if ('\0' != *endptr && '\n' != *endptr) {
+    int ret;
+    if (mraa_parse_sysfs_int(output, rb, &ret) != MRAA_SUCCESS) {
         syslog(LOG_ERR, "pwm%i read_duty: Error in string conversion", dev->pin);
         return -1;
-    } else if (ret > INT_MAX || ret < INT_MIN) {
-        syslog(LOG_ERR, "pwm%i read_duty: Number is invalid", dev->pin);
-        return -1;
     }
-    return (int) ret;
+    return ret;
 }
 
 static mraa_pwm_context
@@ -198,6 +188,8 @@ mraa_pwm_init_internal(mraa_adv_func_t* func_table, int chipin, int pin)
 mraa_pwm_context
 mraa_pwm_init(int pin)
 {
+    mraa_init();
+
     mraa_board_t* board = plat;
     if (board == NULL) {
         syslog(LOG_ERR, "pwm_init: Platform Not Initialised");
@@ -270,6 +262,8 @@ mraa_pwm_init(int pin)
 mraa_pwm_context
 mraa_pwm_init_raw(int chipin, int pin)
 {
+    mraa_init();
+
     mraa_pwm_context dev = mraa_pwm_init_internal(plat == NULL ? NULL : plat->adv_func , chipin, pin);
     if (dev == NULL) {
         syslog(LOG_CRIT, "pwm: Failed to allocate memory for context");
@@ -64,3 +64,28 @@ mraa_python_isr(void (*isr)(void*), void* isr_args)
 
     PyGILState_Release(gilstate);
 }
+
+// Completion callbacks of asynchronous i2c/spi requests are one shot, the
+// references taken on submission are dropped once the callback ran
+void
+mraa_python_bus_callback(void (*cb)(mraa_result_t, void*), mraa_result_t status, void* args)
+{
+    PyGILState_STATE gilstate = PyGILState_Ensure();
+    PyObject* arglist = Py_BuildValue("(iO)", (int) status, (PyObject*) args);
+    if (arglist == NULL) {
+        syslog(LOG_ERR, "bus: Py_BuildValue NULL");
+    } else {
+        PyObject* ret = PyObject_CallObject((PyObject*) cb, arglist);
+        if (ret == NULL) {
+            syslog(LOG_ERR, "bus: Python call failed");
+            PyErr_Clear();
+        } else {
+            Py_DECREF(ret);
+        }
+        Py_DECREF(arglist);
+    }
+    Py_DECREF((PyObject*) cb);
+    Py_DECREF((PyObject*) args);
+
+    PyGILState_Release(gilstate);
+}
@@ -142,6 +142,41 @@ class Spi;
    free($2);
 }
 
+// Spi::transferInto(), buffers are used in place. The views are held until
+// the call returned and released by the freearg typemaps, which also run on
+// the error path, hence the flags.
+%typemap(in) (const uint8_t* txData, int txLength) (Py_buffer view, int have_view = 0) {
+  if (PyObject_GetBuffer($input, &view, PyBUF_SIMPLE) != 0) {
+    PyErr_SetString(PyExc_ValueError, "object supporting the buffer protocol expected");
+    SWIG_fail;
+  }
+  have_view = 1;
+  $1 = (uint8_t*) view.buf;
+  $2 = (int) view.len;
+}
+
+%typemap(freearg) (const uint8_t* txData, int txLength) {
+  if (have_view$argnum) {
+    PyBuffer_Release(&view$argnum);
+  }
+}
+
+%typemap(in) (uint8_t* rxData, int rxLength) (Py_buffer view, int have_view = 0) {
+  if (PyObject_GetBuffer($input, &view, PyBUF_WRITABLE) != 0) {
+    PyErr_SetString(PyExc_ValueError, "writable object supporting the buffer protocol expected");
+    SWIG_fail;
+  }
+  have_view = 1;
+  $1 = (uint8_t*) view.buf;
+  $2 = (int) view.len;
+}
+
+%typemap(freearg) (uint8_t* rxData, int rxLength) {
+  if (have_view$argnum) {
+    PyBuffer_Release(&view$argnum);
+  }
+}
+
 %include ../mraa.i
 
 %init %{
@@ -162,6 +197,7 @@ class Spi;
     mraa_result_t res = mraa_init();
     if (res == MRAA_SUCCESS) {
         lang_func->python_isr = &mraa_python_isr;
+        lang_func->python_bus_callback = &mraa_python_bus_callback;
     }
     else
         SWIG_Error(SWIG_RuntimeError, "mraa_init() failed");
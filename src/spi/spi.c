@@ -25,13 +25,139 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "spi.h"
 #include "mraa_internal.h"
+#include "bus/bus_arbiter.h"
 
 #define MAX_SIZE 64
 #define SPI_MAX_LENGTH 4096
 
+/*
+ * Settings spidev holds for a device node. Every fd open on the node shares
+ * them, so all the contexts of a bus/chip select share one record, which is
+ * read and written with the bus arbiter held. -1 (0 for the bits per word
+ * and the speed) means the value isn't known.
+ */
+struct _spi_kernel {
+    unsigned int bus;
+    unsigned int cs;
+    int refs;
+    int mode;
+    int lsb;
+    unsigned int bpw;
+    int speed;
+    struct _spi_kernel* next;
+};
+
+static struct _spi_kernel* spi_kernel_list = NULL;
+static pthread_mutex_t spi_kernel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct _spi_kernel*
+mraa_spi_kernel_get(unsigned int bus, unsigned int cs)
+{
+    struct _spi_kernel* kernel;
+
+    pthread_mutex_lock(&spi_kernel_lock);
+    for (kernel = spi_kernel_list; kernel != NULL; kernel = kernel->next) {
+        if (kernel->bus == bus && kernel->cs == cs) {
+            break;
+        }
+    }
+    if (kernel == NULL) {
+        kernel = (struct _spi_kernel*) calloc(1, sizeof(struct _spi_kernel));
+        if (kernel != NULL) {
+            kernel->bus = bus;
+            kernel->cs = cs;
+            kernel->mode = -1;
+            kernel->lsb = -1;
+            kernel->next = spi_kernel_list;
+            spi_kernel_list = kernel;
+        }
+    }
+    if (kernel != NULL) {
+        kernel->refs++;
+    }
+    pthread_mutex_unlock(&spi_kernel_lock);
+
+    return kernel;
+}
+
+static void
+mraa_spi_kernel_put(struct _spi_kernel* kernel)
+{
+    if (kernel == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&spi_kernel_lock);
+    if (--kernel->refs == 0) {
+        struct _spi_kernel** it = &spi_kernel_list;
+        while (*it != kernel) {
+            it = &(*it)->next;
+        }
+        *it = kernel->next;
+        free(kernel);
+    }
+    pthread_mutex_unlock(&spi_kernel_lock);
+}
+
+/* All ioctls on the device file go through here to be counted. */
+static int
+mraa_spi_ioctl(mraa_spi_context dev, unsigned long request, void* arg)
+{
+    dev->ioctl_stats.issued++;
+    return ioctl(dev->devfd, request, arg);
+}
+
+/* Mode and bit order have no spi_ioc_transfer field, the bus must be held. */
+static mraa_result_t
+mraa_spi_apply_mode(mraa_spi_context dev, uint8_t mode)
+{
+    if (dev->kernel->mode == mode) {
+        return MRAA_SUCCESS;
+    }
+    if (mraa_spi_ioctl(dev, SPI_IOC_WR_MODE, &mode) < 0) {
+        dev->kernel->mode = -1;
+        syslog(LOG_ERR, "spi%i: Failed to set spi mode: %s", dev->busnum, strerror(errno));
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    dev->kernel->mode = mode;
+    return MRAA_SUCCESS;
+}
+
+static mraa_result_t
+mraa_spi_apply_lsb(mraa_spi_context dev, uint8_t lsb)
+{
+    if (dev->kernel->lsb == lsb) {
+        return MRAA_SUCCESS;
+    }
+    if (mraa_spi_ioctl(dev, SPI_IOC_WR_LSB_FIRST, &lsb) < 0) {
+        dev->kernel->lsb = -1;
+        syslog(LOG_ERR, "spi%i: Failed to set bit order: %s", dev->busnum, strerror(errno));
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    dev->kernel->lsb = lsb;
+    return MRAA_SUCCESS;
+}
+
+/*
+ * Send a message with the settings of this context. Speed and word size go
+ * in the transfers; mode and bit order are only written when another
+ * context of the same device node changed them. The bus must be held.
+ */
+static int
+mraa_spi_message(mraa_spi_context dev, unsigned int count, struct spi_ioc_transfer* msg)
+{
+    if (mraa_spi_apply_mode(dev, (uint8_t) dev->mode) != MRAA_SUCCESS ||
+        mraa_spi_apply_lsb(dev, (uint8_t) dev->lsb) != MRAA_SUCCESS) {
+        return -1;
+    }
+    return mraa_spi_ioctl(dev, SPI_IOC_MESSAGE(count), msg);
+}
+
 static mraa_spi_context
 mraa_spi_init_internal(mraa_adv_func_t* func_table)
 {
@@ -47,6 +173,8 @@ mraa_spi_init_internal(mraa_adv_func_t* func_table)
 mraa_spi_context
 mraa_spi_init(int bus)
 {
+    mraa_init();
+
     if (plat == NULL) {
         syslog(LOG_ERR, "spi: Platform Not Initialised");
         return NULL;
@@ -134,11 +262,14 @@ mraa_spi_init(int bus)
         }
     }
     mraa_spi_context dev = mraa_spi_init_raw(plat->spi_bus[bus].bus_id, plat->spi_bus[bus].slave_s);
+    if (dev == NULL) {
+        return NULL;
+    }
 
     if (plat->adv_func != NULL && plat->adv_func->spi_init_post != NULL) {
         mraa_result_t ret = plat->adv_func->spi_init_post(dev);
         if (ret != MRAA_SUCCESS) {
-            free(dev);
+            mraa_spi_stop(dev);
             return NULL;
         }
     }
@@ -149,6 +280,8 @@ mraa_spi_init(int bus)
 mraa_spi_context
 mraa_spi_init_raw(unsigned int bus, unsigned int cs)
 {
+    mraa_init();
+
     mraa_result_t status = MRAA_SUCCESS;
 
     mraa_spi_context dev = mraa_spi_init_internal(plat == NULL ? NULL : plat->adv_func);
@@ -157,6 +290,15 @@ mraa_spi_init_raw(unsigned int bus, unsigned int cs)
         status = MRAA_ERROR_NO_RESOURCES;
         goto init_raw_cleanup;
     }
+    dev->busnum = bus;
+    dev->arbiter = mraa_bus_arbiter_get(MRAA_BUS_ARBITER_SPI, bus);
+    dev->priority = MRAA_BUS_PRIORITY_NORMAL;
+    dev->kernel = mraa_spi_kernel_get(bus, cs);
+    if (dev->kernel == NULL) {
+        syslog(LOG_CRIT, "spi: Failed to allocate memory for context");
+        status = MRAA_ERROR_NO_RESOURCES;
+        goto init_raw_cleanup;
+    }
 
     if (IS_FUNC_DEFINED(dev, spi_init_raw_replace)) {
         status = dev->advance_func->spi_init_raw_replace(dev, bus, cs);
@@ -178,8 +320,9 @@ mraa_spi_init_raw(unsigned int bus, unsigned int cs)
     }
 
     int speed = 0;
-    if (ioctl(dev->devfd, SPI_IOC_RD_MAX_SPEED_HZ, &speed) != -1) {
+    if (mraa_spi_ioctl(dev, SPI_IOC_RD_MAX_SPEED_HZ, &speed) != -1) {
         dev->clock = speed;
+        dev->kernel->speed = speed;
     } else {
         // We had this on Galileo Gen1, so let it be a fallback value
         dev->clock = 4000000;
@@ -204,6 +347,7 @@ mraa_spi_init_raw(unsigned int bus, unsigned int cs)
 init_raw_cleanup:
     if (status != MRAA_SUCCESS) {
         if (dev != NULL) {
+            mraa_spi_kernel_put(dev->kernel);
             free(dev);
         }
         return NULL;
@@ -221,7 +365,10 @@ mraa_spi_mode(mraa_spi_context dev, mraa_spi_mode_t mode)
     }
 
     if (IS_FUNC_DEFINED(dev, spi_mode_replace)) {
-        return dev->advance_func->spi_mode_replace(dev, mode);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->spi_mode_replace(dev, mode);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
     uint8_t spi_mode = 0;
@@ -243,9 +390,14 @@ mraa_spi_mode(mraa_spi_context dev, mraa_spi_mode_t mode)
             break;
     }
 
-    if (ioctl(dev->devfd, SPI_IOC_WR_MODE, &spi_mode) < 0) {
-        syslog(LOG_ERR, "spi: Failed to set spi mode");
-        return MRAA_ERROR_INVALID_RESOURCE;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (dev->kernel->mode == spi_mode) {
+        dev->ioctl_stats.avoided++;
+    }
+    mraa_result_t ret = mraa_spi_apply_mode(dev, spi_mode);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret != MRAA_SUCCESS) {
+        return ret;
     }
 
     dev->mode = spi_mode;
@@ -261,26 +413,335 @@ mraa_spi_frequency(mraa_spi_context dev, int hz)
     }
 
     if (IS_FUNC_DEFINED(dev, spi_frequency_replace)) {
-        return dev->advance_func->spi_frequency_replace(dev, hz);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->spi_frequency_replace(dev, hz);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
-    int speed = 0;
-    if (ioctl(dev->devfd, SPI_IOC_RD_MAX_SPEED_HZ, &speed) == 0) {
-        dev->clock = speed; // if setting the clock fails, at least we 
-                            // will be able to known what the real
-                            // clock of the device is
+    // Every transfer carries the clock of its context in speed_hz, so a
+    // clock the device node already accepted needs no ioctl
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (hz == dev->clock || hz == dev->kernel->speed) {
+        dev->ioctl_stats.avoided++;
+        mraa_bus_arbiter_release(dev->arbiter);
+        dev->clock = hz;
+        return MRAA_SUCCESS;
     }
-    else
-        syslog(LOG_NOTICE, "spi: unable to read SPI clock. Error %d %s", errno, strerror(errno));
 
-    if (ioctl(dev->devfd, SPI_IOC_WR_MAX_SPEED_HZ, &hz) != 0) {
-        syslog(LOG_ERR, "spi: failed to set SPI clock. Original value remains (%d). Error %d %s", speed, errno, strerror(errno));
+    int ret = mraa_spi_ioctl(dev, SPI_IOC_WR_MAX_SPEED_HZ, &hz);
+    if (ret != 0) {
+        int err = errno;
+        int speed = 0;
+        if (mraa_spi_ioctl(dev, SPI_IOC_RD_MAX_SPEED_HZ, &speed) == 0) {
+            dev->clock = speed; // if setting the clock fails, at least we
+                                // will be able to known what the real
+                                // clock of the device is
+            dev->kernel->speed = speed;
+        } else {
+            syslog(LOG_NOTICE, "spi: unable to read SPI clock. Error %d %s", errno, strerror(errno));
+        }
+        mraa_bus_arbiter_release(dev->arbiter);
+        syslog(LOG_ERR, "spi: failed to set SPI clock. Original value remains (%d). Error %d %s", dev->clock, err, strerror(err));
         return MRAA_ERROR_INVALID_RESOURCE;
     }
+    dev->kernel->speed = hz;
+    mraa_bus_arbiter_release(dev->arbiter);
     dev->clock = hz;        // store the actual clock now that we succeeded changing it
     return MRAA_SUCCESS;
 }
 
+/* Run the segments one by one through the platform's transfer function. */
+static mraa_result_t
+mraa_spi_transfer_segments_replace(mraa_spi_context dev, const mraa_spi_segment_t* segments, unsigned int count)
+{
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    for (unsigned int i = 0; i < count && ret == MRAA_SUCCESS; i++) {
+        uint8_t* tx = (uint8_t*) segments[i].tx;
+        if (tx == NULL) {
+            tx = (uint8_t*) calloc(segments[i].length, 1);
+            if (tx == NULL) {
+                ret = MRAA_ERROR_NO_RESOURCES;
+                break;
+            }
+        }
+        ret = dev->advance_func->spi_transfer_buf_replace(dev, tx, segments[i].rx, segments[i].length);
+        if (tx != segments[i].tx) {
+            free(tx);
+        }
+        if (segments[i].delay_usecs > 0) {
+            usleep(segments[i].delay_usecs);
+        }
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return ret;
+}
+
+mraa_result_t
+mraa_spi_transfer_segments(mraa_spi_context dev, const mraa_spi_segment_t* segments, unsigned int count)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: transfer_segments: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if (segments == NULL || count == 0 || count > MRAA_SPI_MAX_SEGMENTS) {
+        syslog(LOG_ERR, "spi: transfer_segments: invalid list of %u segments", count);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+    for (unsigned int i = 0; i < count; i++) {
+        if (segments[i].length == 0) {
+            syslog(LOG_ERR, "spi: transfer_segments: segment %u is empty", i);
+            return MRAA_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    if (IS_FUNC_DEFINED(dev, spi_transfer_buf_replace)) {
+        return mraa_spi_transfer_segments_replace(dev, segments, count);
+    }
+
+    struct spi_ioc_transfer msg[MRAA_SPI_MAX_SEGMENTS];
+    memset(msg, 0, sizeof(struct spi_ioc_transfer) * count);
+    for (unsigned int i = 0; i < count; i++) {
+        msg[i].tx_buf = (unsigned long) segments[i].tx;
+        msg[i].rx_buf = (unsigned long) segments[i].rx;
+        msg[i].len = segments[i].length;
+        msg[i].speed_hz = segments[i].speed_hz ? segments[i].speed_hz : (uint32_t) dev->clock;
+        msg[i].bits_per_word = segments[i].bits_per_word ? segments[i].bits_per_word : dev->bpw;
+        msg[i].cs_change = segments[i].cs_change;
+        msg[i].delay_usecs = segments[i].delay_usecs;
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_spi_message(dev, count, msg);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
+        syslog(LOG_ERR, "spi: Failed to perform segmented transfer: %s", strerror(errno));
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    return MRAA_SUCCESS;
+}
+
+/*
+ * Largest transfer spidev takes in one message, its bufsiz module parameter.
+ * Platforms replacing the transfer functions don't go through spidev.
+ */
+static size_t
+mraa_spi_stream_chunk_size(mraa_spi_context dev)
+{
+    static size_t bufsiz = 0;
+
+    if (IS_FUNC_DEFINED(dev, spi_transfer_buf_replace)) {
+        return MRAA_SPI_STREAM_DEFAULT_CHUNK;
+    }
+    if (bufsiz == 0) {
+        unsigned long value = 0;
+        FILE* fh = fopen("/sys/module/spidev/parameters/bufsiz", "r");
+        if (fh != NULL) {
+            if (fscanf(fh, "%lu", &value) != 1) {
+                value = 0;
+            }
+            fclose(fh);
+        }
+        bufsiz = value > 0 ? value : MRAA_SPI_STREAM_DEFAULT_CHUNK;
+    }
+    return bufsiz;
+}
+
+/*
+ * One chunk of a stream, with the bus held by the caller. keep_cs leaves the
+ * chip selected after the chunk so the next one continues the same frame.
+ */
+static mraa_result_t
+mraa_spi_stream_chunk(mraa_spi_context dev, const uint8_t* data, uint8_t* rxbuf, size_t length, mraa_boolean_t keep_cs)
+{
+    if (IS_FUNC_DEFINED(dev, spi_transfer_buf_replace)) {
+        return dev->advance_func->spi_transfer_buf_replace(dev, (uint8_t*) data, rxbuf, (int) length);
+    }
+
+    struct spi_ioc_transfer msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.tx_buf = (unsigned long) data;
+    msg.rx_buf = (unsigned long) rxbuf;
+    msg.len = length;
+    msg.speed_hz = dev->clock;
+    msg.bits_per_word = dev->bpw;
+    msg.cs_change = keep_cs ? 1 : 0;
+
+    if (mraa_spi_message(dev, 1, &msg) < 0) {
+        syslog(LOG_ERR, "spi%i: stream: Failed to transfer %zu byte chunk: %s", dev->busnum,
+               length, strerror(errno));
+        return MRAA_ERROR_INVALID_RESOURCE;
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_spi_transfer_stream(mraa_spi_context dev, const uint8_t* data, uint8_t* rxbuf, size_t length, mraa_boolean_t keep_cs)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: transfer_stream: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    if (data == NULL || length == 0) {
+        syslog(LOG_ERR, "spi%i: transfer_stream: nothing to send", dev->busnum);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    size_t chunk = mraa_spi_stream_chunk_size(dev);
+    mraa_result_t ret = MRAA_SUCCESS;
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    for (size_t offset = 0; offset < length && ret == MRAA_SUCCESS; offset += chunk) {
+        size_t n = length - offset < chunk ? length - offset : chunk;
+        ret = mraa_spi_stream_chunk(dev, data + offset, rxbuf != NULL ? rxbuf + offset : NULL, n,
+                                    keep_cs && offset + n < length);
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+
+    return ret;
+}
+
+/*
+ * State shared by mraa_spi_write_stream() and its fill thread. The thread
+ * fills one chunk buffer while the caller sends the other; full[] hands the
+ * buffers back and forth and abort stops both sides on the first error.
+ */
+typedef struct {
+    mraa_spi_context dev;
+    size_t length;
+    size_t chunk;
+    mraa_spi_stream_fill_t fill;
+    void* args;
+    uint8_t* buf[2];
+    size_t len[2];
+    mraa_boolean_t full[2];
+    mraa_boolean_t abort;
+    mraa_result_t status;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} mraa_spi_stream_t;
+
+static void*
+mraa_spi_stream_thread(void* arg)
+{
+    mraa_spi_stream_t* s = (mraa_spi_stream_t*) arg;
+
+    for (size_t offset = 0, i = 0; offset < s->length; offset += s->len[i], i ^= 1) {
+        pthread_mutex_lock(&s->lock);
+        while (s->full[i] && !s->abort) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        mraa_boolean_t abort = s->abort;
+        pthread_mutex_unlock(&s->lock);
+        if (abort) {
+            break;
+        }
+
+        size_t n = s->length - offset < s->chunk ? s->length - offset : s->chunk;
+        mraa_result_t ret = s->fill(s->args, s->buf[i], offset, n);
+
+        pthread_mutex_lock(&s->lock);
+        if (ret != MRAA_SUCCESS) {
+            s->status = ret;
+            s->abort = 1;
+        } else {
+            s->len[i] = n;
+            s->full[i] = 1;
+        }
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+        if (ret != MRAA_SUCCESS) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+mraa_result_t
+mraa_spi_write_stream(mraa_spi_context dev,
+                      size_t length,
+                      mraa_spi_stream_fill_t fill,
+                      void* args,
+                      mraa_boolean_t keep_cs)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: write_stream: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    if (fill == NULL || length == 0) {
+        syslog(LOG_ERR, "spi%i: write_stream: nothing to send", dev->busnum);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    mraa_spi_stream_t s;
+    memset(&s, 0, sizeof(s));
+    s.dev = dev;
+    s.length = length;
+    s.chunk = mraa_spi_stream_chunk_size(dev);
+    s.fill = fill;
+    s.args = args;
+    s.status = MRAA_SUCCESS;
+
+    size_t first = length < s.chunk ? length : s.chunk;
+    s.buf[0] = (uint8_t*) malloc(first);
+    s.buf[1] = length > s.chunk ? (uint8_t*) malloc(first) : NULL;
+    if (s.buf[0] == NULL || (length > s.chunk && s.buf[1] == NULL)) {
+        syslog(LOG_ERR, "spi%i: write_stream: Failed to allocate chunk buffers", dev->busnum);
+        free(s.buf[0]);
+        free(s.buf[1]);
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.cond, NULL);
+
+    // the transfers stay on the calling thread, so a bus it already holds is reused
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, mraa_spi_stream_thread, &s) != 0) {
+        syslog(LOG_ERR, "spi%i: write_stream: Failed to start the fill thread", dev->busnum);
+        s.status = MRAA_ERROR_NO_RESOURCES;
+    } else {
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        for (size_t offset = 0, i = 0; offset < length; i ^= 1) {
+            pthread_mutex_lock(&s.lock);
+            while (!s.full[i] && !s.abort) {
+                pthread_cond_wait(&s.cond, &s.lock);
+            }
+            mraa_boolean_t abort = s.abort;
+            pthread_mutex_unlock(&s.lock);
+            if (abort) {
+                break;
+            }
+
+            offset += s.len[i];
+            mraa_result_t ret =
+            mraa_spi_stream_chunk(dev, s.buf[i], NULL, s.len[i], keep_cs && offset < length);
+
+            pthread_mutex_lock(&s.lock);
+            s.full[i] = 0;
+            if (ret != MRAA_SUCCESS) {
+                s.status = ret;
+                s.abort = 1;
+            }
+            pthread_cond_broadcast(&s.cond);
+            pthread_mutex_unlock(&s.lock);
+        }
+        mraa_bus_arbiter_release(dev->arbiter);
+        pthread_join(thread, NULL);
+    }
+
+    pthread_cond_destroy(&s.cond);
+    pthread_mutex_destroy(&s.lock);
+    free(s.buf[0]);
+    free(s.buf[1]);
+
+    return s.status;
+}
+
 mraa_result_t
 mraa_spi_lsbmode(mraa_spi_context dev, mraa_boolean_t lsb)
 {
@@ -290,19 +751,23 @@ mraa_spi_lsbmode(mraa_spi_context dev, mraa_boolean_t lsb)
     }
 
     if (IS_FUNC_DEFINED(dev, spi_lsbmode_replace)) {
-        return dev->advance_func->spi_lsbmode_replace(dev, lsb);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->spi_lsbmode_replace(dev, lsb);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
-    uint8_t lsb_mode = (uint8_t) lsb;
-    if (ioctl(dev->devfd, SPI_IOC_WR_LSB_FIRST, &lsb_mode) < 0) {
-        syslog(LOG_ERR, "spi: Failed to set bit order");
-        return MRAA_ERROR_INVALID_RESOURCE;
+    uint8_t lsb_mode = lsb ? 1 : 0;
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (dev->kernel->lsb == lsb_mode) {
+        dev->ioctl_stats.avoided++;
     }
-    if (ioctl(dev->devfd, SPI_IOC_RD_LSB_FIRST, &lsb_mode) < 0) {
-        syslog(LOG_ERR, "spi: Failed to set bit order");
-        return MRAA_ERROR_INVALID_RESOURCE;
+    mraa_result_t ret = mraa_spi_apply_lsb(dev, lsb_mode);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret != MRAA_SUCCESS) {
+        return ret;
     }
-    dev->lsb = lsb;
+    dev->lsb = lsb_mode;
     return MRAA_SUCCESS;
 }
 
@@ -315,10 +780,27 @@ mraa_spi_bit_per_word(mraa_spi_context dev, unsigned int bits)
     }
 
     if (IS_FUNC_DEFINED(dev, spi_bit_per_word_replace)) {
-        return dev->advance_func->spi_bit_per_word_replace(dev, bits);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->spi_bit_per_word_replace(dev, bits);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
-    if (ioctl(dev->devfd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) {
+    // Like the clock, the word size goes in every transfer
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    if (bits == dev->bpw || bits == dev->kernel->bpw) {
+        dev->ioctl_stats.avoided++;
+        mraa_bus_arbiter_release(dev->arbiter);
+        dev->bpw = bits;
+        return MRAA_SUCCESS;
+    }
+    uint8_t spi_bits = (uint8_t) bits;
+    int ret = mraa_spi_ioctl(dev, SPI_IOC_WR_BITS_PER_WORD, &spi_bits);
+    if (ret == 0) {
+        dev->kernel->bpw = bits;
+    }
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
         syslog(LOG_ERR, "spi: Failed to set bit per word");
         return MRAA_ERROR_INVALID_RESOURCE;
     }
@@ -335,7 +817,10 @@ mraa_spi_write(mraa_spi_context dev, uint8_t data)
     }
 
     if (IS_FUNC_DEFINED(dev, spi_write_replace)) {
-        return dev->advance_func->spi_write_replace(dev, data);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        int ret = dev->advance_func->spi_write_replace(dev, data);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
     struct spi_ioc_transfer msg;
@@ -350,7 +835,10 @@ mraa_spi_write(mraa_spi_context dev, uint8_t data)
     msg.bits_per_word = dev->bpw;
     msg.delay_usecs = 0;
     msg.len = length;
-    if (ioctl(dev->devfd, SPI_IOC_MESSAGE(1), &msg) < 0) {
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_spi_message(dev, 1, &msg);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
         syslog(LOG_ERR, "spi: Failed to perform dev transfer");
         return -1;
     }
@@ -366,7 +854,10 @@ mraa_spi_write_word(mraa_spi_context dev, uint16_t data)
     }
 
     if (IS_FUNC_DEFINED(dev, spi_write_word_replace)) {
-        return dev->advance_func->spi_write_word_replace(dev, data);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        int ret = dev->advance_func->spi_write_word_replace(dev, data);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
     struct spi_ioc_transfer msg;
@@ -381,7 +872,10 @@ mraa_spi_write_word(mraa_spi_context dev, uint16_t data)
     msg.bits_per_word = dev->bpw;
     msg.delay_usecs = 0;
     msg.len = length;
-    if (ioctl(dev->devfd, SPI_IOC_MESSAGE(1), &msg) < 0) {
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_spi_message(dev, 1, &msg);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
         syslog(LOG_ERR, "spi: Failed to perform dev transfer");
         return -1;
     }
@@ -397,7 +891,10 @@ mraa_spi_transfer_buf(mraa_spi_context dev, uint8_t* data, uint8_t* rxbuf, int l
     }
 
     if (IS_FUNC_DEFINED(dev, spi_transfer_buf_replace)) {
-        return dev->advance_func->spi_transfer_buf_replace(dev, data, rxbuf, length);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->spi_transfer_buf_replace(dev, data, rxbuf, length);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
     struct spi_ioc_transfer msg;
@@ -409,7 +906,10 @@ mraa_spi_transfer_buf(mraa_spi_context dev, uint8_t* data, uint8_t* rxbuf, int l
     msg.bits_per_word = dev->bpw;
     msg.delay_usecs = 0;
     msg.len = length;
-    if (ioctl(dev->devfd, SPI_IOC_MESSAGE(1), &msg) < 0) {
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_spi_message(dev, 1, &msg);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
         syslog(LOG_ERR, "spi: Failed to perform dev transfer");
         return MRAA_ERROR_INVALID_RESOURCE;
     }
@@ -425,7 +925,10 @@ mraa_spi_transfer_buf_word(mraa_spi_context dev, uint16_t* data, uint16_t* rxbuf
     }
 
     if (IS_FUNC_DEFINED(dev, spi_transfer_buf_word_replace)) {
-        return dev->advance_func->spi_transfer_buf_word_replace(dev, data, rxbuf, length);
+        mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+        mraa_result_t ret = dev->advance_func->spi_transfer_buf_word_replace(dev, data, rxbuf, length);
+        mraa_bus_arbiter_release(dev->arbiter);
+        return ret;
     }
 
     struct spi_ioc_transfer msg;
@@ -437,7 +940,10 @@ mraa_spi_transfer_buf_word(mraa_spi_context dev, uint16_t* data, uint16_t* rxbuf
     msg.bits_per_word = dev->bpw;
     msg.delay_usecs = 0;
     msg.len = length;
-    if (ioctl(dev->devfd, SPI_IOC_MESSAGE(1), &msg) < 0) {
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    int ret = mraa_spi_message(dev, 1, &msg);
+    mraa_bus_arbiter_release(dev->arbiter);
+    if (ret < 0) {
         syslog(LOG_ERR, "spi: Failed to perform dev transfer");
         return MRAA_ERROR_INVALID_RESOURCE;
     }
@@ -461,6 +967,64 @@ mraa_spi_write_buf(mraa_spi_context dev, uint8_t* data, int length)
     return recv;
 }
 
+/* Grow the receive pool of the context to at least length bytes. */
+static void*
+mraa_spi_rx_pool(mraa_spi_context dev, int length, const char* fn)
+{
+    // grows to the longest transfer made on the context, then stays
+    if (length > dev->rx_pool_size) {
+        uint8_t* pool = realloc(dev->rx_pool, length);
+        if (pool == NULL) {
+            syslog(LOG_CRIT, "spi: %s: Failed to allocate memory for receive buffer", fn);
+            return NULL;
+        }
+        dev->rx_pool = pool;
+        dev->rx_pool_size = length;
+    }
+    return dev->rx_pool;
+}
+
+uint8_t*
+mraa_spi_write_buf_pooled(mraa_spi_context dev, uint8_t* data, int length)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: write_buf_pooled: context is invalid");
+        return NULL;
+    }
+
+    if (length <= 0) {
+        syslog(LOG_ERR, "spi: write_buf_pooled: invalid length %d", length);
+        return NULL;
+    }
+
+    uint8_t* recv = mraa_spi_rx_pool(dev, length, "write_buf_pooled");
+    if (recv == NULL || mraa_spi_transfer_buf(dev, data, recv, length) != MRAA_SUCCESS) {
+        return NULL;
+    }
+    return recv;
+}
+
+uint16_t*
+mraa_spi_write_buf_word_pooled(mraa_spi_context dev, uint16_t* data, int length)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: write_buf_word_pooled: context is invalid");
+        return NULL;
+    }
+
+    if (length <= 0 || length % 2 != 0) {
+        syslog(LOG_ERR, "spi: write_buf_word_pooled: invalid length %d", length);
+        return NULL;
+    }
+
+    // malloc'ed, so suitably aligned for words
+    uint16_t* recv = mraa_spi_rx_pool(dev, length, "write_buf_word_pooled");
+    if (recv == NULL || mraa_spi_transfer_buf_word(dev, data, recv, length) != MRAA_SUCCESS) {
+        return NULL;
+    }
+    return recv;
+}
+
 uint16_t*
 mraa_spi_write_buf_word(mraa_spi_context dev, uint16_t* data, int length)
 {
@@ -478,6 +1042,369 @@ mraa_spi_write_buf_word(mraa_spi_context dev, uint16_t* data, int length)
     return recv;
 }
 
+mraa_result_t
+mraa_spi_set_priority(mraa_spi_context dev, mraa_bus_priority_t priority)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: set_priority: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    if ((unsigned int) priority >= MRAA_BUS_PRIORITY_COUNT) {
+        syslog(LOG_ERR, "spi: set_priority: invalid priority %d", priority);
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    dev->priority = priority;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_spi_bus_acquire(mraa_spi_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: bus_acquire: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    mraa_bus_arbiter_acquire(dev->arbiter, dev->priority);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_spi_bus_release(mraa_spi_context dev)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: bus_release: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    return mraa_bus_arbiter_release(dev->arbiter);
+}
+
+mraa_result_t
+mraa_spi_bus_stats(mraa_spi_context dev, mraa_bus_stats_t* stats)
+{
+    if (dev == NULL || stats == NULL) {
+        syslog(LOG_ERR, "spi: bus_stats: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    mraa_bus_arbiter_stats(dev->arbiter, stats);
+    return MRAA_SUCCESS;
+}
+
+static mraa_result_t
+mraa_spi_transfer_run_async(struct _bus_async* req)
+{
+    return mraa_spi_transfer_buf((mraa_spi_context) req->dev, req->tx, req->rx, req->length);
+}
+
+mraa_result_t
+mraa_spi_transfer_buf_async(mraa_spi_context dev,
+                            uint8_t* data,
+                            uint8_t* rxbuf,
+                            int length,
+                            mraa_bus_async_cb_t cb,
+                            void* args,
+                            mraa_bus_async_t* handle)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: transfer_buf_async: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    struct _bus_async* req = (struct _bus_async*) calloc(1, sizeof(struct _bus_async));
+    if (req == NULL) {
+        syslog(LOG_CRIT, "spi: transfer_buf_async: Failed to allocate memory for request");
+        return MRAA_ERROR_NO_RESOURCES;
+    }
+    req->run = &mraa_spi_transfer_run_async;
+    req->owner = dev;
+    req->dev = dev;
+    req->tx = data;
+    req->rx = rxbuf;
+    req->length = length;
+    req->cb = cb;
+    req->args = args;
+
+    return mraa_bus_arbiter_submit(dev->arbiter, req, handle);
+}
+
+/*
+ * Ring of blocks filled by a sampling thread. head and tail run from 0 to
+ * 2 * blocks, which tells a full ring from an empty one, and are only
+ * written by the thread and the reader respectively, so the data path takes
+ * no lock. The reader sleeps on cond when the ring is empty; waiting tells
+ * the thread to wake it.
+ */
+struct _spi_ring {
+    mraa_spi_context dev;
+    uint8_t* tx;
+    uint8_t* data;
+    mraa_spi_block_info_t* info;
+    unsigned int block_size;
+    unsigned int blocks;
+    unsigned int period_us;
+    int priority;
+    unsigned int head;
+    unsigned int tail;
+    int running;
+    int waiting;
+    mraa_result_t status;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+};
+
+static uint64_t
+mraa_spi_ring_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Wake the reader if it is, or is about to be, waiting for a block. */
+static void
+mraa_spi_ring_wake(mraa_spi_ring_context ring)
+{
+    if (__atomic_load_n(&ring->waiting, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&ring->lock);
+        pthread_cond_broadcast(&ring->cond);
+        pthread_mutex_unlock(&ring->lock);
+    }
+}
+
+static void*
+mraa_spi_ring_thread(void* arg)
+{
+    mraa_spi_ring_context ring = (mraa_spi_ring_context) arg;
+    unsigned int dropped = 0;
+    uint64_t sequence = 0;
+    uint64_t period_ns = (uint64_t) ring->period_us * 1000;
+    uint64_t next_ns;
+
+    if (ring->priority > 0 && mraa_set_priority(ring->priority) != 0) {
+        syslog(LOG_WARNING, "spi%i: ring: unable to set priority %d: %s", ring->dev->busnum,
+               ring->priority, strerror(errno));
+    }
+    next_ns = mraa_spi_ring_now_ns();
+
+    while (__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE)) {
+        if (period_ns > 0) {
+            next_ns += period_ns;
+            // after a transfer ran over, skip the periods it missed rather
+            // than catching up with a burst, they count as overruns
+            uint64_t now = mraa_spi_ring_now_ns();
+            if (now > next_ns + period_ns) {
+                uint64_t missed = (now - next_ns) / period_ns;
+                next_ns += missed * period_ns;
+                dropped += (unsigned int) missed;
+                sequence += missed;
+            }
+            struct timespec next;
+            next.tv_sec = (time_t) (next_ns / 1000000000ULL);
+            next.tv_nsec = (long) (next_ns % 1000000000ULL);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+
+        unsigned int head = ring->head;
+        unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        unsigned int slot = head % ring->blocks;
+        mraa_boolean_t full = (head + 2 * ring->blocks - tail) % (2 * ring->blocks) == ring->blocks;
+        /*
+         * Keep sampling when the reader is behind, so the timing of the
+         * device doesn't change, but into a scratch block past the ring.
+         */
+        uint8_t* block = ring->data + (size_t) (full ? ring->blocks : slot) * ring->block_size;
+
+        mraa_result_t ret =
+        mraa_spi_transfer_buf(ring->dev, ring->tx, block, (int) ring->block_size);
+        uint64_t now = mraa_spi_ring_now_ns();
+        if (ret != MRAA_SUCCESS) {
+            ring->status = ret;
+            __atomic_store_n(&ring->running, 0, __ATOMIC_RELEASE);
+            break;
+        }
+        if (full) {
+            dropped++;
+            sequence++;
+            continue;
+        }
+
+        ring->info[slot].timestamp_ns = now;
+        ring->info[slot].sequence = sequence++;
+        ring->info[slot].overruns = dropped;
+        dropped = 0;
+        __atomic_store_n(&ring->head, (head + 1) % (2 * ring->blocks), __ATOMIC_SEQ_CST);
+        mraa_spi_ring_wake(ring);
+    }
+
+    /* The reader may wait for a block that won't come. */
+    __atomic_store_n(&ring->running, 0, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
+
+    return NULL;
+}
+
+mraa_spi_ring_context
+mraa_spi_ring_start(mraa_spi_context dev,
+                    const uint8_t* tx,
+                    unsigned int block_size,
+                    unsigned int blocks,
+                    unsigned int period_us,
+                    int priority)
+{
+    if (dev == NULL) {
+        syslog(LOG_ERR, "spi: ring_start: context is invalid");
+        return NULL;
+    }
+    if (block_size == 0 || block_size > SPI_MAX_LENGTH || blocks < 2 ||
+        blocks > MRAA_SPI_RING_MAX_BLOCKS) {
+        syslog(LOG_ERR, "spi%i: ring_start: invalid ring of %u blocks of %u bytes", dev->busnum,
+               blocks, block_size);
+        return NULL;
+    }
+
+    mraa_spi_ring_context ring = (mraa_spi_ring_context) calloc(1, sizeof(struct _spi_ring));
+    if (ring == NULL) {
+        syslog(LOG_CRIT, "spi%i: ring_start: Failed to allocate memory for context", dev->busnum);
+        return NULL;
+    }
+    ring->dev = dev;
+    ring->block_size = block_size;
+    ring->blocks = blocks;
+    ring->period_us = period_us;
+    ring->priority = priority;
+    ring->running = 1;
+    ring->status = MRAA_SUCCESS;
+    // One block more than the ring for the samples taken while it is full
+    ring->data = (uint8_t*) malloc((size_t) (blocks + 1) * block_size);
+    ring->info = (mraa_spi_block_info_t*) calloc(blocks, sizeof(mraa_spi_block_info_t));
+    ring->tx = (uint8_t*) calloc(block_size, 1);
+    if (ring->data == NULL || ring->info == NULL || ring->tx == NULL) {
+        syslog(LOG_CRIT, "spi%i: ring_start: Failed to allocate %u blocks", dev->busnum, blocks);
+        goto ring_start_cleanup;
+    }
+    if (tx != NULL) {
+        memcpy(ring->tx, tx, block_size);
+    }
+
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ring->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&ring->thread, NULL, mraa_spi_ring_thread, ring) != 0) {
+        syslog(LOG_ERR, "spi%i: ring_start: Failed to start the sampling thread", dev->busnum);
+        pthread_cond_destroy(&ring->cond);
+        pthread_mutex_destroy(&ring->lock);
+        goto ring_start_cleanup;
+    }
+    return ring;
+
+ring_start_cleanup:
+    free(ring->tx);
+    free(ring->info);
+    free(ring->data);
+    free(ring);
+    return NULL;
+}
+
+mraa_result_t
+mraa_spi_ring_read(mraa_spi_ring_context ring,
+                   uint8_t* data,
+                   mraa_spi_block_info_t* info,
+                   int timeout_ms)
+{
+    if (ring == NULL || data == NULL) {
+        syslog(LOG_ERR, "spi: ring_read: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    unsigned int tail = ring->tail;
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail && timeout_ms != 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        if (timeout_ms > 0) {
+            deadline.tv_sec += timeout_ms / 1000;
+            deadline.tv_nsec += (long) (timeout_ms % 1000) * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+        }
+
+        pthread_mutex_lock(&ring->lock);
+        __atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail &&
+               __atomic_load_n(&ring->running, __ATOMIC_SEQ_CST)) {
+            if (timeout_ms < 0) {
+                pthread_cond_wait(&ring->cond, &ring->lock);
+            } else if (pthread_cond_timedwait(&ring->cond, &ring->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        __atomic_store_n(&ring->waiting, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+        if (!__atomic_load_n(&ring->running, __ATOMIC_ACQUIRE) && ring->status != MRAA_SUCCESS) {
+            return ring->status;
+        }
+        return MRAA_ERROR_NO_DATA_AVAILABLE;
+    }
+
+    unsigned int slot = tail % ring->blocks;
+    memcpy(data, ring->data + (size_t) slot * ring->block_size, ring->block_size);
+    if (info != NULL) {
+        *info = ring->info[slot];
+    }
+    __atomic_store_n(&ring->tail, (tail + 1) % (2 * ring->blocks), __ATOMIC_RELEASE);
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t
+mraa_spi_ring_stop(mraa_spi_ring_context ring)
+{
+    if (ring == NULL) {
+        syslog(LOG_ERR, "spi: ring_stop: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    __atomic_store_n(&ring->running, 0, __ATOMIC_RELEASE);
+    pthread_join(ring->thread, NULL);
+
+    mraa_result_t ret = ring->status;
+    pthread_cond_destroy(&ring->cond);
+    pthread_mutex_destroy(&ring->lock);
+    free(ring->tx);
+    free(ring->info);
+    free(ring->data);
+    free(ring);
+
+    return ret;
+}
+
+mraa_result_t
+mraa_spi_ioctl_stats(mraa_spi_context dev, mraa_bus_ioctl_stats_t* stats)
+{
+    if (dev == NULL || stats == NULL) {
+        syslog(LOG_ERR, "spi: ioctl_stats: context is invalid");
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+
+    *stats = dev->ioctl_stats;
+    return MRAA_SUCCESS;
+}
+
 mraa_result_t
 mraa_spi_stop(mraa_spi_context dev)
 {
@@ -486,6 +1413,12 @@ mraa_spi_stop(mraa_spi_context dev)
         return MRAA_ERROR_INVALID_HANDLE;
     }
 
+    mraa_bus_arbiter_cancel(dev->arbiter, dev);
+    free(dev->rx_pool);
+    dev->rx_pool = NULL;
+    mraa_spi_kernel_put(dev->kernel);
+    dev->kernel = NULL;
+
     if (IS_FUNC_DEFINED(dev, spi_stop_replace)) {
         return dev->advance_func->spi_stop_replace(dev);
     }
@@ -166,6 +166,8 @@ mraa_uart_init_internal(mraa_adv_func_t* func_table)
 mraa_uart_context
 mraa_uart_init(int index)
 {
+    mraa_init();
+
     if (plat == NULL) {
         syslog(LOG_ERR, "uart%i: init: platform not initialised", index);
         return NULL;
@@ -247,6 +249,8 @@ mraa_uart_init(int index)
 mraa_uart_context
 mraa_uart_init_raw(const char* path)
 {
+    mraa_init();
+
     mraa_result_t status = MRAA_SUCCESS;
     mraa_uart_context dev = NULL;
 
@@ -354,6 +358,7 @@ mraa_uart_settings(int index, const char **devpath, const char **name, int* baud
     struct termios term;
     int fd;
 
+    mraa_init();
     if (plat == NULL) {
         return MRAA_ERROR_PLATFORM_NOT_INITIALISED;
     }
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Throughput of streamed SPI frames, e.g. a display refreshed with 300 KB
+ * frames, once from a prepared buffer and once rendered chunk by chunk while
+ * the previous chunk is sent:
+ *
+ *   mraa-bench-spi [-b bus] [-s frame_bytes] [-n frames] [-f hz]
+ *
+ * Reports MB/s and the frame rate each mode sustains.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mraa/spi.h"
+
+static uint64_t
+now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Stands in for rendering: a gradient that changes with every chunk. */
+static mraa_result_t
+render(void* args, uint8_t* chunk, size_t offset, size_t length)
+{
+    (void) args;
+    for (size_t i = 0; i < length; i++) {
+        chunk[i] = (uint8_t) (offset + i);
+    }
+    return MRAA_SUCCESS;
+}
+
+static void
+report(const char* name, size_t frame, int frames, uint64_t elapsed)
+{
+    double seconds = (double) elapsed / 1e9;
+    printf("%-9s %8.2f MB/s  %7.1f frames/s\n", name, (double) frame * frames / seconds / 1e6,
+           frames / seconds);
+}
+
+int
+main(int argc, char** argv)
+{
+    int bus = 0;
+    size_t frame = 300 * 1024;
+    int frames = 30;
+    int hz = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:s:n:f:")) != -1) {
+        switch (opt) {
+            case 'b':
+                bus = atoi(optarg);
+                break;
+            case 's':
+                frame = (size_t) atol(optarg);
+                break;
+            case 'n':
+                frames = atoi(optarg);
+                break;
+            case 'f':
+                hz = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-b bus] [-s frame_bytes] [-n frames] [-f hz]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (frame == 0 || frames <= 0) {
+        fprintf(stderr, "usage: %s [-b bus] [-s frame_bytes] [-n frames] [-f hz]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    mraa_spi_context spi = mraa_spi_init(bus);
+    if (spi == NULL) {
+        fprintf(stderr, "failed to open spi bus %d\n", bus);
+        return EXIT_FAILURE;
+    }
+    if (hz > 0 && mraa_spi_frequency(spi, hz) != MRAA_SUCCESS) {
+        fprintf(stderr, "failed to set the clock to %d Hz\n", hz);
+        mraa_spi_stop(spi);
+        return EXIT_FAILURE;
+    }
+
+    uint8_t* buf = (uint8_t*) malloc(frame);
+    if (buf == NULL) {
+        perror("malloc");
+        mraa_spi_stop(spi);
+        return EXIT_FAILURE;
+    }
+
+    int ret = EXIT_SUCCESS;
+    uint64_t start = now_ns();
+    for (int i = 0; i < frames && ret == EXIT_SUCCESS; i++) {
+        render(NULL, buf, 0, frame);
+        if (mraa_spi_transfer_stream(spi, buf, NULL, frame, 1) != MRAA_SUCCESS) {
+            fprintf(stderr, "buffered: frame %d failed\n", i);
+            ret = EXIT_FAILURE;
+        }
+    }
+    if (ret == EXIT_SUCCESS) {
+        report("buffered", frame, frames, now_ns() - start);
+    }
+
+    start = now_ns();
+    for (int i = 0; i < frames && ret == EXIT_SUCCESS; i++) {
+        if (mraa_spi_write_stream(spi, frame, render, NULL, 1) != MRAA_SUCCESS) {
+            fprintf(stderr, "streamed: frame %d failed\n", i);
+            ret = EXIT_FAILURE;
+        }
+    }
+    if (ret == EXIT_SUCCESS) {
+        report("streamed", frame, frames, now_ns() - start);
+    }
+
+    free(buf);
+    mraa_spi_stop(spi);
+    return ret;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Measures what loading libmraa costs a process, with the automatic init and
+ * with MRAA_NO_AUTO_INIT set. Every sample runs in a fresh child process so
+ * the library constructor runs each time:
+ *
+ *   mraa-bench-startup [-n samples] [-m max_us]
+ *
+ * With -m the run fails when the mean cost of load + mraa_init() exceeds
+ * max_us in either mode.
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef int (*mraa_init_fn)();
+
+static uint64_t
+now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Child side: time dlopen() (constructor included), then the first mraa_init(). */
+static void
+sample(int fd)
+{
+    uint64_t t[2];
+    uint64_t start = now_ns();
+
+    void* lib = dlopen(MRAA_LIBRARY_PATH, RTLD_NOW);
+    t[0] = now_ns() - start;
+    if (lib == NULL) {
+        _exit(EXIT_FAILURE);
+    }
+
+    mraa_init_fn init = (mraa_init_fn) dlsym(lib, "mraa_init");
+    if (init == NULL) {
+        _exit(EXIT_FAILURE);
+    }
+    start = now_ns();
+    init();
+    t[1] = now_ns() - start;
+
+    if (write(fd, t, sizeof(t)) != sizeof(t)) {
+        _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+static int
+run(const char* name, int lazy, int samples, double max_us)
+{
+    uint64_t load = 0, init = 0;
+    int fds[2];
+
+    if (lazy) {
+        setenv("MRAA_NO_AUTO_INIT", "1", 1);
+    } else {
+        unsetenv("MRAA_NO_AUTO_INIT");
+    }
+
+    for (int i = 0; i < samples; i++) {
+        uint64_t t[2];
+        int status;
+
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return -1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return -1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            sample(fds[1]);
+        }
+        close(fds[1]);
+        ssize_t rb = read(fds[0], t, sizeof(t));
+        close(fds[0]);
+        waitpid(pid, &status, 0);
+        if (rb != sizeof(t) || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            fprintf(stderr, "%s: failed to load %s\n", name, MRAA_LIBRARY_PATH);
+            return -1;
+        }
+        load += t[0];
+        init += t[1];
+    }
+
+    double load_us = (double) load / samples / 1000.0;
+    double init_us = (double) init / samples / 1000.0;
+    printf("%-6s load %10.1f us  first mraa_init() %10.1f us\n", name, load_us, init_us);
+
+    if (max_us > 0 && load_us + init_us > max_us) {
+        fprintf(stderr, "%s: %.1f us is over the %.1f us budget\n", name, load_us + init_us, max_us);
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+    int samples = 20;
+    double max_us = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:m:")) != -1) {
+        switch (opt) {
+            case 'n':
+                samples = atoi(optarg);
+                break;
+            case 'm':
+                max_us = atof(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-m max_us]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (samples <= 0) {
+        fprintf(stderr, "usage: %s [-n samples] [-m max_us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int ret = run("auto", 0, samples, max_us);
+    if (ret >= 0) {
+        ret |= run("lazy", 1, samples, max_us);
+    }
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Measures the cost of the sysfs hot paths (gpio read/write, aio read and
+ * pwm write) in nanoseconds and in file syscalls per call. The open, close,
+ * read, write and seek calls made by libmraa are interposed, counted and
+ * passed on to libc, so run it on a board where the requested pins are backed
+ * by sysfs:
+ *
+ *   mraa-bench-sysfs [-g gpio] [-a aio] [-p pwm] [-n iterations]
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mraa/aio.h"
+#include "mraa/gpio.h"
+#include "mraa/pwm.h"
+
+static unsigned long syscalls = 0;
+
+/*
+ * Every wrapper counts the call and forwards it to the next definition, libc,
+ * so the off_t and 64-bit variants keep their own ABI on 32-bit hosts.
+ */
+#define NEXT(name)                                                                                 \
+    static __typeof__(&name) next_##name = NULL;                                                   \
+    if (next_##name == NULL) {                                                                     \
+        next_##name = (__typeof__(&name)) dlsym(RTLD_NEXT, #name);                                 \
+    }                                                                                              \
+    syscalls++
+
+/* open(2) only carries a mode when a file may be created. */
+#define OPEN_MODE(flags, mode)                                                                     \
+    if ((flags) & (O_CREAT | O_TMPFILE)) {                                                         \
+        va_list ap;                                                                                \
+        va_start(ap, flags);                                                                       \
+        mode = va_arg(ap, mode_t);                                                                 \
+        va_end(ap);                                                                                \
+    }
+
+int
+open(const char* path, int flags, ...)
+{
+    mode_t mode = 0;
+    OPEN_MODE(flags, mode);
+    NEXT(open);
+    return next_open(path, flags, mode);
+}
+
+int
+open64(const char* path, int flags, ...)
+{
+    mode_t mode = 0;
+    OPEN_MODE(flags, mode);
+    NEXT(open64);
+    return next_open64(path, flags, mode);
+}
+
+int
+openat(int dirfd, const char* path, int flags, ...)
+{
+    mode_t mode = 0;
+    OPEN_MODE(flags, mode);
+    NEXT(openat);
+    return next_openat(dirfd, path, flags, mode);
+}
+
+int
+openat64(int dirfd, const char* path, int flags, ...)
+{
+    mode_t mode = 0;
+    OPEN_MODE(flags, mode);
+    NEXT(openat64);
+    return next_openat64(dirfd, path, flags, mode);
+}
+
+int
+close(int fd)
+{
+    NEXT(close);
+    return next_close(fd);
+}
+
+ssize_t
+read(int fd, void* buf, size_t count)
+{
+    NEXT(read);
+    return next_read(fd, buf, count);
+}
+
+ssize_t
+write(int fd, const void* buf, size_t count)
+{
+    NEXT(write);
+    return next_write(fd, buf, count);
+}
+
+ssize_t
+pread(int fd, void* buf, size_t count, off_t offset)
+{
+    NEXT(pread);
+    return next_pread(fd, buf, count, offset);
+}
+
+ssize_t
+pread64(int fd, void* buf, size_t count, off64_t offset)
+{
+    NEXT(pread64);
+    return next_pread64(fd, buf, count, offset);
+}
+
+ssize_t
+pwrite(int fd, const void* buf, size_t count, off_t offset)
+{
+    NEXT(pwrite);
+    return next_pwrite(fd, buf, count, offset);
+}
+
+ssize_t
+pwrite64(int fd, const void* buf, size_t count, off64_t offset)
+{
+    NEXT(pwrite64);
+    return next_pwrite64(fd, buf, count, offset);
+}
+
+off_t
+lseek(int fd, off_t offset, int whence)
+{
+    NEXT(lseek);
+    return next_lseek(fd, offset, whence);
+}
+
+off64_t
+lseek64(int fd, off64_t offset, int whence)
+{
+    NEXT(lseek64);
+    return next_lseek64(fd, offset, whence);
+}
+
+static unsigned long long
+now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void
+report(const char* name, unsigned long long start, unsigned long calls, int iterations)
+{
+    unsigned long long elapsed = now_ns() - start;
+    printf("%-12s %10.1f ns/call %6.2f syscalls/call\n", name, (double) elapsed / iterations,
+           (double) (syscalls - calls) / iterations);
+}
+
+int
+main(int argc, char** argv)
+{
+    int gpio = -1, aio = -1, pwm = -1, iterations = 100000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:a:p:n:")) != -1) {
+        switch (opt) {
+            case 'g':
+                gpio = atoi(optarg);
+                break;
+            case 'a':
+                aio = atoi(optarg);
+                break;
+            case 'p':
+                pwm = atoi(optarg);
+                break;
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-g gpio] [-a aio] [-p pwm] [-n iterations]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (iterations <= 0 || (gpio < 0 && aio < 0 && pwm < 0)) {
+        fprintf(stderr, "usage: %s [-g gpio] [-a aio] [-p pwm] [-n iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (gpio >= 0) {
+        mraa_gpio_context dev = mraa_gpio_init(gpio);
+        if (dev == NULL || mraa_gpio_dir(dev, MRAA_GPIO_OUT) != MRAA_SUCCESS) {
+            fprintf(stderr, "failed to set up gpio %d\n", gpio);
+            return EXIT_FAILURE;
+        }
+        /* Warm up, the value fd is opened on first access. */
+        mraa_gpio_write(dev, 0);
+
+        unsigned long calls = syscalls;
+        unsigned long long start = now_ns();
+        for (int i = 0; i < iterations; i++) {
+            mraa_gpio_write(dev, i & 1);
+        }
+        report("gpio write", start, calls, iterations);
+
+        calls = syscalls;
+        start = now_ns();
+        for (int i = 0; i < iterations; i++) {
+            mraa_gpio_read(dev);
+        }
+        report("gpio read", start, calls, iterations);
+        mraa_gpio_close(dev);
+    }
+
+    if (aio >= 0) {
+        mraa_aio_context dev = mraa_aio_init(aio);
+        if (dev == NULL) {
+            fprintf(stderr, "failed to set up aio %d\n", aio);
+            return EXIT_FAILURE;
+        }
+        mraa_aio_read(dev);
+
+        unsigned long calls = syscalls;
+        unsigned long long start = now_ns();
+        for (int i = 0; i < iterations; i++) {
+            mraa_aio_read(dev);
+        }
+        report("aio read", start, calls, iterations);
+        mraa_aio_close(dev);
+    }
+
+    if (pwm >= 0) {
+        mraa_pwm_context dev = mraa_pwm_init(pwm);
+        if (dev == NULL) {
+            fprintf(stderr, "failed to set up pwm %d\n", pwm);
+            return EXIT_FAILURE;
+        }
+        mraa_pwm_write(dev, 0.0f);
+
+        unsigned long calls = syscalls;
+        unsigned long long start = now_ns();
+        for (int i = 0; i < iterations; i++) {
+            mraa_pwm_write(dev, (i & 1) ? 0.25f : 0.75f);
+        }
+        report("pwm write", start, calls, iterations);
+        mraa_pwm_close(dev);
+    }
+
+    return EXIT_SUCCESS;
+}
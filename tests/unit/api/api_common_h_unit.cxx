@@ -91,6 +91,11 @@ TEST_F(api_common_h_unit, test_libmraa_common_methods)
 
         /* Test the lookup method/s */
         ASSERT_EQ(0, mraa_gpio_lookup("GPIO0"));
+        EXPECT_EQ(-1, mraa_gpio_lookup("ADC0"));
+        EXPECT_EQ(-1, mraa_gpio_lookup("GPIO"));
+        EXPECT_EQ(-1, mraa_gpio_lookup(""));
+        EXPECT_EQ(-1, mraa_gpio_lookup(NULL));
+        EXPECT_EQ(-1, mraa_i2c_lookup("I2C0SDA"));
 
         /* MOCK does NOT have a subplatform */
         ASSERT_FALSE(mraa_has_sub_platform());
@@ -0,0 +1,827 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "mraa/gpio.h"
+#include "gpio/gpio_chardev.h"
+#include "gpio/gpio_dispatch.h"
+#include "linux/gpio.h"
+#include "gtest/gtest.h"
+#include <condition_variable>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+/* MRAA GPIO test fixture */
+class mraa_gpio_h_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        dev = mraa_gpio_init(0);
+        ASSERT_TRUE(dev != NULL);
+    }
+
+    void
+    TearDown()
+    {
+        mraa_gpio_close(dev);
+    }
+
+    mraa_gpio_context dev;
+};
+
+/* Event queue calls on a NULL context. */
+TEST_F(mraa_gpio_h_unit, test_event_queue_invalid_context)
+{
+    mraa_gpio_edge_event events[4];
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_gpio_event_queue_init(NULL, 4));
+    ASSERT_EQ(-1, mraa_gpio_event_queue_pop(NULL, events, 4));
+    ASSERT_EQ(0UL, mraa_gpio_event_queue_dropped(NULL));
+}
+
+/* A zero sized queue is rejected, popping without a queue fails. */
+TEST_F(mraa_gpio_h_unit, test_event_queue_invalid_size)
+{
+    mraa_gpio_edge_event events[4];
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_event_queue_init(dev, 0));
+    ASSERT_EQ(-1, mraa_gpio_event_queue_pop(dev, events, 4));
+}
+
+/* A fresh queue is empty and has not dropped anything. */
+TEST_F(mraa_gpio_h_unit, test_event_queue_empty)
+{
+    mraa_gpio_edge_event events[4];
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_event_queue_init(dev, 4));
+    ASSERT_EQ(0, mraa_gpio_event_queue_pop(dev, events, 4));
+    ASSERT_EQ(0UL, mraa_gpio_event_queue_dropped(dev));
+
+    /* Re-initializing replaces the queue. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_event_queue_init(dev, 16));
+    ASSERT_EQ(0, mraa_gpio_event_queue_pop(dev, events, 4));
+}
+
+/* The shared isr threads can be started, resized and stopped when unused. */
+TEST_F(mraa_gpio_h_unit, test_isr_dispatcher)
+{
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_use_isr_dispatcher(1000));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_isr_dispatcher(2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_isr_dispatcher(1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_isr_dispatcher(0));
+}
+
+/* Event fds and non-blocking reads need a valid context and buffer. */
+TEST_F(mraa_gpio_h_unit, test_event_fds_invalid)
+{
+    int fds[4];
+    mraa_gpio_edge_event events[4];
+    ASSERT_EQ(-1, mraa_gpio_get_event_fds(NULL, fds, 4, NULL));
+    ASSERT_EQ(-1, mraa_gpio_get_event_fds(dev, NULL, 4, NULL));
+    ASSERT_EQ(-1, mraa_gpio_get_event_fds(dev, fds, 0, NULL));
+    ASSERT_EQ(-1, mraa_gpio_read_events(NULL, events, 4));
+    ASSERT_EQ(-1, mraa_gpio_read_events(dev, NULL, 4));
+}
+
+/* The gpiochip cache can be dropped and rebuilt at any time. */
+TEST_F(mraa_gpio_h_unit, test_chip_cache)
+{
+    mraa_result_t first = mraa_gpio_refresh_chip_cache();
+    ASSERT_TRUE(first == MRAA_SUCCESS || first == MRAA_ERROR_NO_DATA_AVAILABLE);
+    mraa_gpio_invalidate_chip_cache();
+    ASSERT_EQ(first, mraa_gpio_refresh_chip_cache());
+    mraa_gpio_invalidate_chip_cache();
+    mraa_gpio_invalidate_chip_cache();
+}
+
+/*
+ * Kernel events decoded the way the isr threads do, from a pipe standing in
+ * for a line request fd: queued oldest first with their kernel timestamps,
+ * events the kernel lost and events past the queue size are counted.
+ */
+TEST_F(mraa_gpio_h_unit, test_event_queue_order_overflow)
+{
+    struct gpio_v2_line_event kernel[6];
+    unsigned int line_seqnos[6] = { 1, 2, 3, 5, 6, 7 };
+    mraa_gpio_edge_event events[8];
+    unsigned int line_seqno = 0;
+    int fds[2];
+
+    memset(kernel, 0, sizeof(kernel));
+    for (int i = 0; i < 6; ++i) {
+        kernel[i].timestamp_ns = 1000 * (i + 1);
+        kernel[i].id = (i % 2) ? GPIO_V2_LINE_EVENT_FALLING_EDGE : GPIO_V2_LINE_EVENT_RISING_EDGE;
+        kernel[i].line_seqno = line_seqnos[i];
+    }
+    ASSERT_EQ(0, pipe(fds));
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ASSERT_EQ((ssize_t) sizeof(kernel), write(fds[1], kernel, sizeof(kernel)));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_event_queue_init(dev, 4));
+    mraa_gpio_chardev_read_events(dev, NULL, fds[0], 0, 7, &line_seqno, 1);
+    close(fds[0]);
+    close(fds[1]);
+
+    /* Events 1-3, then 5 after one lost in the kernel; 6 and 7 overflow the queue. */
+    ASSERT_EQ(4, mraa_gpio_event_queue_pop(dev, events, 8));
+    unsigned long seqnos[4] = { 1, 2, 3, 5 };
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(7, events[i].pin);
+        ASSERT_EQ((i % 2) ? MRAA_GPIO_EDGE_FALLING : MRAA_GPIO_EDGE_RISING, events[i].edge);
+        ASSERT_EQ((mraa_timestamp_t) 1000 * (i + 1), events[i].timestamp);
+        ASSERT_EQ(seqnos[i], (unsigned long) events[i].seqno);
+    }
+    ASSERT_EQ(3UL, mraa_gpio_event_queue_dropped(dev));
+    ASSERT_EQ(0, mraa_gpio_event_queue_pop(dev, events, 8));
+}
+
+/*
+ * Fake sysfs gpio files. open(), close() and pread() made by libmraa resolve
+ * to the definitions below and pass everything else on to libc. A "value"
+ * file is one end of a unix socket pair: an out-of-band byte sent by the peer
+ * raises POLLPRI the way the kernel signals an edge, and pread() consumes it,
+ * re-arming the file, and returns the level of the gpio. "edge" files go to
+ * /dev/null.
+ */
+struct sysfs_value {
+    int gpio;
+    int peer;
+    unsigned int reads;
+};
+
+static std::mutex sysfs_lock;
+static std::condition_variable sysfs_cond;
+static bool sysfs_fake = false;
+static std::map<int, sysfs_value> sysfs_values;
+static std::map<int, char> sysfs_levels;
+
+/* Set the level of a gpio and signal the edge on its open value files. */
+static void
+sysfs_edge(int gpio, char level)
+{
+    std::lock_guard<std::mutex> lock(sysfs_lock);
+    sysfs_levels[gpio] = level;
+    for (auto& it : sysfs_values) {
+        if (it.second.gpio == gpio) {
+            send(it.second.peer, &level, 1, MSG_OOB);
+        }
+    }
+}
+
+/* Wait until a value file of gpio was opened and read reads times. */
+static bool
+sysfs_wait_reads(int gpio, unsigned int reads)
+{
+    std::unique_lock<std::mutex> lock(sysfs_lock);
+    return sysfs_cond.wait_for(lock, std::chrono::seconds(10), [&] {
+        for (auto& it : sysfs_values) {
+            if (it.second.gpio == gpio && it.second.reads >= reads) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+extern "C" int
+open(const char* path, int flags, ...)
+{
+    static int (*next)(const char*, int, ...) = (int (*)(const char*, int, ...)) dlsym(RTLD_NEXT, "open");
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    int gpio;
+    char file[8];
+    std::lock_guard<std::mutex> lock(sysfs_lock);
+    if (!sysfs_fake || sscanf(path, "/sys/class/gpio/gpio%d/%7s", &gpio, file) != 2) {
+        return next(path, flags, mode);
+    }
+    if (strcmp(file, "edge") == 0) {
+        return next("/dev/null", O_RDWR);
+    }
+    int sv[2];
+    if (strcmp(file, "value") != 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    fcntl(sv[0], F_SETFL, O_NONBLOCK);
+    sysfs_values[sv[0]] = { gpio, sv[1], 0 };
+    sysfs_cond.notify_all();
+    return sv[0];
+}
+
+extern "C" int
+close(int fd)
+{
+    static int (*next)(int) = (int (*)(int)) dlsym(RTLD_NEXT, "close");
+    {
+        std::lock_guard<std::mutex> lock(sysfs_lock);
+        auto it = sysfs_values.find(fd);
+        if (it != sysfs_values.end()) {
+            next(it->second.peer);
+            sysfs_values.erase(it);
+        }
+    }
+    return next(fd);
+}
+
+static ssize_t
+sysfs_pread(int fd, void* buf, size_t count, bool* served)
+{
+    std::lock_guard<std::mutex> lock(sysfs_lock);
+    auto it = sysfs_values.find(fd);
+    *served = it != sysfs_values.end();
+    if (!*served || count == 0) {
+        return 0;
+    }
+    char c;
+    recv(fd, &c, 1, MSG_OOB);
+    it->second.reads++;
+    sysfs_cond.notify_all();
+    auto level = sysfs_levels.find(it->second.gpio);
+    *(char*) buf = level != sysfs_levels.end() ? level->second : '0';
+    return 1;
+}
+
+extern "C" ssize_t
+pread(int fd, void* buf, size_t count, off_t offset)
+{
+    static ssize_t (*next)(int, void*, size_t, off_t) =
+    (ssize_t(*)(int, void*, size_t, off_t)) dlsym(RTLD_NEXT, "pread");
+    bool served;
+    ssize_t ret = sysfs_pread(fd, buf, count, &served);
+    return served ? ret : next(fd, buf, count, offset);
+}
+
+extern "C" ssize_t
+pread64(int fd, void* buf, size_t count, off64_t offset)
+{
+    static ssize_t (*next)(int, void*, size_t, off64_t) =
+    (ssize_t(*)(int, void*, size_t, off64_t)) dlsym(RTLD_NEXT, "pread64");
+    bool served;
+    ssize_t ret = sysfs_pread(fd, buf, count, &served);
+    return served ? ret : next(fd, buf, count, offset);
+}
+
+/*
+ * Contexts of the mock board going through the sysfs edge and isr code, with
+ * a sub platform whose pin 3 (mraa pin 515) is gpio 3
+ */
+class mraa_gpio_h_sysfs_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_init());
+        saved = plat->adv_func;
+        funcs = *saved;
+        funcs.gpio_edge_mode_replace = NULL;
+        funcs.gpio_isr_replace = NULL;
+        funcs.gpio_isr_exit_replace = NULL;
+        funcs.gpio_interrupt_handler_init_replace = NULL;
+        funcs.gpio_wait_interrupt_replace = NULL;
+        plat->adv_func = &funcs;
+
+        memset(&sub, 0, sizeof(sub));
+        memset(sub_pins, 0, sizeof(sub_pins));
+        sub_pins[3].capabilities.valid = 1;
+        sub_pins[3].capabilities.gpio = 1;
+        sub_pins[3].gpio.pinmap = 3;
+        sub.platform_name = (char*) "fake sub platform";
+        sub.phy_pin_count = 4;
+        sub.gpio_count = 1;
+        sub.pins = sub_pins;
+        sub.adv_func = &funcs;
+        saved_sub = plat->sub_platform;
+        plat->sub_platform = &sub;
+
+        std::lock_guard<std::mutex> lock(sysfs_lock);
+        sysfs_fake = true;
+        sysfs_levels.clear();
+    }
+
+    void
+    TearDown()
+    {
+        plat->sub_platform = saved_sub;
+        plat->adv_func = saved;
+
+        /* A failed test may leave value files open, the next one starts without them. */
+        std::vector<int> fds;
+        {
+            std::lock_guard<std::mutex> lock(sysfs_lock);
+            for (auto& it : sysfs_values) {
+                fds.push_back(it.first);
+            }
+        }
+        for (int fd : fds) {
+            close(fd);
+        }
+        std::lock_guard<std::mutex> lock(sysfs_lock);
+        sysfs_fake = false;
+    }
+
+    mraa_adv_func_t* saved;
+    mraa_adv_func_t funcs;
+    mraa_board_t* saved_sub;
+    mraa_board_t sub;
+    mraa_pininfo_t sub_pins[4];
+};
+
+/* Non-blocking reads report pins as given to the init function, sub platform and raw ones included. */
+TEST_F(mraa_gpio_h_sysfs_unit, test_read_events_pin)
+{
+    int fds[1];
+    short poll_events = 0;
+    mraa_gpio_edge_event events[2];
+
+    mraa_gpio_context sub_dev = mraa_gpio_init(mraa_get_sub_platform_id(3));
+    ASSERT_TRUE(sub_dev != NULL);
+    mraa_gpio_context raw = mraa_gpio_init_raw(40);
+    ASSERT_TRUE(raw != NULL);
+    ASSERT_EQ(1, mraa_gpio_get_event_fds(sub_dev, fds, 1, &poll_events));
+    ASSERT_EQ(POLLPRI, poll_events);
+    ASSERT_EQ(1, mraa_gpio_get_event_fds(raw, fds, 1, NULL));
+
+    sysfs_edge(3, '1');
+    sysfs_edge(40, '0');
+    ASSERT_EQ(1, mraa_gpio_read_events(sub_dev, events, 2));
+    ASSERT_EQ(mraa_get_sub_platform_id(3), events[0].pin);
+    ASSERT_EQ(MRAA_GPIO_EDGE_RISING, events[0].edge);
+    ASSERT_EQ(1, mraa_gpio_read_events(raw, events, 2));
+    ASSERT_EQ(40, events[0].pin);
+    ASSERT_EQ(MRAA_GPIO_EDGE_FALLING, events[0].edge);
+
+    /* Reading re-armed the files. */
+    ASSERT_EQ(0, mraa_gpio_read_events(sub_dev, events, 2));
+    ASSERT_EQ(0, mraa_gpio_read_events(raw, events, 2));
+
+    /* The value files go with the contexts even without an isr. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(sub_dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(raw));
+    std::lock_guard<std::mutex> lock(sysfs_lock);
+    ASSERT_TRUE(sysfs_values.empty());
+}
+
+/* Callbacks counted under a lock, waited for without sleeping. */
+struct isr_count {
+    std::mutex lock;
+    std::condition_variable cond;
+    int calls = 0;
+};
+
+static void
+count_isr(void* args)
+{
+    isr_count* count = (isr_count*) args;
+    std::lock_guard<std::mutex> lock(count->lock);
+    count->calls++;
+    count->cond.notify_all();
+}
+
+static bool
+wait_isr(isr_count* count, int calls)
+{
+    std::unique_lock<std::mutex> lock(count->lock);
+    return count->cond.wait_for(lock, std::chrono::seconds(10), [&] { return count->calls >= calls; });
+}
+
+/* The isr thread queues edges under the pin given to the init function. */
+TEST_F(mraa_gpio_h_sysfs_unit, test_isr_queue_pin)
+{
+    mraa_gpio_edge_event events[4];
+    isr_count count;
+
+    mraa_gpio_context sub_dev = mraa_gpio_init(mraa_get_sub_platform_id(3));
+    ASSERT_TRUE(sub_dev != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_event_queue_init(sub_dev, 4));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_isr(sub_dev, MRAA_GPIO_EDGE_BOTH, &count_isr, &count));
+
+    /* The thread clears the value file once before it polls. */
+    ASSERT_TRUE(sysfs_wait_reads(3, 1));
+    sysfs_edge(3, '1');
+    ASSERT_TRUE(wait_isr(&count, 1));
+
+    ASSERT_EQ(1, mraa_gpio_event_queue_pop(sub_dev, events, 4));
+    ASSERT_EQ(mraa_get_sub_platform_id(3), events[0].pin);
+    ASSERT_EQ(MRAA_GPIO_EDGE_RISING, events[0].edge);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_isr_exit(sub_dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(sub_dev));
+}
+
+
+/* A context registered with the shared thread gets its callback and keeps the thread alive. */
+TEST_F(mraa_gpio_h_sysfs_unit, test_isr_dispatcher_register)
+{
+    mraa_gpio_edge_event events[4];
+    isr_count count;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_isr_dispatcher(1));
+    mraa_gpio_context raw = mraa_gpio_init_raw(40);
+    ASSERT_TRUE(raw != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_isr(raw, MRAA_GPIO_EDGE_BOTH, &count_isr, &count));
+
+    /* The value file is polled as soon as the context is registered. */
+    sysfs_edge(40, '1');
+    ASSERT_TRUE(wait_isr(&count, 1));
+    ASSERT_EQ(MRAA_ERROR_NO_RESOURCES, mraa_gpio_use_isr_dispatcher(0));
+    ASSERT_TRUE(mraa_gpio_dispatch_enabled());
+
+    /* Unregistering waits for a running callback, nothing fires after it. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_isr_exit(raw));
+    {
+        std::lock_guard<std::mutex> lock(count.lock);
+        ASSERT_EQ(1, count.calls);
+    }
+    ASSERT_EQ(1, mraa_gpio_event_queue_pop(raw, events, 4));
+    ASSERT_EQ(40, events[0].pin);
+    ASSERT_EQ(MRAA_GPIO_EDGE_RISING, events[0].edge);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_isr_dispatcher(0));
+    ASSERT_FALSE(mraa_gpio_dispatch_enabled());
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(raw));
+}
+
+/*
+ * Generic mmap backend over a temp file standing in for the memory device:
+ * 32 gpios per bank from gpio 100, banks 4 bytes apart, bcm283x offsets
+ */
+class mraa_gpio_h_mmap_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_init());
+        char path[] = "/tmp/mraa_gpio_mmap_XXXXXX";
+        fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        unlink_path = path;
+        ASSERT_EQ(0, ftruncate(fd, 0x100));
+
+        memset(&desc, 0, sizeof(desc));
+        strncpy(desc.mem_dev, path, sizeof(desc.mem_dev) - 1);
+        desc.base = 0;
+        desc.size = 0x100;
+        desc.gpio_base = 100;
+        desc.set_reg = 0x1C;
+        desc.clear_reg = 0x28;
+        desc.data_reg = 0x34;
+        desc.bank_stride = 4;
+        desc.bank_width = 32;
+
+        saved = plat->adv_func;
+        funcs = *saved;
+        funcs.gpio_read_replace = NULL;
+        funcs.gpio_write_replace = NULL;
+        funcs.gpio_mmap_setup = NULL;
+        plat->adv_func = &funcs;
+        saved_mmap = plat->gpio_mmap;
+        plat->gpio_mmap = &desc;
+    }
+
+    void
+    TearDown()
+    {
+        plat->gpio_mmap = saved_mmap;
+        plat->adv_func = saved;
+        close(fd);
+        unlink(unlink_path.c_str());
+    }
+
+    uint32_t
+    reg(unsigned int offset)
+    {
+        uint32_t value = 0;
+        EXPECT_EQ((ssize_t) sizeof(value), pread(fd, &value, sizeof(value), offset));
+        return value;
+    }
+
+    int fd;
+    std::string unlink_path;
+    mraa_gpio_mmap_desc_t desc;
+    mraa_gpio_mmap_desc_t* saved_mmap;
+    mraa_adv_func_t* saved;
+    mraa_adv_func_t funcs;
+};
+
+/* Writes hit the set and clear registers of the pin's bank, reads its data register. */
+TEST_F(mraa_gpio_h_mmap_unit, test_registers)
+{
+    mraa_gpio_context bank0 = mraa_gpio_init_raw(105);
+    mraa_gpio_context bank1 = mraa_gpio_init_raw(140);
+    ASSERT_TRUE(bank0 != NULL && bank1 != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_mmaped_internal(bank0, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_mmaped_internal(bank1, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_use_mmaped_internal(bank0, 1));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write(bank0, 1));
+    ASSERT_EQ(1U << 5, reg(0x1C));
+    ASSERT_EQ(0U, reg(0x28));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write(bank1, 0));
+    ASSERT_EQ(1U << 8, reg(0x28 + 4));
+    ASSERT_EQ(0U, reg(0x1C + 4));
+
+    uint32_t level = 1U << 8;
+    ASSERT_EQ((ssize_t) sizeof(level), pwrite(fd, &level, sizeof(level), 0x34 + 4));
+    ASSERT_EQ(1, mraa_gpio_read(bank1));
+    ASSERT_EQ(0, mraa_gpio_read(bank0));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_use_mmaped_internal(bank0, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_use_mmaped_internal(bank0, 0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(bank0));
+    /* Closing drops the last reference on the mapping. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(bank1));
+}
+
+/* Pins below the controller or past the mapped size and unusable layouts are rejected. */
+TEST_F(mraa_gpio_h_mmap_unit, test_invalid)
+{
+    mraa_gpio_context below = mraa_gpio_init_raw(99);
+    mraa_gpio_context past = mraa_gpio_init_raw(100 + 32 * 60);
+    mraa_gpio_context dev = mraa_gpio_init_raw(100);
+    ASSERT_TRUE(below != NULL && past != NULL && dev != NULL);
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_gpio_use_mmaped_internal(NULL, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_use_mmaped_internal(below, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_use_mmaped_internal(past, 1));
+
+    /* The data register of bank 0 ends past the mapping. */
+    desc.size = 0x34;
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_use_mmaped_internal(dev, 1));
+    desc.size = 0x100;
+
+    desc.bank_width = 0;
+    ASSERT_EQ(MRAA_ERROR_FEATURE_NOT_IMPLEMENTED, mraa_gpio_use_mmaped_internal(dev, 1));
+    desc.bank_width = 33;
+    ASSERT_EQ(MRAA_ERROR_FEATURE_NOT_IMPLEMENTED, mraa_gpio_use_mmaped_internal(dev, 1));
+    desc.bank_width = 32;
+
+    /* A memory device which can't be opened. */
+    strcpy(desc.mem_dev, "/nonexistent/gpiomem");
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_gpio_use_mmaped_internal(dev, 1));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(below));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(past));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_close(dev));
+}
+
+/*
+ * Fake gpiochip and line handle fds: the ioctls made on them are recorded,
+ * reading v1 line values returns chardev_levels
+ */
+struct chardev_call {
+    int fd;
+    unsigned long request;
+    uint64_t mask;
+    uint64_t bits;
+    unsigned char values[GPIOHANDLES_MAX];
+};
+
+static std::mutex chardev_lock;
+static std::vector<int> chardev_fds;
+static std::vector<chardev_call> chardev_calls;
+static unsigned char chardev_levels[GPIOHANDLES_MAX];
+
+static bool
+chardev_fd(int fd)
+{
+    for (int it : chardev_fds) {
+        if (it == fd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+extern "C" int
+ioctl(int fd, unsigned long request, ...) noexcept
+{
+    static int (*next)(int, unsigned long, ...) = (int (*)(int, unsigned long, ...)) dlsym(RTLD_NEXT, "ioctl");
+    va_list ap;
+    va_start(ap, request);
+    void* arg = va_arg(ap, void*);
+    va_end(ap);
+
+    std::lock_guard<std::mutex> lock(chardev_lock);
+    if (!chardev_fd(fd)) {
+        return next(fd, request, arg);
+    }
+
+    chardev_call call;
+    memset(&call, 0, sizeof(call));
+    call.fd = fd;
+    call.request = request;
+    if (request == GPIO_V2_GET_LINEINFO_IOCTL) {
+        /* A kernel without the v2 ABI. */
+        errno = ENOTTY;
+        return -1;
+    } else if (request == GPIO_V2_GET_LINE_IOCTL) {
+        struct gpio_v2_line_request* req = (struct gpio_v2_line_request*) arg;
+        call.mask = req->config.attrs[0].mask;
+        call.bits = req->config.attrs[0].attr.values;
+        req->fd = chardev_fds.back();
+    } else if (request == GPIO_GET_LINEHANDLE_IOCTL) {
+        struct gpiohandle_request* req = (struct gpiohandle_request*) arg;
+        memcpy(call.values, req->default_values, sizeof(call.values));
+        req->fd = chardev_fds.back();
+    } else if (request == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+        struct gpio_v2_line_values* vals = (struct gpio_v2_line_values*) arg;
+        call.mask = vals->mask;
+        call.bits = vals->bits;
+    } else if (request == GPIOHANDLE_SET_LINE_VALUES_IOCTL) {
+        memcpy(call.values, ((struct gpiohandle_data*) arg)->values, sizeof(call.values));
+    } else if (request == GPIOHANDLE_GET_LINE_VALUES_IOCTL) {
+        memcpy(((struct gpiohandle_data*) arg)->values, chardev_levels, sizeof(chardev_levels));
+    }
+    chardev_calls.push_back(call);
+    return 0;
+}
+
+/*
+ * A chardev context built by hand over two chips: pins 0 and 2 are lines 3
+ * and 7 of chip 0, pin 1 is line 1 of chip 1
+ */
+class mraa_gpio_h_chardev_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_init());
+        saved_chardev = plat->chardev_capable;
+        plat->chardev_capable = 1;
+
+        dev = (mraa_gpio_context) calloc(1, sizeof(struct _gpio));
+        ASSERT_TRUE(dev != NULL);
+        memset(groups, 0, sizeof(groups));
+        dev->gpio_group = groups;
+        dev->num_chips = 2;
+        dev->num_pins = 3;
+        dev->advance_func = plat->adv_func;
+
+        groups[0].is_required = 1;
+        groups[0].num_gpio_lines = 2;
+        groups[0].gpio_lines = lines0;
+        groups[0].rw_values = values0;
+        groups[0].gpio_group_to_pins_table = pins0;
+        groups[1].is_required = 1;
+        groups[1].num_gpio_lines = 1;
+        groups[1].gpio_lines = lines1;
+        groups[1].rw_values = values1;
+        groups[1].gpio_group_to_pins_table = pins1;
+
+        std::lock_guard<std::mutex> lock(chardev_lock);
+        chardev_fds.clear();
+        /* Chip fds then the line handle fds given out by the requests. */
+        for (int i = 0; i < 4; ++i) {
+            chardev_fds.push_back(open("/dev/null", O_RDWR));
+        }
+        groups[0].dev_fd = chardev_fds[0];
+        groups[1].dev_fd = chardev_fds[1];
+        chardev_calls.clear();
+        memset(chardev_levels, 0, sizeof(chardev_levels));
+    }
+
+    void
+    TearDown()
+    {
+        plat->chardev_capable = saved_chardev;
+        free(dev);
+        std::lock_guard<std::mutex> lock(chardev_lock);
+        for (int fd : chardev_fds) {
+            close(fd);
+        }
+        chardev_fds.clear();
+    }
+
+    std::vector<chardev_call>
+    calls()
+    {
+        std::lock_guard<std::mutex> lock(chardev_lock);
+        std::vector<chardev_call> ret = chardev_calls;
+        chardev_calls.clear();
+        return ret;
+    }
+
+    mraa_boolean_t saved_chardev;
+    mraa_gpio_context dev;
+    struct _gpio_group groups[2];
+    unsigned int lines0[2] = { 3, 7 };
+    unsigned int lines1[1] = { 1 };
+    unsigned char values0[2] = { 0, 0 };
+    unsigned char values1[1] = { 0 };
+    unsigned int pins0[2] = { 0, 2 };
+    unsigned int pins1[1] = { 1 };
+};
+
+/* v2 lines: one SET_VALUES per chip with the written lines in the mask, chips left out aren't touched. */
+TEST_F(mraa_gpio_h_chardev_unit, test_write_masked_v2)
+{
+    int values[3] = { 1, 1, 0 };
+    int mask[3] = { 1, 0, 1 };
+    groups[0].uapi_v2 = 1;
+    groups[1].uapi_v2 = 1;
+    groups[0].gpiod_handle = chardev_fds[2];
+    groups[1].gpiod_handle = chardev_fds[3];
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write_multi_masked(dev, values, mask));
+    std::vector<chardev_call> made = calls();
+    ASSERT_EQ(1U, made.size());
+    ASSERT_EQ(chardev_fds[2], made[0].fd);
+    ASSERT_EQ(GPIO_V2_LINE_SET_VALUES_IOCTL, made[0].request);
+    ASSERT_EQ(0x3U, made[0].mask);
+    ASSERT_EQ(0x1U, made[0].bits);
+
+    /* Only line 7 of chip 0 and the line of chip 1. */
+    int values2[3] = { 0, 1, 1 };
+    int mask2[3] = { 0, 1, 1 };
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write_multi_masked(dev, values2, mask2));
+    made = calls();
+    ASSERT_EQ(2U, made.size());
+    ASSERT_EQ(chardev_fds[2], made[0].fd);
+    ASSERT_EQ(0x2U, made[0].mask);
+    ASSERT_EQ(0x2U, made[0].bits & made[0].mask);
+    ASSERT_EQ(chardev_fds[3], made[1].fd);
+    ASSERT_EQ(0x1U, made[1].mask);
+    ASSERT_EQ(0x1U, made[1].bits);
+
+    int none[3] = { 0, 0, 0 };
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write_multi_masked(dev, values, none));
+    ASSERT_TRUE(calls().empty());
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_gpio_write_multi_masked(dev, values, NULL));
+}
+
+/* v1 lines: unmasked lines are read back and rewritten with their current level. */
+TEST_F(mraa_gpio_h_chardev_unit, test_write_masked_v1)
+{
+    int values[3] = { 1, 0, 0 };
+    int mask[3] = { 1, 0, 0 };
+    groups[0].gpiod_handle = chardev_fds[2];
+    groups[1].gpiod_handle = chardev_fds[3];
+    values0[1] = 0;
+    chardev_levels[1] = 1;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write_multi_masked(dev, values, mask));
+    std::vector<chardev_call> made = calls();
+    ASSERT_EQ(2U, made.size());
+    ASSERT_EQ(GPIOHANDLE_GET_LINE_VALUES_IOCTL, made[0].request);
+    ASSERT_EQ(GPIOHANDLE_SET_LINE_VALUES_IOCTL, made[1].request);
+    ASSERT_EQ(chardev_fds[2], made[1].fd);
+    ASSERT_EQ(1, made[1].values[0]);
+    ASSERT_EQ(1, made[1].values[1]);
+
+    /* Every line of the chip is written, nothing to read back. */
+    int all[3] = { 1, 1, 1 };
+    int zeros[3] = { 0, 0, 0 };
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write_multi_masked(dev, zeros, all));
+    made = calls();
+    ASSERT_EQ(2U, made.size());
+    ASSERT_EQ(GPIOHANDLE_SET_LINE_VALUES_IOCTL, made[0].request);
+    ASSERT_EQ(0, made[0].values[0]);
+    ASSERT_EQ(0, made[0].values[1]);
+    ASSERT_EQ(GPIOHANDLE_SET_LINE_VALUES_IOCTL, made[1].request);
+    ASSERT_EQ(chardev_fds[3], made[1].fd);
+}
+
+/* Lines are requested through the ABI of their chip, v2 requests carry the levels to keep. */
+TEST_F(mraa_gpio_h_chardev_unit, test_request_abi)
+{
+    int values[3] = { 0, 1, 1 };
+    groups[0].uapi_v2 = 1;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_gpio_write_multi(dev, values));
+    std::vector<chardev_call> made = calls();
+    ASSERT_EQ(4U, made.size());
+    ASSERT_EQ(chardev_fds[0], made[0].fd);
+    ASSERT_EQ(GPIO_V2_GET_LINE_IOCTL, made[0].request);
+    ASSERT_EQ(0x3U, made[0].mask);
+    ASSERT_EQ(0x2U, made[0].bits);
+    ASSERT_EQ(GPIO_V2_LINE_SET_VALUES_IOCTL, made[1].request);
+    ASSERT_EQ(chardev_fds[1], made[2].fd);
+    ASSERT_EQ(GPIO_GET_LINEHANDLE_IOCTL, made[2].request);
+    ASSERT_EQ(GPIOHANDLE_SET_LINE_VALUES_IOCTL, made[3].request);
+    ASSERT_EQ(1, made[3].values[0]);
+
+    /* Kernels without GPIO_V2_GET_LINEINFO_IOCTL fall back to v1. */
+    ASSERT_FALSE(mraa_gpiod_has_uapi_v2(chardev_fds[0]));
+}
@@ -0,0 +1,914 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "mraa/i2c.h"
+#include "bus/bus_arbiter.h"
+#include "linux/i2c-dev.h"
+#include "mraa_internal.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <condition_variable>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/* Address of the device emulated by the mock i2c bus */
+#define MOCK_I2C_DEV_ADDR 0x33
+
+/* MRAA I2C test fixture */
+class mraa_i2c_h_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        dev = mraa_i2c_init(0);
+        ASSERT_TRUE(dev != NULL);
+        txn = mraa_i2c_txn_init(dev);
+        ASSERT_TRUE(txn != NULL);
+    }
+
+    void
+    TearDown()
+    {
+        mraa_i2c_txn_close(txn);
+        mraa_i2c_stop(dev);
+    }
+
+    mraa_i2c_context dev;
+    mraa_i2c_txn txn;
+};
+
+/* Transaction calls on a NULL transaction or context. */
+TEST_F(mraa_i2c_h_unit, test_txn_invalid_handle)
+{
+    uint8_t buf[2] = { 0 };
+    ASSERT_TRUE(mraa_i2c_txn_init(NULL) == NULL);
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_txn_write(NULL, MOCK_I2C_DEV_ADDR, buf, 2));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_txn_read(NULL, MOCK_I2C_DEV_ADDR, buf, 2));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_txn_submit(NULL));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_txn_reset(NULL));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_txn_close(NULL));
+}
+
+/* Empty, oversized and buffer-less messages are rejected. */
+TEST_F(mraa_i2c_h_unit, test_txn_invalid_message)
+{
+    uint8_t buf[2] = { 0 };
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, buf, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_txn_read(txn, MOCK_I2C_DEV_ADDR, buf, 8193));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, NULL, 2));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_txn_read_bytes_data(txn, MOCK_I2C_DEV_ADDR, 0, buf, -1));
+    /* Nothing was queued, submitting is a no-op. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit(txn));
+}
+
+/* A write then a read of the mock device in one transaction, resubmitted after a reset. */
+TEST_F(mraa_i2c_h_unit, test_txn_write_read)
+{
+    uint8_t wbuf[2] = { 0xAA, 0xBB };
+    uint8_t rbuf[2] = { 0 };
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, 0x10));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, wbuf, 2));
+    /* The bytes are copied when queued. */
+    wbuf[0] = 0;
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_read(txn, MOCK_I2C_DEV_ADDR, rbuf, 2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit(txn));
+    ASSERT_EQ(0xAA, rbuf[0]);
+    ASSERT_EQ(0xBB, rbuf[1]);
+    /* The context address is restored. */
+    ASSERT_EQ(-1, mraa_i2c_read_byte(dev));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_reset(txn));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write_byte_data(txn, MOCK_I2C_DEV_ADDR, 0x5A, 0x00));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_read_bytes_data(txn, MOCK_I2C_DEV_ADDR, 0x00, rbuf, 2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit(txn));
+    ASSERT_EQ(0x00, rbuf[0]);
+    ASSERT_EQ(0x5A, rbuf[1]);
+}
+
+/* A message to a missing device fails the transaction. */
+TEST_F(mraa_i2c_h_unit, test_txn_no_device)
+{
+    uint8_t rbuf[2] = { 0 };
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_read(txn, MOCK_I2C_DEV_ADDR + 1, rbuf, 2));
+    ASSERT_NE(MRAA_SUCCESS, mraa_i2c_txn_submit(txn));
+}
+
+/* Per-message address calls reach the mock device and leave the context address alone. */
+TEST_F(mraa_i2c_h_unit, test_address_per_call)
+{
+    uint8_t wbuf[2] = { 0x12, 0x34 };
+    uint8_t rbuf[2] = { 0 };
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, 0x10));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write_to(dev, MOCK_I2C_DEV_ADDR, wbuf, 2));
+    ASSERT_EQ(2, mraa_i2c_read_from(dev, MOCK_I2C_DEV_ADDR, rbuf, 2));
+    ASSERT_EQ(0x12, rbuf[0]);
+    ASSERT_EQ(0x34, rbuf[1]);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write_byte_data_to(dev, MOCK_I2C_DEV_ADDR, 0x56, 0x01));
+    ASSERT_EQ(0x56, mraa_i2c_read_byte_data_from(dev, MOCK_I2C_DEV_ADDR, 0x01));
+    ASSERT_EQ(2, mraa_i2c_read_bytes_data_from(dev, MOCK_I2C_DEV_ADDR, 0x00, rbuf, 2));
+    ASSERT_EQ(0x12, rbuf[0]);
+    ASSERT_EQ(0x56, rbuf[1]);
+
+    /* Still addressing 0x10, which isn't the mock device. */
+    ASSERT_EQ(-1, mraa_i2c_read_byte(dev));
+    ASSERT_EQ(-1, mraa_i2c_read_from(dev, MOCK_I2C_DEV_ADDR + 1, rbuf, 2));
+    ASSERT_EQ(-1, mraa_i2c_read_from(NULL, MOCK_I2C_DEV_ADDR, rbuf, 2));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_write_to(dev, MOCK_I2C_DEV_ADDR, wbuf, 0));
+}
+
+/* Arbiter calls on invalid arguments. */
+TEST_F(mraa_i2c_h_unit, test_bus_arbiter_invalid)
+{
+    mraa_bus_stats_t stats;
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_set_priority(NULL, MRAA_BUS_PRIORITY_HIGH));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_set_priority(dev, (mraa_bus_priority_t) 7));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_bus_stats(NULL, &stats));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_bus_stats(dev, NULL));
+    /* Releasing a bus which isn't held fails. */
+    ASSERT_EQ(MRAA_ERROR_INVALID_RESOURCE, mraa_i2c_bus_release(dev));
+}
+
+/* Holds nest and transfers of the holding thread go through. */
+TEST_F(mraa_i2c_h_unit, test_bus_arbiter_nested)
+{
+    mraa_bus_stats_t before, after;
+    uint8_t rbuf[1];
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_stats(dev, &before));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_acquire(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_acquire(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(1, mraa_i2c_read(dev, rbuf, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_release(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_release(dev));
+    ASSERT_EQ(MRAA_ERROR_INVALID_RESOURCE, mraa_i2c_bus_release(dev));
+
+    /* The whole held section counts as a single grant. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_stats(dev, &after));
+    ASSERT_EQ(before.transfers[MRAA_BUS_PRIORITY_NORMAL] + 1, after.transfers[MRAA_BUS_PRIORITY_NORMAL]);
+}
+
+/* A sub platform bus doesn't share the arbiter of the kernel bus with the same number. */
+TEST_F(mraa_i2c_h_unit, test_bus_arbiter_sub_platform)
+{
+    mraa_board_t sub;
+    memset(&sub, 0, sizeof(sub));
+    sub.platform_name = (char*) "fake sub platform";
+    sub.i2c_bus_count = 1;
+    sub.i2c_bus[0].bus_id = 0;
+    sub.no_bus_mux = 1;
+    sub.adv_func = plat->adv_func;
+    mraa_board_t* saved_sub = plat->sub_platform;
+    plat->sub_platform = &sub;
+
+    mraa_i2c_context sub_dev = mraa_i2c_init(mraa_get_sub_platform_id(0));
+    mraa_i2c_context other = mraa_i2c_init(mraa_get_sub_platform_id(0));
+    mraa_i2c_context raw = mraa_i2c_init_raw(0);
+    plat->sub_platform = saved_sub;
+    ASSERT_TRUE(sub_dev != NULL && other != NULL && raw != NULL);
+
+    ASSERT_TRUE(sub_dev->arbiter != dev->arbiter);
+    ASSERT_TRUE(sub_dev->arbiter == other->arbiter);
+    ASSERT_TRUE(raw->arbiter == dev->arbiter);
+
+    mraa_i2c_stop(sub_dev);
+    mraa_i2c_stop(other);
+    mraa_i2c_stop(raw);
+}
+
+/* Spin until n threads wait for the bus. */
+static bool
+wait_waiters(struct _bus_arbiter* arb, unsigned int n)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (mraa_bus_arbiter_waiters(arb) < n) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/* Waiting high priority transfers go before waiting bulk ones, whatever the arrival order. */
+TEST_F(mraa_i2c_h_unit, test_bus_arbiter_priority)
+{
+    mraa_i2c_context bulk = mraa_i2c_init(0);
+    mraa_i2c_context high = mraa_i2c_init(0);
+    ASSERT_TRUE(bulk != NULL && high != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_priority(bulk, MRAA_BUS_PRIORITY_BULK));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_priority(high, MRAA_BUS_PRIORITY_HIGH));
+
+    mraa_bus_stats_t before, after;
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_stats(dev, &before));
+
+    std::mutex order_lock;
+    std::vector<int> order;
+    auto run = [&](mraa_i2c_context ctx, int id) {
+        mraa_i2c_bus_acquire(ctx);
+        {
+            std::lock_guard<std::mutex> guard(order_lock);
+            order.push_back(id);
+        }
+        mraa_i2c_bus_release(ctx);
+    };
+
+    /* The bulk thread queues first, the high one once the bulk one waits. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_acquire(dev));
+    std::thread t_bulk(run, bulk, 2);
+    bool queued = wait_waiters(dev->arbiter, 1);
+    std::thread t_high(run, high, 1);
+    queued = queued && wait_waiters(dev->arbiter, 2);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_release(dev));
+    t_bulk.join();
+    t_high.join();
+    ASSERT_TRUE(queued);
+
+    ASSERT_EQ(2U, order.size());
+    ASSERT_EQ(1, order[0]);
+    ASSERT_EQ(2, order[1]);
+
+    /* Statistics are per bus, any context of the bus sees them. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_stats(bulk, &after));
+    ASSERT_EQ(before.contended[MRAA_BUS_PRIORITY_HIGH] + 1, after.contended[MRAA_BUS_PRIORITY_HIGH]);
+    ASSERT_EQ(before.contended[MRAA_BUS_PRIORITY_BULK] + 1, after.contended[MRAA_BUS_PRIORITY_BULK]);
+    ASSERT_GT(after.max_wait_ns[MRAA_BUS_PRIORITY_BULK], 0U);
+
+    mraa_i2c_stop(bulk);
+    mraa_i2c_stop(high);
+}
+
+/* Register cache calls without a cache or with a bad map. */
+TEST_F(mraa_i2c_h_unit, test_regcache_invalid)
+{
+    ASSERT_EQ(-1, mraa_i2c_regcache_read(dev, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_regcache_write(dev, 0, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_regcache_sync(dev));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_regcache_init(dev, 0, NULL, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_regcache_init(dev, 257, NULL, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_regcache_init(dev, 8, NULL, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_regcache_init(NULL, 8, NULL, 0));
+}
+
+/* Cached registers are read once, volatile ones every time. */
+TEST_F(mraa_i2c_h_unit, test_regcache_read)
+{
+    const uint8_t volatile_regs[] = { 1 };
+    const uint8_t wbuf[2] = { 0x10, 0x20 };
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_init(dev, 8, volatile_regs, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write(dev, wbuf, 2));
+    ASSERT_EQ(0x10, mraa_i2c_regcache_read(dev, 0));
+    ASSERT_EQ(0x20, mraa_i2c_regcache_read(dev, 1));
+
+    /* The device changes behind the cache. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write_byte_data(dev, 0x11, 0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write_byte_data(dev, 0x21, 1));
+    ASSERT_EQ(0x10, mraa_i2c_regcache_read(dev, 0));
+    ASSERT_EQ(0x21, mraa_i2c_regcache_read(dev, 1));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_invalidate(dev));
+    ASSERT_EQ(0x11, mraa_i2c_regcache_read(dev, 0));
+}
+
+/* Bit updates stay in the cache and contiguous dirty registers go out in one write. */
+TEST_F(mraa_i2c_h_unit, test_regcache_sync)
+{
+    uint8_t rbuf[3] = { 0 };
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_init(dev, 8, NULL, 0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_write(dev, 3, 0xF0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_update_bits(dev, 3, 0x0F, 0x05));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_write(dev, 4, 0x42));
+    ASSERT_EQ(0xF5, mraa_i2c_regcache_read(dev, 3));
+
+    /* Nothing reached the device yet. */
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 3));
+
+    /* The mock device stores a write as is: register byte then values. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_sync(dev));
+    ASSERT_EQ(3, mraa_i2c_read(dev, rbuf, 3));
+    ASSERT_EQ(3, rbuf[0]);
+    ASSERT_EQ(0xF5, rbuf[1]);
+    ASSERT_EQ(0x42, rbuf[2]);
+
+    /* Nothing left to write. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write_byte_data(dev, 0x00, 0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_sync(dev));
+    ASSERT_EQ(0x00, mraa_i2c_read_byte_data(dev, 0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_regcache_close(dev));
+}
+
+/* The mock device is the only one answering, reserved addresses aren't probed. */
+TEST_F(mraa_i2c_h_unit, test_scan)
+{
+    mraa_i2c_scan_result_t result;
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_scan(0, 100, NULL));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_scan(0, 100, &result));
+    ASSERT_EQ(0, result.bus);
+    ASSERT_EQ(1, result.num_found);
+    ASSERT_EQ(MRAA_I2C_SCAN_PRESENT, result.state[MOCK_I2C_DEV_ADDR]);
+    ASSERT_EQ(MRAA_I2C_SCAN_ABSENT, result.state[MOCK_I2C_DEV_ADDR + 1]);
+    ASSERT_EQ(MRAA_I2C_SCAN_SKIPPED, result.state[0x00]);
+    ASSERT_EQ(MRAA_I2C_SCAN_SKIPPED, result.state[0x7F]);
+}
+
+/* Every bus of the platform is scanned. */
+TEST_F(mraa_i2c_h_unit, test_scan_all)
+{
+    mraa_i2c_scan_result_t results[4];
+
+    ASSERT_EQ(-1, mraa_i2c_scan_all(100, NULL, 4));
+    ASSERT_EQ(1, mraa_i2c_scan_all(0, results, 4));
+    ASSERT_EQ(MRAA_SUCCESS, results[0].status);
+    ASSERT_EQ(MRAA_I2C_SCAN_PRESENT, results[0].state[MOCK_I2C_DEV_ADDR]);
+}
+
+/* Probe of one address stuck until the test lets it go. */
+static std::mutex stuck_lock;
+static std::condition_variable stuck_cond;
+static bool stuck_probing, stuck_released;
+static int (*stuck_next)(mraa_i2c_context);
+
+static int
+stuck_read_byte(mraa_i2c_context ctx)
+{
+    if (ctx->addr == MOCK_I2C_DEV_ADDR) {
+        std::unique_lock<std::mutex> lock(stuck_lock);
+        stuck_probing = true;
+        stuck_cond.notify_all();
+        stuck_cond.wait_for(lock, std::chrono::seconds(10), [] { return stuck_released; });
+    }
+    return stuck_next(ctx);
+}
+
+/* A scan gives up on a stuck probe, the bus is free again once the probe returns. */
+TEST_F(mraa_i2c_h_unit, test_scan_timeout)
+{
+    /* The abandoned thread still calls these after the test returned. */
+    static mraa_adv_func_t funcs;
+    mraa_adv_func_t* saved = plat->adv_func;
+    mraa_i2c_scan_result_t result;
+
+    funcs = *saved;
+    stuck_next = saved->i2c_read_byte_replace;
+    funcs.i2c_read_byte_replace = &stuck_read_byte;
+    stuck_probing = stuck_released = false;
+    plat->adv_func = &funcs;
+    mraa_result_t ret = mraa_i2c_scan(0, 200, &result);
+    plat->adv_func = saved;
+
+    ASSERT_EQ(MRAA_ERROR_UNSPECIFIED, ret);
+    ASSERT_EQ(MRAA_I2C_SCAN_ABSENT, result.state[MOCK_I2C_DEV_ADDR - 1]);
+    ASSERT_EQ(MRAA_I2C_SCAN_SKIPPED, result.state[MOCK_I2C_DEV_ADDR]);
+    {
+        std::lock_guard<std::mutex> lock(stuck_lock);
+        ASSERT_TRUE(stuck_probing);
+        stuck_released = true;
+        stuck_cond.notify_all();
+    }
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_acquire(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_release(dev));
+}
+
+/* Completion callback counting the successful requests. */
+static void
+count_async(mraa_result_t status, void* args)
+{
+    if (status == MRAA_SUCCESS) {
+        (*(int*) args)++;
+    }
+}
+
+/* Requests run in submission order on the bus worker, the handle reports the result. */
+TEST_F(mraa_i2c_h_unit, test_txn_async)
+{
+    uint8_t wbuf[2] = { 0x11, 0x22 };
+    uint8_t rbuf[2] = { 0 };
+    mraa_i2c_txn rtxn = mraa_i2c_txn_init(dev);
+    mraa_bus_async_t handle = NULL;
+    int completed = 0;
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_txn_submit_async(NULL, NULL, NULL, &handle));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_bus_async_wait(NULL));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, wbuf, 2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_read(rtxn, MOCK_I2C_DEV_ADDR, rbuf, 2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(txn, &count_async, &completed, NULL));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(rtxn, &count_async, &completed, &handle));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_bus_async_wait(handle));
+    ASSERT_EQ(2, completed);
+    ASSERT_EQ(0x11, rbuf[0]);
+    ASSERT_EQ(0x22, rbuf[1]);
+
+    /* Failures are reported through the handle. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_reset(rtxn));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_read(rtxn, MOCK_I2C_DEV_ADDR + 1, rbuf, 2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(rtxn, NULL, NULL, &handle));
+    ASSERT_NE(MRAA_SUCCESS, mraa_bus_async_wait(handle));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_close(rtxn));
+}
+
+/* Completion callback counting the requests cancelled by a stop. */
+static void
+count_cancelled(mraa_result_t status, void* args)
+{
+    if (status == MRAA_ERROR_INVALID_RESOURCE) {
+        (*(int*) args)++;
+    }
+}
+
+/* Stopping a context cancels its queued requests, a wait under a held bus is refused. */
+TEST_F(mraa_i2c_h_unit, test_txn_async_stop)
+{
+    uint8_t wbuf[1] = { 0x11 };
+    mraa_i2c_context other = mraa_i2c_init(0);
+    ASSERT_TRUE(other != NULL);
+    mraa_i2c_txn otxn = mraa_i2c_txn_init(other);
+    ASSERT_TRUE(otxn != NULL);
+    mraa_bus_async_t running = NULL, queued = NULL;
+    int cancelled = 0;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, wbuf, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write(otxn, MOCK_I2C_DEV_ADDR, wbuf, 1));
+
+    /* Nothing of the bus runs until it is released, the requests stay queued. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_acquire(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(txn, NULL, NULL, &running));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(otxn, NULL, NULL, &queued));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(otxn, &count_cancelled, &cancelled, NULL));
+    ASSERT_EQ(MRAA_ERROR_INVALID_RESOURCE, mraa_bus_async_wait(running));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_stop(other));
+    ASSERT_EQ(1, cancelled);
+    ASSERT_EQ(1, mraa_bus_async_done(queued));
+    ASSERT_EQ(MRAA_ERROR_INVALID_RESOURCE, mraa_bus_async_wait(queued));
+    ASSERT_EQ(0, mraa_bus_async_done(running));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_bus_release(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_bus_async_wait(running));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_close(otxn));
+}
+
+static int python_calls = 0;
+
+/* Stands in for the Python module, which owns the callbacks flagged as Python ones. */
+static void
+fake_python_bus_callback(void (*cb)(mraa_result_t, void*), mraa_result_t status, void* args)
+{
+    python_calls++;
+}
+
+extern "C" mraa_result_t mraa_i2c_txn_submit_async_python(mraa_i2c_txn txn, void* cb, void* args);
+
+/* C callbacks are called directly even with the Python module loaded. */
+TEST_F(mraa_i2c_h_unit, test_txn_async_python)
+{
+    uint8_t wbuf[1] = { 0x11 };
+    mraa_bus_async_t handle = NULL;
+    int completed = 0;
+    python_calls = 0;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, wbuf, 1));
+    void (*saved)(void (*)(mraa_result_t, void*), mraa_result_t, void*) =
+    lang_func->python_bus_callback;
+    lang_func->python_bus_callback = &fake_python_bus_callback;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(txn, &count_async, &completed, &handle));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_bus_async_wait(handle));
+    ASSERT_EQ(1, completed);
+    ASSERT_EQ(0, python_calls);
+
+    /* Requests run in order, the wait on the next one covers the Python one. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async_python(txn, (void*) &completed, NULL));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(txn, NULL, NULL, &handle));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_bus_async_wait(handle));
+    ASSERT_EQ(1, completed);
+    ASSERT_EQ(1, python_calls);
+
+    lang_func->python_bus_callback = saved;
+}
+
+/* Workers stopped by mraa_deinit() start again on the next request. */
+TEST_F(mraa_i2c_h_unit, test_txn_async_shutdown)
+{
+    uint8_t wbuf[1] = { 0x11 };
+    mraa_bus_async_t handle = NULL;
+    int completed = 0;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_write(txn, MOCK_I2C_DEV_ADDR, wbuf, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(txn, &count_async, &completed, NULL));
+    mraa_bus_arbiter_shutdown();
+    ASSERT_EQ(1, completed);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_txn_submit_async(txn, &count_async, &completed, &handle));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_bus_async_wait(handle));
+    ASSERT_EQ(2, completed);
+    mraa_bus_arbiter_shutdown();
+}
+
+/* SMBus block writes go out as register, count, bytes; PEC needs a real adapter. */
+TEST_F(mraa_i2c_h_unit, test_block_data)
+{
+    uint8_t wbuf[33] = { 0x01, 0x02, 0x03 };
+    uint8_t rbuf[4] = { 0 };
+
+    ASSERT_EQ(-1, mraa_i2c_read_block_data(NULL, 0, rbuf));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_write_block_data(NULL, 0, wbuf, 3));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_i2c_write_block_data(dev, 0, wbuf, 33));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_set_pec(NULL, 1));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_write_block_data(dev, 0x00, wbuf, 3));
+    ASSERT_EQ(4, mraa_i2c_read_bytes_data(dev, 0x01, rbuf, 4));
+    ASSERT_EQ(3, rbuf[0]);
+    ASSERT_EQ(0x01, rbuf[1]);
+    ASSERT_EQ(0x03, rbuf[3]);
+
+    ASSERT_EQ(-1, mraa_i2c_read_block_data(dev, 0x00, wbuf));
+    ASSERT_EQ(MRAA_ERROR_FEATURE_NOT_SUPPORTED, mraa_i2c_set_pec(dev, 1));
+}
+
+/* The mock bus has no device file, nothing goes through ioctl. */
+TEST_F(mraa_i2c_h_unit, test_ioctl_stats)
+{
+    mraa_bus_ioctl_stats_t stats;
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_ioctl_stats(NULL, &stats));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_ioctl_stats(dev, NULL));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x05));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_ioctl_stats(dev, &stats));
+    ASSERT_EQ(0u, stats.issued);
+    ASSERT_EQ(0u, stats.avoided);
+}
+
+/* Adapter settings need a device file, the mock bus pins aren't gpios. */
+TEST_F(mraa_i2c_h_unit, test_timeout_recovery)
+{
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_set_timeout(NULL, 100));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_set_retries(NULL, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_set_breaker(NULL, 3, 100, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_i2c_recover(NULL));
+
+    ASSERT_EQ(MRAA_ERROR_FEATURE_NOT_SUPPORTED, mraa_i2c_set_timeout(dev, 100));
+    ASSERT_EQ(MRAA_ERROR_FEATURE_NOT_SUPPORTED, mraa_i2c_set_retries(dev, 1));
+    ASSERT_EQ(MRAA_ERROR_FEATURE_NOT_SUPPORTED, mraa_i2c_recover(dev));
+
+    /* The platform's own functions aren't affected by the breaker. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_breaker(dev, 1, 1000, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR + 1));
+    ASSERT_EQ(-1, mraa_i2c_read_byte(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x09));
+}
+
+/*
+ * A fake /dev/i2c-0 adapter. open(), close(), ioctl() and usleep() made by
+ * libmraa resolve to the definitions below, which serve the adapter's fds and
+ * pass everything else on to libc.
+ */
+static std::mutex adapter_lock;
+static bool adapter_open = false;        /* whether open("/dev/i2c-0") is faked */
+static std::map<int, int> adapter_slave; /* fd to the address it targets, -1 if unset */
+static std::vector<unsigned long> adapter_ioctls;
+static unsigned int adapter_failures = 0; /* transfers still to fail with EIO */
+static int adapter_slave_failures = 0;    /* I2C_SLAVE_FORCE calls still to fail */
+static unsigned int adapter_usleeps = 0;  /* delays of the bus recovery */
+
+/* Address of a device claimed by a kernel driver on the fake adapter */
+#define ADAPTER_BUSY_ADDR 0x50
+
+static bool
+adapter_fd(int fd)
+{
+    return adapter_slave.find(fd) != adapter_slave.end();
+}
+
+static unsigned int
+adapter_count(unsigned long request)
+{
+    std::lock_guard<std::mutex> lock(adapter_lock);
+    unsigned int count = 0;
+    for (unsigned long r : adapter_ioctls) {
+        count += r == request;
+    }
+    return count;
+}
+
+extern "C" int
+open(const char* path, int flags, ...)
+{
+    static int (*next)(const char*, int, ...) = (int (*)(const char*, int, ...)) dlsym(RTLD_NEXT, "open");
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+    std::lock_guard<std::mutex> lock(adapter_lock);
+    if (adapter_open && strcmp(path, "/dev/i2c-0") == 0) {
+        int fd = next("/dev/null", O_RDWR);
+        if (fd >= 0) {
+            adapter_slave[fd] = -1;
+        }
+        return fd;
+    }
+    return next(path, flags, mode);
+}
+
+extern "C" int
+close(int fd)
+{
+    static int (*next)(int) = (int (*)(int)) dlsym(RTLD_NEXT, "close");
+    {
+        std::lock_guard<std::mutex> lock(adapter_lock);
+        adapter_slave.erase(fd);
+    }
+    return next(fd);
+}
+
+extern "C" int
+ioctl(int fd, unsigned long request, ...) noexcept
+{
+    static int (*next)(int, unsigned long, ...) = (int (*)(int, unsigned long, ...)) dlsym(RTLD_NEXT, "ioctl");
+    va_list ap;
+    va_start(ap, request);
+    void* arg = va_arg(ap, void*);
+    va_end(ap);
+
+    std::lock_guard<std::mutex> lock(adapter_lock);
+    if (!adapter_fd(fd)) {
+        return next(fd, request, arg);
+    }
+    adapter_ioctls.push_back(request);
+    unsigned long addr = (unsigned long) arg;
+    switch (request) {
+        case I2C_FUNCS:
+            *(unsigned long*) arg = I2C_FUNC_I2C | I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_PEC;
+            return 0;
+        case I2C_PEC:
+        case I2C_TIMEOUT:
+        case I2C_RETRIES:
+            return 0;
+        case I2C_SLAVE:
+        case I2C_SLAVE_FORCE:
+            if (request == I2C_SLAVE && addr == ADAPTER_BUSY_ADDR) {
+                errno = EBUSY;
+                return -1;
+            }
+            if (request == I2C_SLAVE_FORCE && adapter_slave_failures > 0) {
+                adapter_slave_failures--;
+                errno = EIO;
+                return -1;
+            }
+            adapter_slave[fd] = (int) addr;
+            return 0;
+        case I2C_SMBUS: {
+            struct i2c_smbus_ioctl_data* smbus = (struct i2c_smbus_ioctl_data*) arg;
+            if (adapter_failures > 0) {
+                adapter_failures--;
+                errno = EIO;
+                return -1;
+            }
+            if (adapter_slave[fd] != MOCK_I2C_DEV_ADDR) {
+                errno = ENXIO;
+                return -1;
+            }
+            if (smbus->read_write == I2C_SMBUS_READ && smbus->data != NULL) {
+                smbus->data->byte = 0xAB;
+            }
+            return 0;
+        }
+        default:
+            errno = ENOTTY;
+            return -1;
+    }
+}
+
+extern "C" int
+usleep(useconds_t usec)
+{
+    static int (*next)(useconds_t) = (int (*)(useconds_t)) dlsym(RTLD_NEXT, "usleep");
+    __atomic_add_fetch(&adapter_usleeps, 1, __ATOMIC_RELAXED);
+    return next(usec);
+}
+
+/* Contexts of the mock bus opened without its i2c functions, on the fake adapter */
+class mraa_i2c_h_adapter_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_init());
+        saved = plat->adv_func;
+        funcs = *saved;
+        funcs.i2c_init_pre = NULL;
+        funcs.i2c_init_bus_replace = NULL;
+        funcs.i2c_init_raw_replace = NULL;
+        funcs.i2c_init_post = NULL;
+        funcs.i2c_set_frequency_replace = NULL;
+        funcs.i2c_address_replace = NULL;
+        funcs.i2c_read_replace = NULL;
+        funcs.i2c_read_byte_replace = NULL;
+        funcs.i2c_read_byte_data_replace = NULL;
+        funcs.i2c_read_word_data_replace = NULL;
+        funcs.i2c_read_bytes_data_replace = NULL;
+        funcs.i2c_write_replace = NULL;
+        funcs.i2c_write_byte_replace = NULL;
+        funcs.i2c_write_byte_data_replace = NULL;
+        funcs.i2c_write_word_data_replace = NULL;
+        funcs.i2c_stop_replace = NULL;
+        plat->adv_func = &funcs;
+        {
+            std::lock_guard<std::mutex> lock(adapter_lock);
+            adapter_open = true;
+            adapter_ioctls.clear();
+            adapter_failures = 0;
+            adapter_slave_failures = 0;
+        }
+        dev = mraa_i2c_init(0);
+        ASSERT_TRUE(dev != NULL);
+    }
+
+    void
+    TearDown()
+    {
+        if (dev != NULL) {
+            mraa_i2c_stop(dev);
+        }
+        std::lock_guard<std::mutex> lock(adapter_lock);
+        adapter_open = false;
+        plat->adv_func = saved;
+    }
+
+    int
+    slave()
+    {
+        std::lock_guard<std::mutex> lock(adapter_lock);
+        return adapter_slave[dev->fh];
+    }
+
+    mraa_adv_func_t* saved;
+    mraa_adv_func_t funcs;
+    mraa_i2c_context dev;
+};
+
+/* Redundant I2C_SLAVE_FORCE and I2C_PEC calls are skipped, the rest reach the adapter. */
+TEST_F(mraa_i2c_h_adapter_unit, test_ioctl_stats)
+{
+    mraa_bus_ioctl_stats_t stats;
+
+    /* I2C_FUNCS at init */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_ioctl_stats(dev, &stats));
+    ASSERT_EQ(1u, stats.issued);
+    ASSERT_EQ(0u, stats.avoided);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MOCK_I2C_DEV_ADDR, slave());
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x05));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_ioctl_stats(dev, &stats));
+    ASSERT_EQ(3u, stats.issued);
+    ASSERT_EQ(1u, stats.avoided);
+    ASSERT_EQ(1u, adapter_count(I2C_SLAVE_FORCE));
+
+    /* Only an address change goes to the adapter */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR + 1));
+    ASSERT_EQ(MOCK_I2C_DEV_ADDR + 1, slave());
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MOCK_I2C_DEV_ADDR, slave());
+    ASSERT_EQ(3u, adapter_count(I2C_SLAVE_FORCE));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_pec(dev, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_pec(dev, 1));
+    ASSERT_EQ(1u, adapter_count(I2C_PEC));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_ioctl_stats(dev, &stats));
+    ASSERT_EQ(6u, stats.issued);
+    ASSERT_EQ(2u, stats.avoided);
+}
+
+/* A failed I2C_SLAVE_FORCE forgets the cached address, the next call sets it again. */
+TEST_F(mraa_i2c_h_adapter_unit, test_ioctl_stats_failed_address)
+{
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    adapter_slave_failures = 1;
+    ASSERT_EQ(MRAA_ERROR_UNSPECIFIED, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR + 1));
+    ASSERT_EQ(MOCK_I2C_DEV_ADDR, slave());
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(3u, adapter_count(I2C_SLAVE_FORCE));
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x00));
+}
+
+/* Probing moves the scan context's fd with I2C_SLAVE, one ioctl per address plus the probe. */
+TEST_F(mraa_i2c_h_adapter_unit, test_ioctl_stats_probe)
+{
+    mraa_i2c_scan_result_t result;
+    unsigned int addresses = MRAA_I2C_SCAN_LAST - MRAA_I2C_SCAN_FIRST + 1;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_scan(0, 0, &result));
+    ASSERT_EQ(1, result.num_found);
+    ASSERT_EQ(MRAA_I2C_SCAN_PRESENT, result.state[MOCK_I2C_DEV_ADDR]);
+    ASSERT_EQ(MRAA_I2C_SCAN_BUSY, result.state[ADAPTER_BUSY_ADDR]);
+
+    /* The busy address isn't probed any further */
+    ASSERT_EQ(2u, adapter_count(I2C_FUNCS));
+    ASSERT_EQ(addresses, adapter_count(I2C_SLAVE));
+    ASSERT_EQ(addresses - 1, adapter_count(I2C_SMBUS));
+
+    /* The caller's fd wasn't moved, its cached address still holds */
+    mraa_bus_ioctl_stats_t stats;
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_ioctl_stats(dev, &stats));
+    ASSERT_EQ(1u, stats.avoided);
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x00));
+}
+
+/* The breaker fails fast once it opened and lets one transfer through after the cooldown. */
+TEST_F(mraa_i2c_h_adapter_unit, test_breaker)
+{
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_timeout(dev, 100));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_retries(dev, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_breaker(dev, 2, 50, 0));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+
+    /* Opens after two failures in a row */
+    adapter_failures = 100;
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(2u, adapter_count(I2C_SMBUS));
+
+    /* Open, nothing reaches the adapter */
+    errno = 0;
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(EAGAIN, errno);
+    ASSERT_EQ(MRAA_ERROR_UNSPECIFIED, mraa_i2c_write_byte_data(dev, 0x01, 0x00));
+    ASSERT_EQ(2u, adapter_count(I2C_SMBUS));
+
+    /* Half open after the cooldown, a failed trial opens it again right away */
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(3u, adapter_count(I2C_SMBUS));
+    errno = 0;
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(EAGAIN, errno);
+    ASSERT_EQ(3u, adapter_count(I2C_SMBUS));
+
+    /* A successful trial closes it */
+    adapter_failures = 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(5u, adapter_count(I2C_SMBUS));
+}
+
+/* Tripping the breaker with recover set clocks the bus out through the scl gpio. */
+TEST_F(mraa_i2c_h_adapter_unit, test_breaker_recover)
+{
+    /* The mock i2c pins aren't gpios, drive GPIO0 as scl without sda */
+    dev->scl_pos = 0;
+    dev->sda_pos = -1;
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_breaker(dev, 1, 1000, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_address(dev, MOCK_I2C_DEV_ADDR));
+
+    __atomic_store_n(&adapter_usleeps, 0, __ATOMIC_RELAXED);
+    adapter_failures = 1;
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    /* 9 clocks of two half periods each */
+    ASSERT_EQ(18u, __atomic_load_n(&adapter_usleeps, __ATOMIC_RELAXED));
+
+    /* Recovering doesn't close the breaker, calls still fail fast */
+    errno = 0;
+    ASSERT_EQ(-1, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(EAGAIN, errno);
+    ASSERT_EQ(1u, adapter_count(I2C_SMBUS));
+
+    /* Resetting the breaker lets transfers through again */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_i2c_set_breaker(dev, 0, 0, 0));
+    ASSERT_EQ(0xAB, mraa_i2c_read_byte_data(dev, 0x00));
+    ASSERT_EQ(18u, __atomic_load_n(&adapter_usleeps, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,679 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "mraa/spi.h"
+#include "mraa_internal.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <condition_variable>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/spi/spidev.h>
+#include <mutex>
+#include <set>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/* The mock spi device answers every byte or word XORed with these */
+#define MOCK_SPI_REPLY_DATA_MODIFIER_BYTE 0xAB
+#define MOCK_SPI_REPLY_DATA_MODIFIER_WORD 0xABBA
+
+/* MRAA SPI test fixture */
+class mraa_spi_h_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        dev = mraa_spi_init(0);
+        ASSERT_TRUE(dev != NULL);
+    }
+
+    void
+    TearDown()
+    {
+        mraa_spi_stop(dev);
+    }
+
+    mraa_spi_context dev;
+};
+
+/* Empty or oversized segment lists are rejected. */
+TEST_F(mraa_spi_h_unit, test_segments_invalid)
+{
+    uint8_t buf[2] = { 0 };
+    mraa_spi_segment_t seg[2];
+    memset(seg, 0, sizeof(seg));
+    seg[0].tx = buf;
+    seg[0].length = 2;
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_spi_transfer_segments(NULL, seg, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_transfer_segments(dev, NULL, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_transfer_segments(dev, seg, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_transfer_segments(dev, seg, MRAA_SPI_MAX_SEGMENTS + 1));
+    /* The second segment is empty. */
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_transfer_segments(dev, seg, 2));
+}
+
+/* A command then a receive only segment, as for an ADC channel readout. */
+TEST_F(mraa_spi_h_unit, test_segments)
+{
+    uint8_t cmd[2] = { 0x01, 0x80 };
+    uint8_t rx[3] = { 0 };
+    mraa_spi_segment_t seg[2];
+    memset(seg, 0, sizeof(seg));
+    seg[0].tx = cmd;
+    seg[0].length = 2;
+    seg[1].rx = rx;
+    seg[1].length = 3;
+    seg[1].cs_change = 1;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_transfer_segments(dev, seg, 2));
+    ASSERT_EQ(MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, rx[0]);
+    ASSERT_EQ(MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, rx[2]);
+}
+
+/* The pooled receive buffer is reused across writes. */
+TEST_F(mraa_spi_h_unit, test_write_buf_pooled)
+{
+    uint8_t tx[4] = { 0x00, 0x01, 0x02, 0x03 };
+
+    ASSERT_TRUE(mraa_spi_write_buf_pooled(NULL, tx, 4) == NULL);
+    ASSERT_TRUE(mraa_spi_write_buf_pooled(dev, tx, 0) == NULL);
+
+    uint8_t* rx = mraa_spi_write_buf_pooled(dev, tx, 4);
+    ASSERT_TRUE(rx != NULL);
+    ASSERT_EQ(0x03 ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, rx[3]);
+    /* A shorter write lands in the same buffer. */
+    ASSERT_EQ(rx, mraa_spi_write_buf_pooled(dev, tx, 2));
+    ASSERT_EQ(0x01 ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, rx[1]);
+}
+
+/* Word writes share the pool, lengths are in bytes. */
+TEST_F(mraa_spi_h_unit, test_write_buf_word_pooled)
+{
+    uint16_t tx[2] = { 0x0102, 0x0304 };
+
+    ASSERT_TRUE(mraa_spi_write_buf_word_pooled(NULL, tx, 4) == NULL);
+    ASSERT_TRUE(mraa_spi_write_buf_word_pooled(dev, tx, 3) == NULL);
+
+    uint8_t btx[8] = { 0 };
+    uint8_t* brx = mraa_spi_write_buf_pooled(dev, btx, 8);
+    ASSERT_TRUE(brx != NULL);
+    uint16_t* rx = mraa_spi_write_buf_word_pooled(dev, tx, 4);
+    ASSERT_EQ((void*) brx, (void*) rx);
+    ASSERT_EQ(0x0102 ^ MOCK_SPI_REPLY_DATA_MODIFIER_WORD, rx[0]);
+    ASSERT_EQ(0x0304 ^ MOCK_SPI_REPLY_DATA_MODIFIER_WORD, rx[1]);
+}
+
+/* A stream several chunks long, with a short last chunk. */
+TEST_F(mraa_spi_h_unit, test_transfer_stream)
+{
+    const size_t length = 3 * MRAA_SPI_STREAM_DEFAULT_CHUNK + 100;
+    uint8_t* tx = new uint8_t[length];
+    uint8_t* rx = new uint8_t[length];
+    for (size_t i = 0; i < length; i++) {
+        tx[i] = (uint8_t) i;
+    }
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_spi_transfer_stream(NULL, tx, rx, length, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_transfer_stream(dev, NULL, rx, length, 1));
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_transfer_stream(dev, tx, rx, 0, 1));
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_transfer_stream(dev, tx, rx, length, 1));
+    for (size_t i = 0; i < length; i++) {
+        ASSERT_EQ(tx[i] ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, rx[i]);
+    }
+
+    delete[] tx;
+    delete[] rx;
+}
+
+struct stream_fill {
+    size_t next;
+    size_t fail_at;
+};
+
+static mraa_result_t
+fill_chunk(void* args, uint8_t* chunk, size_t offset, size_t length)
+{
+    struct stream_fill* f = (struct stream_fill*) args;
+    if (offset != f->next || offset == f->fail_at) {
+        return MRAA_ERROR_UNSPECIFIED;
+    }
+    memset(chunk, (int) offset, length);
+    f->next = offset + length;
+    return MRAA_SUCCESS;
+}
+
+/* Chunks are filled in order while the previous one is sent; a fill error stops the stream. */
+TEST_F(mraa_spi_h_unit, test_write_stream)
+{
+    const size_t length = 5 * MRAA_SPI_STREAM_DEFAULT_CHUNK + 1;
+    struct stream_fill f = { 0, (size_t) -1 };
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_PARAMETER, mraa_spi_write_stream(dev, length, NULL, &f, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_write_stream(dev, length, fill_chunk, &f, 1));
+    ASSERT_EQ(length, f.next);
+
+    f.next = 0;
+    f.fail_at = 2 * MRAA_SPI_STREAM_DEFAULT_CHUNK;
+    ASSERT_EQ(MRAA_ERROR_UNSPECIFIED, mraa_spi_write_stream(dev, length, fill_chunk, &f, 1));
+    ASSERT_EQ(f.fail_at, f.next);
+}
+
+/* The transfers run on the calling thread, a stream inside a held section doesn't deadlock. */
+TEST_F(mraa_spi_h_unit, test_write_stream_held)
+{
+    const size_t length = 3 * MRAA_SPI_STREAM_DEFAULT_CHUNK;
+    struct stream_fill f = { 0, (size_t) -1 };
+    mraa_bus_stats_t before, after;
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_bus_stats(dev, &before));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_bus_acquire(dev));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_mode(dev, MRAA_SPI_MODE3));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_write_stream(dev, length, fill_chunk, &f, 1));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_bus_release(dev));
+    ASSERT_EQ(length, f.next);
+
+    /* The stream was part of the held section, a single grant. */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_bus_stats(dev, &after));
+    ASSERT_EQ(before.transfers[MRAA_BUS_PRIORITY_NORMAL] + 1, after.transfers[MRAA_BUS_PRIORITY_NORMAL]);
+}
+
+/* The mock platform replaces every spidev ioctl, nothing is counted. */
+TEST_F(mraa_spi_h_unit, test_ioctl_stats)
+{
+    mraa_bus_ioctl_stats_t stats;
+
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_spi_ioctl_stats(NULL, &stats));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_spi_ioctl_stats(dev, NULL));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_mode(dev, MRAA_SPI_MODE3));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_frequency(dev, 1000000));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_frequency(dev, 1000000));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ioctl_stats(dev, &stats));
+    ASSERT_EQ(0u, stats.issued);
+    ASSERT_EQ(0u, stats.avoided);
+}
+
+TEST_F(mraa_spi_h_unit, test_ring_invalid)
+{
+    uint8_t block[4];
+
+    ASSERT_TRUE(mraa_spi_ring_start(NULL, NULL, 4, 8, 0, 0) == NULL);
+    ASSERT_TRUE(mraa_spi_ring_start(dev, NULL, 0, 8, 0, 0) == NULL);
+    ASSERT_TRUE(mraa_spi_ring_start(dev, NULL, 4, 1, 0, 0) == NULL);
+    ASSERT_TRUE(mraa_spi_ring_start(dev, NULL, 4, MRAA_SPI_RING_MAX_BLOCKS + 1, 0, 0) == NULL);
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_spi_ring_read(NULL, block, NULL, 0));
+    ASSERT_EQ(MRAA_ERROR_INVALID_HANDLE, mraa_spi_ring_stop(NULL));
+}
+
+/* Sampling every 200 us, read as fast as the blocks come. */
+TEST_F(mraa_spi_h_unit, test_ring)
+{
+    uint8_t tx[4] = { 0x01, 0x02, 0x03, 0x04 };
+    uint8_t block[4];
+    mraa_spi_block_info_t info;
+    mraa_spi_block_info_t last;
+
+    mraa_spi_ring_context ring = mraa_spi_ring_start(dev, tx, 4, 16, 200, 0);
+    ASSERT_TRUE(ring != NULL);
+
+    for (int i = 0; i < 50; i++) {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_read(ring, block, &info, 1000));
+        ASSERT_EQ(0x04 ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, block[3]);
+        if (i > 0) {
+            ASSERT_EQ(last.sequence + 1 + info.overruns, info.sequence);
+            ASSERT_GT(info.timestamp_ns, last.timestamp_ns);
+        }
+        last = info;
+    }
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_stop(ring));
+}
+
+/*
+ * Transfers of the mock device wait at a gate, the test lets them through
+ * one by one and counts the ones which entered and completed
+ */
+static std::mutex gate_lock;
+static std::condition_variable gate_cond;
+static bool gate_open;
+static unsigned int gate_granted, gate_entered, gate_done;
+static std::chrono::steady_clock::time_point gate_entered_at;
+static mraa_result_t (*gate_next)(mraa_spi_context, uint8_t*, uint8_t*, int);
+
+static mraa_result_t
+gated_transfer_buf(mraa_spi_context ctx, uint8_t* data, uint8_t* rxbuf, int length)
+{
+    {
+        std::unique_lock<std::mutex> lock(gate_lock);
+        gate_entered++;
+        gate_entered_at = std::chrono::steady_clock::now();
+        gate_cond.notify_all();
+        gate_cond.wait_for(lock, std::chrono::seconds(10), [] { return gate_open || gate_granted > 0; });
+        if (!gate_open && gate_granted > 0) {
+            gate_granted--;
+        }
+    }
+    mraa_result_t ret = gate_next(ctx, data, rxbuf, length);
+    std::lock_guard<std::mutex> lock(gate_lock);
+    gate_done++;
+    gate_cond.notify_all();
+    return ret;
+}
+
+/* Rings on a context whose transfers go through the gate, closed at first. */
+class mraa_spi_h_ring_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_init());
+        {
+            std::lock_guard<std::mutex> lock(gate_lock);
+            gate_open = false;
+            gate_granted = gate_entered = gate_done = 0;
+        }
+        mraa_adv_func_t* saved = plat->adv_func;
+        funcs = *saved;
+        gate_next = saved->spi_transfer_buf_replace;
+        funcs.spi_transfer_buf_replace = &gated_transfer_buf;
+        plat->adv_func = &funcs;
+        dev = mraa_spi_init(0);
+        plat->adv_func = saved;
+        ASSERT_TRUE(dev != NULL);
+    }
+
+    void
+    TearDown()
+    {
+        open();
+        mraa_spi_stop(dev);
+    }
+
+    /* Let n more transfers through. */
+    void
+    grant(unsigned int n)
+    {
+        std::lock_guard<std::mutex> lock(gate_lock);
+        gate_granted += n;
+        gate_cond.notify_all();
+    }
+
+    void
+    open()
+    {
+        std::lock_guard<std::mutex> lock(gate_lock);
+        gate_open = true;
+        gate_cond.notify_all();
+    }
+
+    bool
+    wait_done(unsigned int n)
+    {
+        std::unique_lock<std::mutex> lock(gate_lock);
+        return gate_cond.wait_for(lock, std::chrono::seconds(10), [n] { return gate_done >= n; });
+    }
+
+    bool
+    wait_entered(unsigned int n)
+    {
+        std::unique_lock<std::mutex> lock(gate_lock);
+        return gate_cond.wait_for(lock, std::chrono::seconds(10), [n] { return gate_entered >= n; });
+    }
+
+    mraa_spi_context dev;
+    mraa_adv_func_t funcs;
+};
+
+/* A reader falling behind finds the dropped blocks in overruns. */
+TEST_F(mraa_spi_h_ring_unit, test_ring_overrun)
+{
+    uint8_t block[4];
+    mraa_spi_block_info_t info;
+
+    mraa_spi_ring_context ring = mraa_spi_ring_start(dev, NULL, 4, 4, 100, 0);
+    ASSERT_TRUE(ring != NULL);
+
+    /* Four blocks fill the ring, the next two are sampled and dropped. */
+    grant(6);
+    ASSERT_TRUE(wait_done(6));
+
+    /* Periods the thread was too late for may show up as overruns too */
+    uint64_t sequence = 0;
+    for (unsigned int i = 0; i < 4; i++) {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_read(ring, block, &info, 0));
+        ASSERT_EQ(sequence + info.overruns, info.sequence);
+        sequence = info.sequence + 1;
+    }
+    ASSERT_EQ(MRAA_ERROR_NO_DATA_AVAILABLE, mraa_spi_ring_read(ring, block, &info, 0));
+
+    /* The next transfer may have seen the ring full before the reads and be dropped too. */
+    grant(2);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_read(ring, block, &info, 10000));
+    ASSERT_GE(info.overruns, 2u);
+    ASSERT_EQ(sequence + info.overruns, info.sequence);
+
+    open();
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_stop(ring));
+}
+
+/* A transfer held up past its period skips the missed periods instead of catching up. */
+TEST_F(mraa_spi_h_ring_unit, test_ring_late)
+{
+    const unsigned int period_us = 2000;
+    uint8_t block[4];
+    mraa_spi_block_info_t info;
+    mraa_spi_block_info_t last;
+
+    mraa_spi_ring_context ring = mraa_spi_ring_start(dev, NULL, 4, 64, period_us, 0);
+    ASSERT_TRUE(ring != NULL);
+    grant(1);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_read(ring, block, &last, 10000));
+
+    /* The second transfer is held until ten periods after it started. */
+    ASSERT_TRUE(wait_entered(2));
+    std::chrono::steady_clock::time_point held;
+    {
+        std::lock_guard<std::mutex> lock(gate_lock);
+        held = gate_entered_at;
+    }
+    std::this_thread::sleep_until(held + std::chrono::microseconds(10 * period_us));
+    grant(2);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_read(ring, block, &info, 10000));
+    ASSERT_EQ(last.sequence + 1 + info.overruns, info.sequence);
+    last = info;
+    /* Without skipping, the late periods would have been sampled back to back */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_read(ring, block, &info, 10000));
+    ASSERT_GE(info.overruns, 9u);
+    ASSERT_EQ(last.sequence + 1 + info.overruns, info.sequence);
+
+    open();
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_stop(ring));
+}
+
+/* Nothing to read before the first transfer completes. */
+TEST_F(mraa_spi_h_ring_unit, test_ring_timeout)
+{
+    uint8_t block[4];
+
+    mraa_spi_ring_context ring = mraa_spi_ring_start(dev, NULL, 4, 4, 50, 0);
+    ASSERT_TRUE(ring != NULL);
+    ASSERT_TRUE(wait_entered(1));
+    ASSERT_EQ(MRAA_ERROR_NO_DATA_AVAILABLE, mraa_spi_ring_read(ring, block, NULL, 0));
+    ASSERT_EQ(MRAA_ERROR_NO_DATA_AVAILABLE, mraa_spi_ring_read(ring, block, NULL, 10));
+    open();
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ring_stop(ring));
+}
+
+/*
+ * A fake /dev/spidev0.0. open(), close() and ioctl() made by libmraa resolve
+ * to the definitions below, which serve the device's fds and pass everything
+ * else on to libc. The device keeps its settings like the kernel does, per
+ * device node and not per fd.
+ */
+struct spidev_message {
+    uint8_t mode;
+    uint8_t lsb;
+    uint32_t speed_hz;
+};
+
+static std::mutex spidev_lock;
+static bool spidev_open = false;
+static std::set<int> spidev_fds;
+static std::vector<unsigned long> spidev_ioctls;
+static std::vector<spidev_message> spidev_messages;
+static uint8_t spidev_mode = 0;
+static uint8_t spidev_lsb = 0;
+static uint8_t spidev_bpw = 8;
+static uint32_t spidev_speed = 500000;
+
+static unsigned int
+spidev_count(unsigned long request)
+{
+    std::lock_guard<std::mutex> lock(spidev_lock);
+    unsigned int count = 0;
+    for (unsigned long r : spidev_ioctls) {
+        count += r == request;
+    }
+    return count;
+}
+
+extern "C" int
+open(const char* path, int flags, ...)
+{
+    static int (*next)(const char*, int, ...) = (int (*)(const char*, int, ...)) dlsym(RTLD_NEXT, "open");
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+    std::lock_guard<std::mutex> lock(spidev_lock);
+    if (spidev_open && strcmp(path, "/dev/spidev0.0") == 0) {
+        int fd = next("/dev/null", O_RDWR);
+        if (fd >= 0) {
+            spidev_fds.insert(fd);
+        }
+        return fd;
+    }
+    return next(path, flags, mode);
+}
+
+extern "C" int
+close(int fd)
+{
+    static int (*next)(int) = (int (*)(int)) dlsym(RTLD_NEXT, "close");
+    {
+        std::lock_guard<std::mutex> lock(spidev_lock);
+        spidev_fds.erase(fd);
+    }
+    return next(fd);
+}
+
+extern "C" int
+ioctl(int fd, unsigned long request, ...) noexcept
+{
+    static int (*next)(int, unsigned long, ...) = (int (*)(int, unsigned long, ...)) dlsym(RTLD_NEXT, "ioctl");
+    va_list ap;
+    va_start(ap, request);
+    void* arg = va_arg(ap, void*);
+    va_end(ap);
+
+    std::lock_guard<std::mutex> lock(spidev_lock);
+    if (spidev_fds.count(fd) == 0) {
+        return next(fd, request, arg);
+    }
+    spidev_ioctls.push_back(request);
+    switch (request) {
+        case SPI_IOC_RD_MAX_SPEED_HZ:
+            *(uint32_t*) arg = spidev_speed;
+            return 0;
+        case SPI_IOC_WR_MAX_SPEED_HZ:
+            spidev_speed = *(uint32_t*) arg;
+            return 0;
+        case SPI_IOC_WR_MODE:
+            spidev_mode = *(uint8_t*) arg;
+            return 0;
+        case SPI_IOC_WR_LSB_FIRST:
+            spidev_lsb = *(uint8_t*) arg;
+            return 0;
+        case SPI_IOC_WR_BITS_PER_WORD:
+            spidev_bpw = *(uint8_t*) arg;
+            return 0;
+    }
+    if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0) {
+        struct spi_ioc_transfer* msg = (struct spi_ioc_transfer*) arg;
+        unsigned int count = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+        for (unsigned int i = 0; i < count; i++) {
+            const uint8_t* tx = (const uint8_t*) (uintptr_t) msg[i].tx_buf;
+            uint8_t* rx = (uint8_t*) (uintptr_t) msg[i].rx_buf;
+            for (unsigned int j = 0; rx != NULL && j < msg[i].len; j++) {
+                rx[j] = (tx != NULL ? tx[j] : 0) ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE;
+            }
+            spidev_messages.push_back({ spidev_mode, spidev_lsb, msg[i].speed_hz });
+        }
+        return (int) count;
+    }
+    errno = ENOTTY;
+    return -1;
+}
+
+/* Contexts of the mock bus opened without its spi functions, on the fake spidev */
+class mraa_spi_h_spidev_unit : public ::testing::Test
+{
+  protected:
+    void
+    SetUp()
+    {
+        ASSERT_EQ(MRAA_SUCCESS, mraa_init());
+        saved = plat->adv_func;
+        funcs = *saved;
+        funcs.spi_init_pre = NULL;
+        funcs.spi_init_post = NULL;
+        funcs.spi_init_raw_replace = NULL;
+        funcs.spi_stop_replace = NULL;
+        funcs.spi_bit_per_word_replace = NULL;
+        funcs.spi_lsbmode_replace = NULL;
+        funcs.spi_mode_replace = NULL;
+        funcs.spi_frequency_replace = NULL;
+        funcs.spi_write_replace = NULL;
+        funcs.spi_write_word_replace = NULL;
+        funcs.spi_transfer_buf_replace = NULL;
+        funcs.spi_transfer_buf_word_replace = NULL;
+        plat->adv_func = &funcs;
+
+        std::lock_guard<std::mutex> lock(spidev_lock);
+        spidev_open = true;
+        spidev_ioctls.clear();
+        spidev_messages.clear();
+        spidev_mode = 0;
+        spidev_lsb = 0;
+        spidev_bpw = 8;
+        spidev_speed = 500000;
+    }
+
+    void
+    TearDown()
+    {
+        std::lock_guard<std::mutex> lock(spidev_lock);
+        spidev_open = false;
+        plat->adv_func = saved;
+    }
+
+    mraa_adv_func_t* saved;
+    mraa_adv_func_t funcs;
+};
+
+/* Two contexts of one chip select share the device's settings and restore their own mode lazily. */
+TEST_F(mraa_spi_h_spidev_unit, test_ioctl_stats)
+{
+    mraa_bus_ioctl_stats_t stats;
+    uint8_t tx[2] = { 0x01, 0x02 };
+    uint8_t rx[2];
+
+    /* The first context sets up the device */
+    mraa_spi_context a = mraa_spi_init(0);
+    ASSERT_TRUE(a != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ioctl_stats(a, &stats));
+    ASSERT_EQ(4u, stats.issued);
+    ASSERT_EQ(0u, stats.avoided);
+
+    /* The second one finds mode, bit order and word size already set */
+    mraa_spi_context b = mraa_spi_init(0);
+    ASSERT_TRUE(b != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ioctl_stats(b, &stats));
+    ASSERT_EQ(1u, stats.issued);
+    ASSERT_EQ(3u, stats.avoided);
+    ASSERT_EQ(1u, spidev_count(SPI_IOC_WR_MODE));
+    ASSERT_EQ(1u, spidev_count(SPI_IOC_WR_BITS_PER_WORD));
+
+    /* a switches the device to mode 3, b's transfers put mode 0 back once */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_mode(a, MRAA_SPI_MODE3));
+    ASSERT_EQ(SPI_MODE_3, spidev_mode);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_transfer_buf(b, tx, rx, 2));
+    ASSERT_EQ(0x02 ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, rx[1]);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_transfer_buf(b, tx, rx, 2));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_transfer_buf(a, tx, rx, 2));
+    ASSERT_EQ(4u, spidev_count(SPI_IOC_WR_MODE));
+    ASSERT_EQ(3u, spidev_messages.size());
+    ASSERT_EQ(SPI_MODE_0, spidev_messages[0].mode);
+    ASSERT_EQ(SPI_MODE_0, spidev_messages[1].mode);
+    ASSERT_EQ(SPI_MODE_3, spidev_messages[2].mode);
+
+    /* The clock goes in the transfers, a speed the device took needs no ioctl */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_frequency(a, 1000000));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_frequency(b, 1000000));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_frequency(b, 1000000));
+    ASSERT_EQ(1u, spidev_count(SPI_IOC_WR_MAX_SPEED_HZ));
+
+    /* Bit order is restored lazily like the mode */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_lsbmode(a, 1));
+    ASSERT_EQ(0x55 ^ MOCK_SPI_REPLY_DATA_MODIFIER_BYTE, mraa_spi_write(b, 0x55));
+    ASSERT_EQ(4u, spidev_messages.size());
+    ASSERT_EQ(0, spidev_messages[3].lsb);
+    ASSERT_EQ(SPI_MODE_0, spidev_messages[3].mode);
+    ASSERT_EQ(1000000u, spidev_messages[3].speed_hz);
+
+    /* a: 4 at init, mode, 2 for its transfer, clock, bit order */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ioctl_stats(a, &stats));
+    ASSERT_EQ(9u, stats.issued);
+    ASSERT_EQ(0u, stats.avoided);
+    /* b: 1 at init, its mode and 2 transfers, then mode, bit order and the write */
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ioctl_stats(b, &stats));
+    ASSERT_EQ(7u, stats.issued);
+    ASSERT_EQ(5u, stats.avoided);
+
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_stop(a));
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_stop(b));
+
+    /* The shared record went with the last context, a new one sets the device up again */
+    mraa_spi_context c = mraa_spi_init(0);
+    ASSERT_TRUE(c != NULL);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_ioctl_stats(c, &stats));
+    ASSERT_EQ(4u, stats.issued);
+    ASSERT_EQ(MRAA_SUCCESS, mraa_spi_stop(c));
+}
+
+static int init_post_calls = 0;
+
+static mraa_result_t
+failing_init_post(mraa_spi_context dev)
+{
+    init_post_calls++;
+    return MRAA_ERROR_UNSPECIFIED;
+}
+
+/* A failed open skips the post init hook, a failed hook closes the device again. */
+TEST_F(mraa_spi_h_spidev_unit, test_init_post_failure)
+{
+    funcs.spi_init_post = &failing_init_post;
+    init_post_calls = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(spidev_lock);
+        spidev_open = false;
+    }
+    ASSERT_TRUE(mraa_spi_init(0) == NULL);
+    ASSERT_EQ(0, init_post_calls);
+
+    {
+        std::lock_guard<std::mutex> lock(spidev_lock);
+        spidev_open = true;
+    }
+    ASSERT_TRUE(mraa_spi_init(0) == NULL);
+    ASSERT_EQ(1, init_post_calls);
+    std::lock_guard<std::mutex> lock(spidev_lock);
+    ASSERT_TRUE(spidev_fds.empty());
+}
@@ -30,6 +30,7 @@ print_help()
     fprintf(stdout, "version                   Get mraa version and board name\n");
     fprintf(stdout, "list                      List available busses\n");
     fprintf(stdout, "detect bus                List detected devices on specified bus\n");
+    fprintf(stdout, "detectall                 List detected devices on all busses\n");
     fprintf(stdout, "get bus device reg        Get value from specified device register\n");
     fprintf(stdout, "set bus device reg value  Set specified device register to value\n");
 }
@@ -124,25 +125,59 @@ i2c_set_exit:
     return status;
 }
 
+/* Per probe timeout, some buses stretch the clock forever when nothing is connected. */
+#define I2C_SCAN_TIMEOUT_MS 1000
+
 void
-i2c_detect_devices(int bus)
+print_scan_result(const mraa_i2c_scan_result_t* result)
 {
-    mraa_i2c_context i2c = mraa_i2c_init(bus);
-    if (i2c == NULL) {
-        return;
-    }
     int addr;
     for (addr = 0x0; addr < 0x80; ++addr) {
-        uint8_t value;
         if ((addr) % 16 == 0)
             printf("%02x: ", addr);
-        if (i2c_get(bus, addr, 0, &value) == MRAA_SUCCESS)
-            printf("%02x ", addr);
-        else
-            printf("-- ");
+        switch (result->state[addr]) {
+            case MRAA_I2C_SCAN_PRESENT:
+                printf("%02x ", addr);
+                break;
+            case MRAA_I2C_SCAN_BUSY:
+                printf("UU ");
+                break;
+            case MRAA_I2C_SCAN_SKIPPED:
+                printf("   ");
+                break;
+            default:
+                printf("-- ");
+                break;
+        }
         if ((addr + 1) % 16 == 0)
             printf("\n");
     }
+    if (result->status != MRAA_SUCCESS)
+        printf("Scan of bus %d did not complete\n", result->bus);
+}
+
+void
+i2c_detect_devices(int bus)
+{
+    mraa_i2c_scan_result_t result;
+    if (mraa_i2c_scan(bus, I2C_SCAN_TIMEOUT_MS, &result) == MRAA_ERROR_INVALID_RESOURCE) {
+        return;
+    }
+    print_scan_result(&result);
+}
+
+void
+i2c_detect_all_devices()
+{
+    mraa_i2c_scan_result_t results[2 * MAX_I2C_BUS_COUNT];
+    int i, count = mraa_i2c_scan_all(I2C_SCAN_TIMEOUT_MS, results, 2 * MAX_I2C_BUS_COUNT);
+    for (i = 0; i < count; ++i) {
+        printf("Bus %d:\n", results[i].bus);
+        if (results[i].status == MRAA_ERROR_INVALID_RESOURCE)
+            printf("Could not open bus\n");
+        else
+            print_scan_result(&results[i]);
+    }
 }
 
 int
@@ -167,6 +202,9 @@ process_command(int argc, char** argv)
             print_command_error();
             return 1;
         }
+    } else if (strncmp(argv[1], "detectall", strlen("detectall") + 1) == 0) {
+        i2c_detect_all_devices();
+        return 0;
     } else if ((strncmp(argv[1], "get", strlen("get") + 1) == 0) ||
                (strncmp(argv[1], "getrpt", strlen("getrpt") + 1) == 0)) {
         if (argc == 5) {